@@ -0,0 +1,251 @@
+/*
+ *  batched.h
+ *  Created by Matthias Kesenheimer on 19.06.22.
+ *  Copyright 2022. All rights reserved.
+ *  More information about the Eigen library at http://eigen.tuxfamily.org/dox/index.html
+ */
+
+#pragma once
+#include "parallel.h"
+#include <Eigen/Dense>
+#include <type_traits>
+#include <algorithm>
+
+// Batched matrix-vector (gemv) and matrix-matrix (gemm) products for many small independent problems.
+// All functions write into outputs owned by the caller, no memory is allocated if the outputs have the right size.
+// A batch is given by a pointer to the first element and the number of elements (like a span):
+//     std::vector<math::matrix<double, 3, 3>> A(n); std::vector<math::vector<double, 3>> x(n), y(n);
+//     math::eigen::gemv_batched(math::execution::par, A.data(), x.data(), y.data(), n);
+// Strided batches (one array, the problems are 'stride' elements apart):
+//     math::eigen::gemv_strided_batched<3, 3>(math::execution::par, A, 9, x, 3, y, 3, n);
+// Interleaved batches (element e of problem b is stored at e * count + b) are evaluated with SIMD instructions
+// across the batch, which is the fastest layout for very small problems:
+//     math::eigen::interleave(A.data(), n, Ai); math::eigen::interleave(x.data(), n, xi);
+//     math::eigen::gemv_interleaved(math::execution::par, 3, 3, Ai, xi, yi, n);
+//     math::eigen::deinterleave(yi, n, y.data());
+
+namespace math {
+    namespace detail {
+        /// <summary>
+        /// call fn(first, last) for consecutive ranges of the batch [0, count)
+        /// 'work' = approximate number of operations per problem, small batches are evaluated by the calling thread
+        /// 'granularity' = the ranges (except the last one) are a multiple of 'granularity' problems
+        /// </summary>
+        template <class _Policy, class _Fn>
+        inline void for_each_batch(const _Policy& policy, size_t count, size_t work, _Fn&& fn, size_t granularity = 1) {
+            if constexpr (std::is_same<_Policy, execution::parallel_policy>::value) {
+                thread_pool& pool = policy.threads();
+                if (pool.size() > 1 && count > granularity && count * work >= MATH_PARALLEL_MIN_SIZE) {
+                    size_t chunk = (count + 4 * pool.size() - 1) / (4 * pool.size());
+                    chunk = std::max<size_t>(1, (chunk + granularity - 1) / granularity) * granularity;
+                    pool.parallel_for((count + chunk - 1) / chunk, [&](size_t i) {
+                        fn(i * chunk, std::min(count, (i + 1) * chunk));
+                    });
+                    return;
+                }
+            }
+            fn(size_t(0), count);
+        }
+
+        /// <summary>
+        /// batch ranges of interleaved data start at cache line boundaries (if the arrays are aligned)
+        /// </summary>
+        template <class _T>
+        constexpr size_t interleaved_granularity() {
+            return std::max<size_t>(1, MATH_CACHE_LINE_SIZE / sizeof(_T));
+        }
+    }
+
+    namespace eigen {
+        /// <summary>
+        /// batched matrix-vector multiplication: y[i] = A[i] * x[i], i = 0 ... count - 1
+        /// dynamic-size outputs are resized only if they do not have the right size
+        /// </summary>
+        template <class _Policy, class _T, int _R, int _C, int _L>
+        inline void gemv_batched(const _Policy& policy, const matrix<_T, _R, _C, _L>* A, const vector<_T, _C>* x, vector<_T, _R>* y, size_t count) {
+            size_t work = count > 0 ? static_cast<size_t>(A[0].size()) : 0;
+            detail::for_each_batch(policy, count, work, [&](size_t first, size_t last) {
+                for (size_t i = first; i < last; ++i) {
+                    if constexpr (_R == Eigen::Dynamic)
+                        if (y[i].size() != static_cast<size_t>(A[i].rows()))
+                            y[i].resize(A[i].rows());
+                    y[i].eigen().noalias() = A[i].eigen() * x[i].eigen();
+                }
+            });
+        }
+
+        /// <summary>
+        /// batched matrix-matrix multiplication: C[i] = A[i] * B[i], i = 0 ... count - 1
+        /// dynamic-size outputs are resized only if they do not have the right size
+        /// </summary>
+        template <class _Policy, class _T, int _R, int _K, int _C, int _L1, int _L2, int _L3>
+        inline void gemm_batched(const _Policy& policy, const matrix<_T, _R, _K, _L1>* A, const matrix<_T, _K, _C, _L2>* B, matrix<_T, _R, _C, _L3>* C, size_t count) {
+            size_t work = count > 0 ? static_cast<size_t>(A[0].rows() * B[0].size()) : 0;
+            detail::for_each_batch(policy, count, work, [&](size_t first, size_t last) {
+                for (size_t i = first; i < last; ++i) {
+                    if constexpr (_R == Eigen::Dynamic || _C == Eigen::Dynamic)
+                        if (C[i].rows() != static_cast<size_t>(A[i].rows()) || C[i].cols() != static_cast<size_t>(B[i].cols()))
+                            C[i].resize(A[i].rows(), B[i].cols());
+                    C[i].eigen().noalias() = A[i].eigen() * B[i].eigen();
+                }
+            });
+        }
+
+        /// <summary>
+        /// strided batched matrix-vector multiplication with sizes known at compile time:
+        /// y + i * strideY = (A + i * strideA) * (x + i * strideX), the _Rows x _Cols matrices are stored row by row
+        /// </summary>
+        template <int _Rows, int _Cols, class _Policy, class _T>
+        inline void gemv_strided_batched(const _Policy& policy, const _T* A, size_t strideA, const _T* x, size_t strideX, _T* y, size_t strideY, size_t count) {
+            using matrix_type = Eigen::Matrix<_T, _Rows, _Cols, (_Cols == 1 && _Rows != 1) ? Eigen::ColMajor : Eigen::RowMajor>;
+            using x_type = Eigen::Matrix<_T, _Cols, 1>;
+            using y_type = Eigen::Matrix<_T, _Rows, 1>;
+            detail::for_each_batch(policy, count, _Rows * _Cols, [&](size_t first, size_t last) {
+                for (size_t i = first; i < last; ++i)
+                    Eigen::Map<y_type>(y + i * strideY).noalias() =
+                        Eigen::Map<const matrix_type>(A + i * strideA) * Eigen::Map<const x_type>(x + i * strideX);
+            });
+        }
+
+        /// <summary>
+        /// strided batched matrix-vector multiplication:
+        /// y + i * strideY = (A + i * strideA) * (x + i * strideX), the rows x cols matrices are stored row by row
+        /// </summary>
+        template <class _Policy, class _T>
+        inline void gemv_strided_batched(const _Policy& policy, size_t rows, size_t cols, const _T* A, size_t strideA, const _T* x, size_t strideX, _T* y, size_t strideY, size_t count) {
+            using matrix_type = Eigen::Matrix<_T, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+            using vector_type = Eigen::Matrix<_T, Eigen::Dynamic, 1>;
+            detail::for_each_batch(policy, count, rows * cols, [&](size_t first, size_t last) {
+                for (size_t i = first; i < last; ++i)
+                    Eigen::Map<vector_type>(y + i * strideY, rows).noalias() =
+                        Eigen::Map<const matrix_type>(A + i * strideA, rows, cols) * Eigen::Map<const vector_type>(x + i * strideX, cols);
+            });
+        }
+
+        /// <summary>
+        /// strided batched matrix-matrix multiplication with sizes known at compile time:
+        /// C + i * strideC = (A + i * strideA) * (B + i * strideB), A is _M x _K, B is _K x _N, all stored row by row
+        /// </summary>
+        template <int _M, int _N, int _K, class _Policy, class _T>
+        inline void gemm_strided_batched(const _Policy& policy, const _T* A, size_t strideA, const _T* B, size_t strideB, _T* C, size_t strideC, size_t count) {
+            using a_type = Eigen::Matrix<_T, _M, _K, (_K == 1 && _M != 1) ? Eigen::ColMajor : Eigen::RowMajor>;
+            using b_type = Eigen::Matrix<_T, _K, _N, (_N == 1 && _K != 1) ? Eigen::ColMajor : Eigen::RowMajor>;
+            using c_type = Eigen::Matrix<_T, _M, _N, (_N == 1 && _M != 1) ? Eigen::ColMajor : Eigen::RowMajor>;
+            detail::for_each_batch(policy, count, _M * _N * _K, [&](size_t first, size_t last) {
+                for (size_t i = first; i < last; ++i)
+                    Eigen::Map<c_type>(C + i * strideC).noalias() =
+                        Eigen::Map<const a_type>(A + i * strideA) * Eigen::Map<const b_type>(B + i * strideB);
+            });
+        }
+
+        /// <summary>
+        /// strided batched matrix-matrix multiplication:
+        /// C + i * strideC = (A + i * strideA) * (B + i * strideB), A is m x k, B is k x n, all stored row by row
+        /// </summary>
+        template <class _Policy, class _T>
+        inline void gemm_strided_batched(const _Policy& policy, size_t m, size_t n, size_t k, const _T* A, size_t strideA, const _T* B, size_t strideB, _T* C, size_t strideC, size_t count) {
+            using matrix_type = Eigen::Matrix<_T, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+            detail::for_each_batch(policy, count, m * n * k, [&](size_t first, size_t last) {
+                for (size_t i = first; i < last; ++i)
+                    Eigen::Map<matrix_type>(C + i * strideC, m, n).noalias() =
+                        Eigen::Map<const matrix_type>(A + i * strideA, m, k) * Eigen::Map<const matrix_type>(B + i * strideB, k, n);
+            });
+        }
+
+        /// <summary>
+        /// interleaved batched matrix-vector multiplication, vectorized across the batch:
+        /// y_i = A_i * x_i, element e of problem b is stored at e * count + b
+        /// (A_i: rows x cols, row by row, i.e. A_i(r, c) = A[(r * cols + c) * count + i])
+        /// </summary>
+        template <class _Policy, class _T>
+        inline void gemv_interleaved(const _Policy& policy, size_t rows, size_t cols, const _T* A, const _T* x, _T* y, size_t count) {
+            using array_type = Eigen::Array<_T, Eigen::Dynamic, 1>;
+            detail::for_each_batch(policy, count, rows * cols, [&](size_t first, size_t last) {
+                const Eigen::Index n = last - first;
+                for (size_t r = 0; r < rows; ++r) {
+                    Eigen::Map<array_type> yr(y + r * count + first, n);
+                    yr = Eigen::Map<const array_type>(A + r * cols * count + first, n) * Eigen::Map<const array_type>(x + first, n);
+                    for (size_t c = 1; c < cols; ++c)
+                        yr += Eigen::Map<const array_type>(A + (r * cols + c) * count + first, n) * Eigen::Map<const array_type>(x + c * count + first, n);
+                }
+            }, detail::interleaved_granularity<_T>());
+        }
+
+        /// <summary>
+        /// interleaved batched matrix-matrix multiplication, vectorized across the batch:
+        /// C_i = A_i * B_i, A_i is m x k, B_i is k x n, all stored row by row and interleaved (see gemv_interleaved)
+        /// </summary>
+        template <class _Policy, class _T>
+        inline void gemm_interleaved(const _Policy& policy, size_t m, size_t n, size_t k, const _T* A, const _T* B, _T* C, size_t count) {
+            using array_type = Eigen::Array<_T, Eigen::Dynamic, 1>;
+            detail::for_each_batch(policy, count, m * n * k, [&](size_t first, size_t last) {
+                const Eigen::Index len = last - first;
+                for (size_t r = 0; r < m; ++r) {
+                    for (size_t c = 0; c < n; ++c) {
+                        Eigen::Map<array_type> crc(C + (r * n + c) * count + first, len);
+                        crc = Eigen::Map<const array_type>(A + r * k * count + first, len) * Eigen::Map<const array_type>(B + c * count + first, len);
+                        for (size_t j = 1; j < k; ++j)
+                            crc += Eigen::Map<const array_type>(A + (r * k + j) * count + first, len) * Eigen::Map<const array_type>(B + (j * n + c) * count + first, len);
+                    }
+                }
+            }, detail::interleaved_granularity<_T>());
+        }
+
+        /// <summary>
+        /// interleave a batch of matrices: out[(r * cols + c) * count + b] = mats[b](r, c)
+        /// (the elements are interleaved row by row for both layouts)
+        /// 'out' must hold count * rows * cols elements, all matrices have the same size
+        /// </summary>
+        template <class _T, int _R, int _C, int _L>
+        inline void interleave(const matrix<_T, _R, _C, _L>* mats, size_t count, _T* out) {
+            for (size_t b = 0; b < count; ++b) {
+                const size_t rows = mats[b].rows();
+                const size_t cols = mats[b].cols();
+                for (size_t r = 0; r < rows; ++r)
+                    for (size_t c = 0; c < cols; ++c)
+                        out[(r * cols + c) * count + b] = mats[b](r, c);
+            }
+        }
+
+        /// <summary>
+        /// interleave a batch of vectors: out[e * count + b] = vecs[b][e]
+        /// 'out' must hold count * size elements, all vectors have the same size
+        /// </summary>
+        template <class _T, int _N>
+        inline void interleave(const vector<_T, _N>* vecs, size_t count, _T* out) {
+            for (size_t b = 0; b < count; ++b) {
+                const _T* data = vecs[b].data();
+                const size_t size = vecs[b].size();
+                for (size_t e = 0; e < size; ++e)
+                    out[e * count + b] = data[e];
+            }
+        }
+
+        /// <summary>
+        /// inverse of interleave, the matrices must have the right size
+        /// </summary>
+        template <class _T, int _R, int _C, int _L>
+        inline void deinterleave(const _T* in, size_t count, matrix<_T, _R, _C, _L>* mats) {
+            for (size_t b = 0; b < count; ++b) {
+                const size_t rows = mats[b].rows();
+                const size_t cols = mats[b].cols();
+                for (size_t r = 0; r < rows; ++r)
+                    for (size_t c = 0; c < cols; ++c)
+                        mats[b](r, c) = in[(r * cols + c) * count + b];
+            }
+        }
+
+        /// <summary>
+        /// inverse of interleave, the vectors must have the right size
+        /// </summary>
+        template <class _T, int _N>
+        inline void deinterleave(const _T* in, size_t count, vector<_T, _N>* vecs) {
+            for (size_t b = 0; b < count; ++b) {
+                _T* data = vecs[b].data();
+                const size_t size = vecs[b].size();
+                for (size_t e = 0; e < size; ++e)
+                    data[e] = in[e * count + b];
+            }
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,80 @@
+/*
+ *  bench.h
+ *  Created by Matthias Kesenheimer on 19.06.22.
+ *  Copyright 2022. All rights reserved.
+ *  More information about the Eigen library at http://eigen.tuxfamily.org/dox/index.html
+ */
+
+#pragma once
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <cstddef>
+
+// largest number of elements of the vector benchmarks
+#ifndef MATH_BENCH_MAX_SIZE
+#define MATH_BENCH_MAX_SIZE 100000000
+#endif
+
+// largest dimension of the O(n^3) matrix benchmarks
+#ifndef MATH_BENCH_MAX_DIM
+#define MATH_BENCH_MAX_DIM 1000
+#endif
+
+namespace bench {
+    /// <summary>
+    /// sizes 3, 10, 100, ..., 'max'
+    /// </summary>
+    inline void sizes_up_to(benchmark::internal::Benchmark* b, int64_t max) {
+        b->Arg(3);
+        for (int64_t n = 10; n <= max; n *= 10)
+            b->Arg(n);
+    }
+
+    /// <summary>
+    /// number of elements of the vector benchmarks: 3 ... MATH_BENCH_MAX_SIZE
+    /// </summary>
+    inline void sizes(benchmark::internal::Benchmark* b) {
+        sizes_up_to(b, MATH_BENCH_MAX_SIZE);
+    }
+
+    /// <summary>
+    /// matrix dimensions of the O(n^2) benchmarks, such that the matrix has at most MATH_BENCH_MAX_SIZE elements
+    /// </summary>
+    inline void dims(benchmark::internal::Benchmark* b) {
+        b->Arg(3);
+        for (int64_t n = 10; n * n <= MATH_BENCH_MAX_SIZE; n *= 10)
+            b->Arg(n);
+    }
+
+    /// <summary>
+    /// matrix dimensions of the O(n^3) benchmarks: 3 ... MATH_BENCH_MAX_DIM
+    /// </summary>
+    inline void cubic_dims(benchmark::internal::Benchmark* b) {
+        sizes_up_to(b, MATH_BENCH_MAX_DIM);
+    }
+
+    /// <summary>
+    /// deterministic, non-trivial test values
+    /// </summary>
+    inline double value(size_t i) {
+        return 1.0 + static_cast<double>(i % 7) * 0.25;
+    }
+
+    /// <summary>
+    /// fill any container (or Eigen expression) with operator[] and 'n' elements
+    /// </summary>
+    template <class _Container>
+    inline void fill(_Container&& c, size_t n) {
+        for (size_t i = 0; i < n; ++i)
+            c[i] = value(i);
+    }
+
+    /// <summary>
+    /// report the processed elements and bytes of 'n' elements per iteration
+    /// </summary>
+    template <class _T>
+    inline void set_processed(benchmark::State& state, int64_t n, int64_t arrays = 1) {
+        state.SetItemsProcessed(state.iterations() * n);
+        state.SetBytesProcessed(state.iterations() * n * arrays * static_cast<int64_t>(sizeof(_T)));
+    }
+}
\ No newline at end of file
@@ -0,0 +1,67 @@
+/*
+ *  bench_batched.cpp
+ *  Created by Matthias Kesenheimer on 19.06.22.
+ *  Copyright 2022. All rights reserved.
+ *  More information about the Eigen library at http://eigen.tuxfamily.org/dox/index.html
+ */
+
+#include "bench.h"
+#include "batched.h"
+#include <vector>
+
+// batched 3x3 matrix-vector products of batched.h, the batch size is the benchmark argument
+
+static void batch_sizes(benchmark::internal::Benchmark* b) {
+    bench::sizes_up_to(b, std::min<int64_t>(MATH_BENCH_MAX_SIZE / 16, 10000000));
+}
+
+template <class _Policy>
+static void BM_gemv_batched(benchmark::State& state, const _Policy& policy) {
+    const size_t n = state.range(0);
+    std::vector<math::matrix<double, 3, 3>> A(n);
+    std::vector<math::vector<double, 3>> x(n), y(n);
+    for (size_t i = 0; i < n; ++i) {
+        bench::fill(A[i].data(), 9);
+        bench::fill(x[i].data(), 3);
+    }
+    for (auto _ : state) {
+        math::eigen::gemv_batched(policy, A.data(), x.data(), y.data(), n);
+        benchmark::DoNotOptimize(y.data());
+        benchmark::ClobberMemory();
+    }
+    bench::set_processed<double>(state, n, 15);
+}
+BENCHMARK_CAPTURE(BM_gemv_batched, seq, math::execution::seq)->Apply(batch_sizes)->UseRealTime();
+BENCHMARK_CAPTURE(BM_gemv_batched, par, math::execution::par)->Apply(batch_sizes)->UseRealTime();
+
+template <class _Policy>
+static void BM_gemv_strided_batched(benchmark::State& state, const _Policy& policy) {
+    const size_t n = state.range(0);
+    std::vector<double> A(9 * n), x(3 * n), y(3 * n);
+    bench::fill(A, A.size());
+    bench::fill(x, x.size());
+    for (auto _ : state) {
+        math::eigen::gemv_strided_batched<3, 3>(policy, A.data(), 9, x.data(), 3, y.data(), 3, n);
+        benchmark::DoNotOptimize(y.data());
+        benchmark::ClobberMemory();
+    }
+    bench::set_processed<double>(state, n, 15);
+}
+BENCHMARK_CAPTURE(BM_gemv_strided_batched, seq, math::execution::seq)->Apply(batch_sizes)->UseRealTime();
+BENCHMARK_CAPTURE(BM_gemv_strided_batched, par, math::execution::par)->Apply(batch_sizes)->UseRealTime();
+
+template <class _Policy>
+static void BM_gemv_interleaved(benchmark::State& state, const _Policy& policy) {
+    const size_t n = state.range(0);
+    std::vector<double> A(9 * n), x(3 * n), y(3 * n);
+    bench::fill(A, A.size());
+    bench::fill(x, x.size());
+    for (auto _ : state) {
+        math::eigen::gemv_interleaved(policy, 3, 3, A.data(), x.data(), y.data(), n);
+        benchmark::DoNotOptimize(y.data());
+        benchmark::ClobberMemory();
+    }
+    bench::set_processed<double>(state, n, 15);
+}
+BENCHMARK_CAPTURE(BM_gemv_interleaved, seq, math::execution::seq)->Apply(batch_sizes)->UseRealTime();
+BENCHMARK_CAPTURE(BM_gemv_interleaved, par, math::execution::par)->Apply(batch_sizes)->UseRealTime();
\ No newline at end of file
@@ -0,0 +1,83 @@
+/*
+ *  bench_device.cpp
+ *  Created by Matthias Kesenheimer on 19.06.22.
+ *  Copyright 2022. All rights reserved.
+ *  More information about the Eigen library at http://eigen.tuxfamily.org/dox/index.html
+ */
+
+#include "bench.h"
+#include "device.h"
+
+// device backend of device.h (cmake -DMATH_BENCH_CUDA=ON), compare with BM_parallel_mat_mul and BM_parallel_mat_vec
+// The operands stay on the device, every iteration waits for the stream.
+
+static void BM_device_mat_mul(benchmark::State& state) {
+    const size_t n = state.range(0);
+    math::matrix<double> a(n, n), b(n, n);
+    for (size_t i = 0; i < n * n; ++i) {
+        a.data()[i] = bench::value(i);
+        b.data()[i] = bench::value(i + 1);
+    }
+    math::device::stream s;
+    math::device::matrix<double> A = math::to_device(a, s), B = math::to_device(b, s), C(n, n, s);
+    for (auto _ : state) {
+        math::eigen::multiply_into(C, A, B);
+        s.synchronize();
+    }
+    bench::set_processed<double>(state, n * n, 3);
+}
+BENCHMARK(BM_device_mat_mul)->Apply(bench::cubic_dims)->UseRealTime();
+
+static void BM_device_mat_vec(benchmark::State& state) {
+    const size_t n = state.range(0);
+    math::matrix<double> a(n, n);
+    math::vector<double> x(n);
+    for (size_t i = 0; i < n * n; ++i)
+        a.data()[i] = bench::value(i);
+    bench::fill(x, n);
+    math::device::stream s;
+    math::device::matrix<double> A = math::to_device(a, s);
+    math::device::vector<double> X = math::to_device(x, s), Y(n, s);
+    for (auto _ : state) {
+        math::eigen::multiply_into(Y, A, X);
+        s.synchronize();
+    }
+    bench::set_processed<double>(state, n * n);
+}
+BENCHMARK(BM_device_mat_vec)->Apply(bench::dims)->UseRealTime();
+
+// round trip: upload, product, download
+static void BM_device_mat_vec_round_trip(benchmark::State& state) {
+    const size_t n = state.range(0);
+    math::matrix<double> a(n, n);
+    math::vector<double> x(n), y(n);
+    for (size_t i = 0; i < n * n; ++i)
+        a.data()[i] = bench::value(i);
+    bench::fill(x, n);
+    math::device::stream s;
+    math::device::matrix<double> A = math::to_device(a, s);
+    math::device::vector<double> X(n, s), Y(n, s);
+    for (auto _ : state) {
+        X.upload(x);
+        math::eigen::multiply_into(Y, A, X);
+        Y.download(y);
+        benchmark::DoNotOptimize(y.data());
+    }
+    bench::set_processed<double>(state, n * n);
+}
+BENCHMARK(BM_device_mat_vec_round_trip)->Apply(bench::dims)->UseRealTime();
+
+static void BM_device_axpy(benchmark::State& state) {
+    const size_t n = state.range(0);
+    math::vector<double> a(n), b(n);
+    bench::fill(a, n);
+    bench::fill(b, n);
+    math::device::stream s;
+    math::device::vector<double> A = math::to_device(a, s), B = math::to_device(b, s);
+    for (auto _ : state) {
+        B.axpy(0.5, A);
+        s.synchronize();
+    }
+    bench::set_processed<double>(state, n, 3);
+}
+BENCHMARK(BM_device_axpy)->Apply(bench::sizes)->UseRealTime();
\ No newline at end of file
@@ -0,0 +1,61 @@
+/*
+ *  bench_format.cpp
+ *  Created by Matthias Kesenheimer on 19.06.22.
+ *  Copyright 2022. All rights reserved.
+ *  More information about the Eigen library at http://eigen.tuxfamily.org/dox/index.html
+ */
+
+#include "bench.h"
+#include "format.h"
+#include "operators.h"
+#include <ostream>
+#include <streambuf>
+
+// text output of a matrix with 100 columns: operator<< (Eigen formatting) against math::write_text,
+// the number of rows is the benchmark argument
+
+namespace {
+    /// <summary>
+    /// stream buffer which discards everything, such that only the formatting is measured
+    /// </summary>
+    class null_buffer : public std::streambuf {
+    protected:
+        std::streamsize xsputn(const char*, std::streamsize n) override {
+            return n;
+        }
+
+        int_type overflow(int_type c) override {
+            return traits_type::not_eof(c);
+        }
+    };
+}
+
+static void row_counts(benchmark::internal::Benchmark* b) {
+    bench::sizes_up_to(b, std::min<int64_t>(MATH_BENCH_MAX_SIZE / 100, 100000));
+}
+
+static math::matrix<double> text_matrix(size_t rows) {
+    math::matrix<double> mat(rows, 100);
+    bench::fill(mat.data(), mat.size());
+    return mat;
+}
+
+static void BM_ostream_matrix(benchmark::State& state) {
+    const math::matrix<double> mat = text_matrix(state.range(0));
+    null_buffer buffer;
+    std::ostream stream(&buffer);
+    for (auto _ : state)
+        stream << mat;
+    bench::set_processed<double>(state, mat.size());
+}
+BENCHMARK(BM_ostream_matrix)->Apply(row_counts);
+
+static void BM_write_text_matrix(benchmark::State& state) {
+    const math::matrix<double> mat = text_matrix(state.range(0));
+    null_buffer buffer;
+    std::ostream stream(&buffer);
+    for (auto _ : state)
+        math::write_text(stream, mat);
+    bench::set_processed<double>(state, mat.size());
+}
+BENCHMARK(BM_write_text_matrix)->Apply(row_counts);
\ No newline at end of file
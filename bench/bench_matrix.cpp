@@ -0,0 +1,132 @@
+/*
+ *  bench_matrix.cpp
+ *  Created by Matthias Kesenheimer on 19.06.22.
+ *  Copyright 2022. All rights reserved.
+ *  More information about the Eigen library at http://eigen.tuxfamily.org/dox/index.html
+ */
+
+#include "bench.h"
+#include "matrix.h"
+#include <vector>
+#include <array>
+
+namespace {
+    // number of columns of the row benchmarks
+    constexpr size_t cols = 3;
+}
+
+// push_back rows, state.range(0) = number of elements (rows * cols)
+
+static void BM_matrix_push_back(benchmark::State& state) {
+    const size_t rows = state.range(0) / cols + 1;
+    const math::vector<double> row{1.0, 2.0, 3.0};
+    for (auto _ : state) {
+        math::matrix<double> m;
+        for (size_t r = 0; r < rows; ++r)
+            m.push_back(row);
+        benchmark::DoNotOptimize(m.data());
+    }
+    bench::set_processed<double>(state, rows * cols);
+}
+BENCHMARK(BM_matrix_push_back)->Apply(bench::sizes);
+
+static void BM_matrix_push_back_reserve_rows(benchmark::State& state) {
+    const size_t rows = state.range(0) / cols + 1;
+    const math::vector<double> row{1.0, 2.0, 3.0};
+    for (auto _ : state) {
+        math::matrix<double> m;
+        m.reserve_rows(rows, cols);
+        for (size_t r = 0; r < rows; ++r)
+            m.push_back(row);
+        benchmark::DoNotOptimize(m.data());
+    }
+    bench::set_processed<double>(state, rows * cols);
+}
+BENCHMARK(BM_matrix_push_back_reserve_rows)->Apply(bench::sizes);
+
+static void BM_std_vector_push_back_rows(benchmark::State& state) {
+    const size_t rows = state.range(0) / cols + 1;
+    const std::array<double, cols> row{1.0, 2.0, 3.0};
+    for (auto _ : state) {
+        std::vector<double> m;
+        for (size_t r = 0; r < rows; ++r)
+            m.insert(m.end(), row.begin(), row.end());
+        benchmark::DoNotOptimize(m.data());
+    }
+    bench::set_processed<double>(state, rows * cols);
+}
+BENCHMARK(BM_std_vector_push_back_rows)->Apply(bench::sizes);
+
+static void BM_std_vector_push_back_rows_reserve(benchmark::State& state) {
+    const size_t rows = state.range(0) / cols + 1;
+    const std::array<double, cols> row{1.0, 2.0, 3.0};
+    for (auto _ : state) {
+        std::vector<double> m;
+        m.reserve(rows * cols);
+        for (size_t r = 0; r < rows; ++r)
+            m.insert(m.end(), row.begin(), row.end());
+        benchmark::DoNotOptimize(m.data());
+    }
+    bench::set_processed<double>(state, rows * cols);
+}
+BENCHMARK(BM_std_vector_push_back_rows_reserve)->Apply(bench::sizes);
+
+// row access, state.range(0) = matrix dimension
+
+static void BM_matrix_row_access(benchmark::State& state) {
+    const size_t n = state.range(0);
+    math::matrix<double> m(n, n);
+    bench::fill(m.eigen().reshaped(), n * n);
+    for (auto _ : state) {
+        double s = 0;
+        for (size_t r = 0; r < n; ++r)
+            s += m[r][r];
+        benchmark::DoNotOptimize(s);
+    }
+    bench::set_processed<double>(state, n);
+}
+BENCHMARK(BM_matrix_row_access)->Apply(bench::dims);
+
+static void BM_matrix_row_sum(benchmark::State& state) {
+    const size_t n = state.range(0);
+    math::matrix<double> m(n, n);
+    bench::fill(m.eigen().reshaped(), n * n);
+    for (auto _ : state) {
+        double s = 0;
+        for (size_t r = 0; r < n; ++r)
+            s += m[r].sum();
+        benchmark::DoNotOptimize(s);
+    }
+    bench::set_processed<double>(state, n * n);
+}
+BENCHMARK(BM_matrix_row_sum)->Apply(bench::dims);
+
+static void BM_eigen_row_sum(benchmark::State& state) {
+    const Eigen::Index n = state.range(0);
+    Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> m(n, n);
+    bench::fill(m.reshaped(), n * n);
+    for (auto _ : state) {
+        double s = 0;
+        for (Eigen::Index r = 0; r < n; ++r)
+            s += m.row(r).sum();
+        benchmark::DoNotOptimize(s);
+    }
+    bench::set_processed<double>(state, n * n);
+}
+BENCHMARK(BM_eigen_row_sum)->Apply(bench::dims);
+
+static void BM_std_vector_row_sum(benchmark::State& state) {
+    const size_t n = state.range(0);
+    std::vector<std::vector<double>> m(n, std::vector<double>(n));
+    for (auto& row : m)
+        bench::fill(row, n);
+    for (auto _ : state) {
+        double s = 0;
+        for (const auto& row : m)
+            for (double x : row)
+                s += x;
+        benchmark::DoNotOptimize(s);
+    }
+    bench::set_processed<double>(state, n * n);
+}
+BENCHMARK(BM_std_vector_row_sum)->Apply(bench::dims);
\ No newline at end of file
@@ -0,0 +1,343 @@
+/*
+ *  bench_operators.cpp
+ *  Created by Matthias Kesenheimer on 19.06.22.
+ *  Copyright 2022. All rights reserved.
+ *  More information about the Eigen library at http://eigen.tuxfamily.org/dox/index.html
+ */
+
+#include "bench.h"
+#include "operators.h"
+#include <vector>
+#include <cmath>
+
+// Every operator of operators.h against the same operation on raw Eigen types and a plain loop over std::vector.
+// The results are written into preallocated outputs, i.e. the benchmarks measure the evaluation only.
+
+namespace {
+    using dvec = math::vector<double>;
+    using evec = Eigen::VectorXd;
+    using svec = std::vector<double>;
+
+    using dmat = math::matrix<double>;
+    using emat = Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+    using smat = std::vector<double>; // row-major n x n
+
+    // factors close to 1, such that repeated in-place operations neither overflow nor become denormal
+    const double scalar = 1.0000001;
+
+    // vector operations: op(a, b, c), a and b are inputs, c is the output
+
+    struct mul_scalar {
+        static constexpr int arrays = 2;
+        template <class _V> void operator()(const _V& a, const _V&, _V& c) const { c = a * scalar; }
+        void operator()(const svec& a, const svec&, svec& c) const { for (size_t i = 0; i < c.size(); ++i) c[i] = a[i] * scalar; }
+    };
+
+    struct scalar_mul {
+        static constexpr int arrays = 2;
+        template <class _V> void operator()(const _V& a, const _V&, _V& c) const { c = scalar * a; }
+        void operator()(const svec& a, const svec&, svec& c) const { for (size_t i = 0; i < c.size(); ++i) c[i] = scalar * a[i]; }
+    };
+
+    struct div_scalar {
+        static constexpr int arrays = 2;
+        template <class _V> void operator()(const _V& a, const _V&, _V& c) const { c = a / scalar; }
+        void operator()(const svec& a, const svec&, svec& c) const { for (size_t i = 0; i < c.size(); ++i) c[i] = a[i] / scalar; }
+    };
+
+    struct dot {
+        static constexpr int arrays = 2;
+        void operator()(const dvec& a, const dvec& b, dvec& c) const { c[0] = a * b; }
+        void operator()(const evec& a, const evec& b, evec& c) const { c[0] = a.dot(b); }
+        void operator()(const svec& a, const svec& b, svec& c) const {
+            double s = 0;
+            for (size_t i = 0; i < a.size(); ++i)
+                s += a[i] * b[i];
+            c[0] = s;
+        }
+    };
+
+    struct add {
+        static constexpr int arrays = 3;
+        template <class _V> void operator()(const _V& a, const _V& b, _V& c) const { c = a + b; }
+        void operator()(const svec& a, const svec& b, svec& c) const { for (size_t i = 0; i < c.size(); ++i) c[i] = a[i] + b[i]; }
+    };
+
+    struct sub {
+        static constexpr int arrays = 3;
+        template <class _V> void operator()(const _V& a, const _V& b, _V& c) const { c = a - b; }
+        void operator()(const svec& a, const svec& b, svec& c) const { for (size_t i = 0; i < c.size(); ++i) c[i] = a[i] - b[i]; }
+    };
+
+    struct add_assign {
+        static constexpr int arrays = 2;
+        template <class _V> void operator()(const _V& a, const _V&, _V& c) const { c += a; }
+        void operator()(const svec& a, const svec&, svec& c) const { for (size_t i = 0; i < c.size(); ++i) c[i] += a[i]; }
+    };
+
+    struct sub_assign {
+        static constexpr int arrays = 2;
+        template <class _V> void operator()(const _V& a, const _V&, _V& c) const { c -= a; }
+        void operator()(const svec& a, const svec&, svec& c) const { for (size_t i = 0; i < c.size(); ++i) c[i] -= a[i]; }
+    };
+
+    struct mul_assign {
+        static constexpr int arrays = 1;
+        template <class _V> void operator()(const _V&, const _V&, _V& c) const { c *= scalar; }
+        void operator()(const svec&, const svec&, svec& c) const { for (size_t i = 0; i < c.size(); ++i) c[i] *= scalar; }
+    };
+
+    struct div_assign {
+        static constexpr int arrays = 1;
+        template <class _V> void operator()(const _V&, const _V&, _V& c) const { c /= scalar; }
+        void operator()(const svec&, const svec&, svec& c) const { for (size_t i = 0; i < c.size(); ++i) c[i] /= scalar; }
+    };
+
+    struct expression {
+        static constexpr int arrays = 3;
+        template <class _V> void operator()(const _V& a, const _V& b, _V& c) const { c = a + b * scalar - a; }
+        void operator()(const svec& a, const svec& b, svec& c) const { for (size_t i = 0; i < c.size(); ++i) c[i] = a[i] + b[i] * scalar - a[i]; }
+    };
+
+    struct cprod {
+        static constexpr int arrays = 3;
+        void operator()(const dvec& a, const dvec& b, dvec& c) const { c = math::eigen::cprod(a, b); }
+        void operator()(const evec& a, const evec& b, evec& c) const { c = a.cwiseProduct(b); }
+        void operator()(const svec& a, const svec& b, svec& c) const { for (size_t i = 0; i < c.size(); ++i) c[i] = a[i] * b[i]; }
+    };
+
+    struct cdiv {
+        static constexpr int arrays = 3;
+        void operator()(const dvec& a, const dvec& b, dvec& c) const { c = math::eigen::cdiv(a, b); }
+        void operator()(const evec& a, const evec& b, evec& c) const { c = a.cwiseQuotient(b); }
+        void operator()(const svec& a, const svec& b, svec& c) const { for (size_t i = 0; i < c.size(); ++i) c[i] = a[i] / b[i]; }
+    };
+
+    struct norm {
+        static constexpr int arrays = 1;
+        void operator()(const dvec& a, const dvec&, dvec& c) const { c[0] = math::eigen::norm(a); }
+        void operator()(const evec& a, const evec&, evec& c) const { c[0] = a.norm(); }
+        void operator()(const svec& a, const svec&, svec& c) const {
+            double s = 0;
+            for (size_t i = 0; i < a.size(); ++i)
+                s += a[i] * a[i];
+            c[0] = std::sqrt(s);
+        }
+    };
+
+    struct normalize {
+        static constexpr int arrays = 1;
+        void operator()(const dvec&, const dvec&, dvec& c) const { math::eigen::normalize(c); }
+        void operator()(const evec&, const evec&, evec& c) const { c.normalize(); }
+        void operator()(const svec&, const svec&, svec& c) const {
+            double s = 0;
+            for (size_t i = 0; i < c.size(); ++i)
+                s += c[i] * c[i];
+            s = std::sqrt(s);
+            for (size_t i = 0; i < c.size(); ++i)
+                c[i] /= s;
+        }
+    };
+
+    struct sum {
+        static constexpr int arrays = 1;
+        void operator()(const dvec& a, const dvec&, dvec& c) const { c[0] = math::eigen::sum(a); }
+        void operator()(const evec& a, const evec&, evec& c) const { c[0] = a.sum(); }
+        void operator()(const svec& a, const svec&, svec& c) const {
+            double s = 0;
+            for (size_t i = 0; i < a.size(); ++i)
+                s += a[i];
+            c[0] = s;
+        }
+    };
+
+    // matrix operations: op(A, B, C, x, y, n), A, B and x are inputs, C and y are outputs
+
+    dmat make_matrix(dmat*, size_t n) { return dmat(n, n); }
+    emat make_matrix(emat*, size_t n) { return emat::Zero(n, n); }
+    smat make_matrix(smat*, size_t n) { return smat(n * n); }
+
+    struct mat_vec {
+        static constexpr int arrays = 1;
+        template <class _M, class _V> void operator()(const _M& A, const _M&, _M&, const _V& x, _V& y, size_t) const { y = A * x; }
+        void operator()(const smat& A, const smat&, smat&, const svec& x, svec& y, size_t n) const {
+            for (size_t r = 0; r < n; ++r) {
+                double s = 0;
+                for (size_t c = 0; c < n; ++c)
+                    s += A[r * n + c] * x[c];
+                y[r] = s;
+            }
+        }
+    };
+
+    struct vec_mat {
+        static constexpr int arrays = 1;
+        void operator()(const dmat& A, const dmat&, dmat&, const dvec& x, dvec& y, size_t) const { y = x * A; }
+        void operator()(const emat& A, const emat&, emat&, const evec& x, evec& y, size_t) const { y = x.transpose() * A; }
+        void operator()(const smat& A, const smat&, smat&, const svec& x, svec& y, size_t n) const {
+            std::fill(y.begin(), y.end(), 0.0);
+            for (size_t r = 0; r < n; ++r)
+                for (size_t c = 0; c < n; ++c)
+                    y[c] += x[r] * A[r * n + c];
+        }
+    };
+
+    struct mat_add {
+        static constexpr int arrays = 3;
+        template <class _M, class _V> void operator()(const _M& A, const _M& B, _M& C, const _V&, _V&, size_t) const { C = A + B; }
+        void operator()(const smat& A, const smat& B, smat& C, const svec&, svec&, size_t) const { for (size_t i = 0; i < C.size(); ++i) C[i] = A[i] + B[i]; }
+    };
+
+    struct mat_sub {
+        static constexpr int arrays = 3;
+        template <class _M, class _V> void operator()(const _M& A, const _M& B, _M& C, const _V&, _V&, size_t) const { C = A - B; }
+        void operator()(const smat& A, const smat& B, smat& C, const svec&, svec&, size_t) const { for (size_t i = 0; i < C.size(); ++i) C[i] = A[i] - B[i]; }
+    };
+
+    struct mat_mul_scalar {
+        static constexpr int arrays = 2;
+        template <class _M, class _V> void operator()(const _M& A, const _M&, _M& C, const _V&, _V&, size_t) const { C = A * scalar; }
+        void operator()(const smat& A, const smat&, smat& C, const svec&, svec&, size_t) const { for (size_t i = 0; i < C.size(); ++i) C[i] = A[i] * scalar; }
+    };
+
+    struct scalar_mul_mat {
+        static constexpr int arrays = 2;
+        template <class _M, class _V> void operator()(const _M& A, const _M&, _M& C, const _V&, _V&, size_t) const { C = scalar * A; }
+        void operator()(const smat& A, const smat&, smat& C, const svec&, svec&, size_t) const { for (size_t i = 0; i < C.size(); ++i) C[i] = scalar * A[i]; }
+    };
+
+    struct mat_div_scalar {
+        static constexpr int arrays = 2;
+        template <class _M, class _V> void operator()(const _M& A, const _M&, _M& C, const _V&, _V&, size_t) const { C = A / scalar; }
+        void operator()(const smat& A, const smat&, smat& C, const svec&, svec&, size_t) const { for (size_t i = 0; i < C.size(); ++i) C[i] = A[i] / scalar; }
+    };
+
+    struct transpose {
+        static constexpr int arrays = 2;
+        void operator()(const dmat& A, const dmat&, dmat& C, const dvec&, dvec&, size_t) const { C = math::eigen::transpose(A); }
+        void operator()(const emat& A, const emat&, emat& C, const evec&, evec&, size_t) const { C = A.transpose(); }
+        void operator()(const smat& A, const smat&, smat& C, const svec&, svec&, size_t n) const {
+            for (size_t r = 0; r < n; ++r)
+                for (size_t c = 0; c < n; ++c)
+                    C[c * n + r] = A[r * n + c];
+        }
+    };
+
+    struct mat_mul {
+        static constexpr int arrays = 3;
+        template <class _M, class _V> void operator()(const _M& A, const _M& B, _M& C, const _V&, _V&, size_t) const { C = A * B; }
+        void operator()(const smat& A, const smat& B, smat& C, const svec&, svec&, size_t n) const {
+            std::fill(C.begin(), C.end(), 0.0);
+            for (size_t r = 0; r < n; ++r)
+                for (size_t k = 0; k < n; ++k)
+                    for (size_t c = 0; c < n; ++c)
+                        C[r * n + c] += A[r * n + k] * B[k * n + c];
+        }
+    };
+
+    struct inverse {
+        static constexpr int arrays = 2;
+        void operator()(const dmat& A, const dmat&, dmat& C, const dvec&, dvec&, size_t) const { C = math::eigen::inverse(A); }
+        void operator()(const emat& A, const emat&, emat& C, const evec&, evec&, size_t) const { C = A.inverse(); }
+    };
+}
+
+template <class _Vec, class _Op>
+static void BM_vector_op(benchmark::State& state) {
+    const size_t n = state.range(0);
+    _Vec a(n), b(n), c(n);
+    bench::fill(a, n);
+    bench::fill(b, n);
+    bench::fill(c, n);
+    for (auto _ : state) {
+        _Op()(a, b, c);
+        benchmark::DoNotOptimize(c.data());
+        benchmark::ClobberMemory();
+    }
+    bench::set_processed<double>(state, n, _Op::arrays);
+}
+
+template <class _Mat, class _Vec, class _Op>
+static void BM_matrix_op(benchmark::State& state) {
+    const size_t n = state.range(0);
+    _Mat A = make_matrix(static_cast<_Mat*>(nullptr), n);
+    _Mat B = make_matrix(static_cast<_Mat*>(nullptr), n);
+    _Mat C = make_matrix(static_cast<_Mat*>(nullptr), n);
+    _Vec x(n), y(n);
+    for (size_t i = 0; i < n * n; ++i) {
+        // diagonally dominant, i.e. invertible
+        A.data()[i] = bench::value(i) + (i % (n + 1) == 0 ? n : 0);
+        B.data()[i] = bench::value(i + 1);
+    }
+    bench::fill(x, n);
+    for (auto _ : state) {
+        _Op()(A, B, C, x, y, n);
+        benchmark::DoNotOptimize(C.data());
+        benchmark::DoNotOptimize(y.data());
+        benchmark::ClobberMemory();
+    }
+    bench::set_processed<double>(state, n * n, _Op::arrays);
+}
+
+#define MATH_BENCH_VECTOR_OP(op) \
+    BENCHMARK_TEMPLATE(BM_vector_op, dvec, op)->Apply(bench::sizes); \
+    BENCHMARK_TEMPLATE(BM_vector_op, evec, op)->Apply(bench::sizes); \
+    BENCHMARK_TEMPLATE(BM_vector_op, svec, op)->Apply(bench::sizes)
+
+#define MATH_BENCH_MATRIX_OP(op, dims) \
+    BENCHMARK_TEMPLATE(BM_matrix_op, dmat, dvec, op)->Apply(dims); \
+    BENCHMARK_TEMPLATE(BM_matrix_op, emat, evec, op)->Apply(dims); \
+    BENCHMARK_TEMPLATE(BM_matrix_op, smat, svec, op)->Apply(dims)
+
+MATH_BENCH_VECTOR_OP(mul_scalar);
+MATH_BENCH_VECTOR_OP(scalar_mul);
+MATH_BENCH_VECTOR_OP(div_scalar);
+MATH_BENCH_VECTOR_OP(dot);
+MATH_BENCH_VECTOR_OP(add);
+MATH_BENCH_VECTOR_OP(sub);
+MATH_BENCH_VECTOR_OP(add_assign);
+MATH_BENCH_VECTOR_OP(sub_assign);
+MATH_BENCH_VECTOR_OP(mul_assign);
+MATH_BENCH_VECTOR_OP(div_assign);
+MATH_BENCH_VECTOR_OP(expression);
+MATH_BENCH_VECTOR_OP(cprod);
+MATH_BENCH_VECTOR_OP(cdiv);
+MATH_BENCH_VECTOR_OP(norm);
+MATH_BENCH_VECTOR_OP(normalize);
+MATH_BENCH_VECTOR_OP(sum);
+
+MATH_BENCH_MATRIX_OP(mat_vec, bench::dims);
+MATH_BENCH_MATRIX_OP(vec_mat, bench::dims);
+MATH_BENCH_MATRIX_OP(mat_add, bench::dims);
+MATH_BENCH_MATRIX_OP(mat_sub, bench::dims);
+MATH_BENCH_MATRIX_OP(mat_mul_scalar, bench::dims);
+MATH_BENCH_MATRIX_OP(scalar_mul_mat, bench::dims);
+MATH_BENCH_MATRIX_OP(mat_div_scalar, bench::dims);
+MATH_BENCH_MATRIX_OP(transpose, bench::dims);
+MATH_BENCH_MATRIX_OP(mat_mul, bench::cubic_dims);
+
+// no plain-loop baseline for the inverse
+BENCHMARK_TEMPLATE(BM_matrix_op, dmat, dvec, inverse)->Apply(bench::cubic_dims);
+BENCHMARK_TEMPLATE(BM_matrix_op, emat, evec, inverse)->Apply(bench::cubic_dims);
+
+// matrix-vector product with float accumulation, the matrix stored in 32 and 16 bit
+template <class _T>
+static void BM_gemv_storage(benchmark::State& state) {
+    const size_t n = state.range(0);
+    math::matrix<_T> A(n, n);
+    math::vector<float> x(n), y(n);
+    for (size_t i = 0; i < n * n; ++i)
+        A.data()[i] = _T(static_cast<float>(bench::value(i)));
+    for (size_t i = 0; i < n; ++i)
+        x[i] = static_cast<float>(bench::value(i));
+    for (auto _ : state) {
+        math::eigen::multiply_into(y, A, x);
+        benchmark::DoNotOptimize(y.data());
+        benchmark::ClobberMemory();
+    }
+    bench::set_processed<_T>(state, n * n, 1);
+}
+
+BENCHMARK_TEMPLATE(BM_gemv_storage, float)->Apply(bench::dims);
+BENCHMARK_TEMPLATE(BM_gemv_storage, Eigen::half)->Apply(bench::dims);
+BENCHMARK_TEMPLATE(BM_gemv_storage, Eigen::bfloat16)->Apply(bench::dims);
\ No newline at end of file
@@ -0,0 +1,87 @@
+/*
+ *  bench_parallel.cpp
+ *  Created by Matthias Kesenheimer on 19.06.22.
+ *  Copyright 2022. All rights reserved.
+ *  More information about the Eigen library at http://eigen.tuxfamily.org/dox/index.html
+ */
+
+#include "bench.h"
+#include "parallel.h"
+
+// sequential vs. parallel execution policies of parallel.h, compare with BM_vector_op<dvec, sum> etc.
+
+template <class _Policy>
+static void BM_parallel_sum(benchmark::State& state, const _Policy& policy) {
+    const size_t n = state.range(0);
+    math::vector<double> a(n);
+    bench::fill(a, n);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(math::eigen::sum(policy, a));
+    bench::set_processed<double>(state, n);
+}
+BENCHMARK_CAPTURE(BM_parallel_sum, seq, math::execution::seq)->Apply(bench::sizes)->UseRealTime();
+BENCHMARK_CAPTURE(BM_parallel_sum, par, math::execution::par)->Apply(bench::sizes)->UseRealTime();
+
+template <class _Policy>
+static void BM_parallel_norm(benchmark::State& state, const _Policy& policy) {
+    const size_t n = state.range(0);
+    math::vector<double> a(n);
+    bench::fill(a, n);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(math::eigen::norm(policy, a));
+    bench::set_processed<double>(state, n);
+}
+BENCHMARK_CAPTURE(BM_parallel_norm, seq, math::execution::seq)->Apply(bench::sizes)->UseRealTime();
+BENCHMARK_CAPTURE(BM_parallel_norm, par, math::execution::par)->Apply(bench::sizes)->UseRealTime();
+
+template <class _Policy>
+static void BM_parallel_assign(benchmark::State& state, const _Policy& policy) {
+    const size_t n = state.range(0);
+    math::vector<double> a(n), b(n), c(n);
+    bench::fill(a, n);
+    bench::fill(b, n);
+    for (auto _ : state) {
+        math::eigen::assign(policy, c, a.eigen().cwiseProduct(b.eigen()) + a.eigen());
+        benchmark::DoNotOptimize(c.data());
+        benchmark::ClobberMemory();
+    }
+    bench::set_processed<double>(state, n, 3);
+}
+BENCHMARK_CAPTURE(BM_parallel_assign, seq, math::execution::seq)->Apply(bench::sizes)->UseRealTime();
+BENCHMARK_CAPTURE(BM_parallel_assign, par, math::execution::par)->Apply(bench::sizes)->UseRealTime();
+
+template <class _Policy>
+static void BM_parallel_mat_mul(benchmark::State& state, const _Policy& policy) {
+    const size_t n = state.range(0);
+    math::matrix<double> A(n, n), B(n, n), C(n, n);
+    for (size_t i = 0; i < n * n; ++i) {
+        A.data()[i] = bench::value(i);
+        B.data()[i] = bench::value(i + 1);
+    }
+    for (auto _ : state) {
+        math::eigen::multiply_into(policy, C, A, B);
+        benchmark::DoNotOptimize(C.data());
+        benchmark::ClobberMemory();
+    }
+    bench::set_processed<double>(state, n * n, 3);
+}
+BENCHMARK_CAPTURE(BM_parallel_mat_mul, seq, math::execution::seq)->Apply(bench::cubic_dims)->UseRealTime();
+BENCHMARK_CAPTURE(BM_parallel_mat_mul, par, math::execution::par)->Apply(bench::cubic_dims)->UseRealTime();
+
+template <class _Policy>
+static void BM_parallel_mat_vec(benchmark::State& state, const _Policy& policy) {
+    const size_t n = state.range(0);
+    math::matrix<double> A(n, n);
+    math::vector<double> x(n), y(n);
+    for (size_t i = 0; i < n * n; ++i)
+        A.data()[i] = bench::value(i);
+    bench::fill(x, n);
+    for (auto _ : state) {
+        math::eigen::multiply_into(policy, y, A, x);
+        benchmark::DoNotOptimize(y.data());
+        benchmark::ClobberMemory();
+    }
+    bench::set_processed<double>(state, n * n);
+}
+BENCHMARK_CAPTURE(BM_parallel_mat_vec, seq, math::execution::seq)->Apply(bench::dims)->UseRealTime();
+BENCHMARK_CAPTURE(BM_parallel_mat_vec, par, math::execution::par)->Apply(bench::dims)->UseRealTime();
\ No newline at end of file
@@ -0,0 +1,206 @@
+/*
+ *  bench_vector.cpp
+ *  Created by Matthias Kesenheimer on 19.06.22.
+ *  Copyright 2022. All rights reserved.
+ *  More information about the Eigen library at http://eigen.tuxfamily.org/dox/index.html
+ */
+
+#include "bench.h"
+#include "vector.h"
+#include <vector>
+
+// push_back
+
+static void BM_vector_push_back(benchmark::State& state) {
+    const size_t n = state.range(0);
+    for (auto _ : state) {
+        math::vector<double> v;
+        for (size_t i = 0; i < n; ++i)
+            v.push_back(bench::value(i));
+        benchmark::DoNotOptimize(v.data());
+    }
+    bench::set_processed<double>(state, n);
+}
+BENCHMARK(BM_vector_push_back)->Apply(bench::sizes);
+
+static void BM_vector_push_back_reserve(benchmark::State& state) {
+    const size_t n = state.range(0);
+    for (auto _ : state) {
+        math::vector<double> v;
+        v.reserve(n);
+        for (size_t i = 0; i < n; ++i)
+            v.push_back(bench::value(i));
+        benchmark::DoNotOptimize(v.data());
+    }
+    bench::set_processed<double>(state, n);
+}
+BENCHMARK(BM_vector_push_back_reserve)->Apply(bench::sizes);
+
+static void BM_std_vector_push_back(benchmark::State& state) {
+    const size_t n = state.range(0);
+    for (auto _ : state) {
+        std::vector<double> v;
+        for (size_t i = 0; i < n; ++i)
+            v.push_back(bench::value(i));
+        benchmark::DoNotOptimize(v.data());
+    }
+    bench::set_processed<double>(state, n);
+}
+BENCHMARK(BM_std_vector_push_back)->Apply(bench::sizes);
+
+static void BM_std_vector_push_back_reserve(benchmark::State& state) {
+    const size_t n = state.range(0);
+    for (auto _ : state) {
+        std::vector<double> v;
+        v.reserve(n);
+        for (size_t i = 0; i < n; ++i)
+            v.push_back(bench::value(i));
+        benchmark::DoNotOptimize(v.data());
+    }
+    bench::set_processed<double>(state, n);
+}
+BENCHMARK(BM_std_vector_push_back_reserve)->Apply(bench::sizes);
+
+// append
+
+static void BM_vector_append(benchmark::State& state) {
+    const size_t n = state.range(0);
+    math::vector<double> src(n);
+    bench::fill(src, n);
+    for (auto _ : state) {
+        math::vector<double> v(n);
+        v.append(src);
+        benchmark::DoNotOptimize(v.data());
+    }
+    bench::set_processed<double>(state, n);
+}
+BENCHMARK(BM_vector_append)->Apply(bench::sizes);
+
+static void BM_std_vector_append(benchmark::State& state) {
+    const size_t n = state.range(0);
+    std::vector<double> src(n);
+    bench::fill(src, n);
+    for (auto _ : state) {
+        std::vector<double> v(n);
+        v.insert(v.end(), src.begin(), src.end());
+        benchmark::DoNotOptimize(v.data());
+    }
+    bench::set_processed<double>(state, n);
+}
+BENCHMARK(BM_std_vector_append)->Apply(bench::sizes);
+
+static void BM_eigen_append(benchmark::State& state) {
+    const Eigen::Index n = state.range(0);
+    Eigen::VectorXd src(n);
+    bench::fill(src, n);
+    for (auto _ : state) {
+        Eigen::VectorXd v = Eigen::VectorXd::Zero(n);
+        v.conservativeResize(2 * n);
+        v.tail(n) = src;
+        benchmark::DoNotOptimize(v.data());
+    }
+    bench::set_processed<double>(state, n);
+}
+BENCHMARK(BM_eigen_append)->Apply(bench::sizes);
+
+// erase an element in the middle (and push_back one to keep the size constant)
+
+static void BM_vector_erase(benchmark::State& state) {
+    const size_t n = state.range(0);
+    math::vector<double> v(n);
+    bench::fill(v, n);
+    for (auto _ : state) {
+        v.erase(v.begin() + n / 2);
+        v.push_back(1.0);
+        benchmark::DoNotOptimize(v.data());
+    }
+    bench::set_processed<double>(state, n);
+}
+BENCHMARK(BM_vector_erase)->Apply(bench::sizes);
+
+static void BM_std_vector_erase(benchmark::State& state) {
+    const size_t n = state.range(0);
+    std::vector<double> v(n);
+    bench::fill(v, n);
+    for (auto _ : state) {
+        v.erase(v.begin() + n / 2);
+        v.push_back(1.0);
+        benchmark::DoNotOptimize(v.data());
+    }
+    bench::set_processed<double>(state, n);
+}
+BENCHMARK(BM_std_vector_erase)->Apply(bench::sizes);
+
+static void BM_vector_swap_erase(benchmark::State& state) {
+    const size_t n = state.range(0);
+    math::vector<double> v(n);
+    bench::fill(v, n);
+    for (auto _ : state) {
+        v.swap_erase(v.begin() + n / 2);
+        v.push_back(1.0);
+        benchmark::DoNotOptimize(v.data());
+    }
+    bench::set_processed<double>(state, n);
+}
+BENCHMARK(BM_vector_swap_erase)->Apply(bench::sizes);
+
+// remove every other element in one pass (and refill to keep the size constant)
+
+static void BM_vector_erase_if(benchmark::State& state) {
+    const size_t n = state.range(0);
+    math::vector<double> v(n);
+    for (auto _ : state) {
+        state.PauseTiming();
+        v.resize(n);
+        bench::fill(v, n);
+        state.ResumeTiming();
+        v.erase_if([](double x) { return x > 1.6; });
+        benchmark::DoNotOptimize(v.data());
+    }
+    bench::set_processed<double>(state, n);
+}
+BENCHMARK(BM_vector_erase_if)->Apply(bench::sizes);
+
+// element access
+
+static void BM_vector_index(benchmark::State& state) {
+    const size_t n = state.range(0);
+    math::vector<double> v(n);
+    bench::fill(v, n);
+    for (auto _ : state) {
+        double s = 0;
+        for (size_t i = 0; i < n; ++i)
+            s += v[i];
+        benchmark::DoNotOptimize(s);
+    }
+    bench::set_processed<double>(state, n);
+}
+BENCHMARK(BM_vector_index)->Apply(bench::sizes);
+
+static void BM_vector_iterate(benchmark::State& state) {
+    const size_t n = state.range(0);
+    math::vector<double> v(n);
+    bench::fill(v, n);
+    for (auto _ : state) {
+        double s = 0;
+        for (const auto& x : v)
+            s += x;
+        benchmark::DoNotOptimize(s);
+    }
+    bench::set_processed<double>(state, n);
+}
+BENCHMARK(BM_vector_iterate)->Apply(bench::sizes);
+
+static void BM_std_vector_index(benchmark::State& state) {
+    const size_t n = state.range(0);
+    std::vector<double> v(n);
+    bench::fill(v, n);
+    for (auto _ : state) {
+        double s = 0;
+        for (size_t i = 0; i < n; ++i)
+            s += v[i];
+        benchmark::DoNotOptimize(s);
+    }
+    bench::set_processed<double>(state, n);
+}
+BENCHMARK(BM_std_vector_index)->Apply(bench::sizes);
\ No newline at end of file
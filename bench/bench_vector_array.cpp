@@ -0,0 +1,90 @@
+/*
+ *  bench_vector_array.cpp
+ *  Created by Matthias Kesenheimer on 19.06.22.
+ *  Copyright 2022. All rights reserved.
+ *  More information about the Eigen library at http://eigen.tuxfamily.org/dox/index.html
+ */
+
+#include "bench.h"
+#include "vector_array.h"
+#include <vector>
+
+// Bulk operations on collections of 3D points: structure of arrays (math::vector_array) against an array of
+// fixed-size vectors and a vector of dynamic-size vectors (one heap block per point).
+
+namespace {
+    using point = math::vector<double, 3>;
+    using soa = math::vector_array<double, 3>;
+    using aos = std::vector<point>;
+    using nested = std::vector<math::vector<double>>;
+
+    template <class _Points>
+    _Points make_points(size_t n);
+
+    template <>
+    soa make_points<soa>(size_t n) {
+        soa p;
+        for (size_t i = 0; i < n; ++i)
+            p.push_back(point{bench::value(i), bench::value(i + 1), bench::value(i + 2)});
+        return p;
+    }
+
+    template <>
+    aos make_points<aos>(size_t n) {
+        aos p(n);
+        for (size_t i = 0; i < n; ++i)
+            p[i] = point{bench::value(i), bench::value(i + 1), bench::value(i + 2)};
+        return p;
+    }
+
+    template <>
+    nested make_points<nested>(size_t n) {
+        nested p(n, math::vector<double>(3));
+        for (size_t i = 0; i < n; ++i)
+            p[i] = math::vector<double>{bench::value(i), bench::value(i + 1), bench::value(i + 2)};
+        return p;
+    }
+
+    struct norm {
+        void operator()(const soa& p, math::vector<double>& out, const math::matrix<double, 3, 3>&) const { math::eigen::norm_into(out, p); }
+        template <class _Points>
+        void operator()(const _Points& p, math::vector<double>& out, const math::matrix<double, 3, 3>&) const {
+            for (size_t i = 0; i < p.size(); ++i)
+                out[i] = p[i].eigen().norm();
+        }
+    };
+
+    struct rotate {
+        void operator()(soa& p, math::vector<double>&, const math::matrix<double, 3, 3>& R) const { math::eigen::transform(p, R); }
+        template <class _Points>
+        void operator()(_Points& p, math::vector<double>&, const math::matrix<double, 3, 3>& R) const {
+            for (size_t i = 0; i < p.size(); ++i)
+                p[i].eigen() = R.eigen() * p[i].eigen();
+        }
+    };
+}
+
+template <class _Points, class _Op>
+static void BM_points_op(benchmark::State& state) {
+    const size_t n = state.range(0);
+    _Points p = make_points<_Points>(n);
+    math::vector<double> out(n);
+    math::matrix<double, 3, 3> R;
+    // rotation about the z axis, such that repeated rotations keep the values bounded
+    R.eigen() << 0.6, -0.8, 0.0,
+                 0.8, 0.6, 0.0,
+                 0.0, 0.0, 1.0;
+    for (auto _ : state) {
+        _Op()(p, out, R);
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    bench::set_processed<double>(state, 3 * n);
+}
+
+BENCHMARK_TEMPLATE(BM_points_op, soa, norm)->Apply(bench::sizes);
+BENCHMARK_TEMPLATE(BM_points_op, aos, norm)->Apply(bench::sizes);
+BENCHMARK_TEMPLATE(BM_points_op, nested, norm)->Apply(bench::sizes);
+BENCHMARK_TEMPLATE(BM_points_op, soa, rotate)->Apply(bench::sizes);
+BENCHMARK_TEMPLATE(BM_points_op, aos, rotate)->Apply(bench::sizes);
+BENCHMARK_TEMPLATE(BM_points_op, nested, rotate)->Apply(bench::sizes);
\ No newline at end of file
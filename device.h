@@ -0,0 +1,858 @@
+/*
+ *  device.h
+ *  Created by Matthias Kesenheimer on 19.06.22.
+ *  Copyright 2022. All rights reserved.
+ *  More information about the Eigen library at http://eigen.tuxfamily.org/dox/index.html
+ */
+
+#pragma once
+#ifndef MATH_CUDA
+#error "device.h: the device backend is compiled with -DMATH_CUDA (link with -lcudart -lcublas)"
+#endif
+#include "vector.h"
+#include "matrix.h"
+#include "operators.h"
+#include <Eigen/Dense>
+#include <cuda_runtime.h>
+#include <cublas_v2.h>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+// Optional device backend: dynamic-size vectors and matrices which reside in the memory of a CUDA device. The
+// operators dispatch to cuBLAS, compiled in with -DMATH_CUDA and linked with -lcudart -lcublas (CUDA >= 11.2):
+//     math::device::stream s;                                     // CUDA stream with its own cuBLAS handle
+//     math::device::matrix<double> A = math::to_device(a, s);    // upload, 'a' may be changed afterwards
+//     math::device::vector<double> x = math::to_device(v, s);
+//     math::device::vector<double> y = A * x + 2.0 * x;          // gemv, scal and axpy on the stream of A
+//     math::eigen::multiply_into(C, A, B);                        // gemm into the memory of C
+//     math::vector<double> r = math::to_host(y);                  // waits for the stream
+// The operations are enqueued on the stream of their operands and return without waiting for the device, i.e. the
+// data stays on the device across a chain of operations. Only to_host(), dot(), norm() and stream::synchronize()
+// wait for the device. Without a stream argument the default stream of the calling thread is used. The operands of
+// an operation must belong to the same stream; a copy onto another stream is made with vector(other, stream).
+// A stream must outlive its vectors and matrices. Element types are float and double, errors of the CUDA runtime
+// and of cuBLAS throw std::runtime_error.
+
+namespace math {
+    namespace device {
+        namespace detail {
+            inline void check(cudaError_t status, const char* what) {
+                if (status != cudaSuccess)
+                    throw std::runtime_error(std::string(what) + ": " + cudaGetErrorString(status));
+            }
+
+            inline void check(cublasStatus_t status, const char* what) {
+                if (status != CUBLAS_STATUS_SUCCESS)
+                    throw std::runtime_error(std::string(what) + ": cuBLAS error " + std::to_string(static_cast<int>(status)));
+            }
+
+            /// <summary>
+            /// cuBLAS routines of the element type
+            /// </summary>
+            template <class _T>
+            struct blas;
+
+            template <>
+            struct blas<float> {
+                static constexpr auto gemm = cublasSgemm;
+                static constexpr auto gemv = cublasSgemv;
+                static constexpr auto axpy = cublasSaxpy;
+                static constexpr auto scal = cublasSscal;
+                static constexpr auto dot = cublasSdot;
+                static constexpr auto nrm2 = cublasSnrm2;
+                static constexpr auto dgmm = cublasSdgmm;
+            };
+
+            template <>
+            struct blas<double> {
+                static constexpr auto gemm = cublasDgemm;
+                static constexpr auto gemv = cublasDgemv;
+                static constexpr auto axpy = cublasDaxpy;
+                static constexpr auto scal = cublasDscal;
+                static constexpr auto dot = cublasDdot;
+                static constexpr auto nrm2 = cublasDnrm2;
+                static constexpr auto dgmm = cublasDdgmm;
+            };
+        }
+
+        /// <summary>
+        /// CUDA stream with a cuBLAS handle, the operations on the vectors and matrices of a stream run in order
+        /// </summary>
+        class stream {
+        public:
+            stream() {
+                    detail::check(cudaStreamCreateWithFlags(&m_stream, cudaStreamNonBlocking), "cudaStreamCreateWithFlags");
+                    cublasStatus_t status = cublasCreate(&m_handle);
+                    if (status == CUBLAS_STATUS_SUCCESS)
+                        status = cublasSetStream(m_handle, m_stream);
+                    if (status != CUBLAS_STATUS_SUCCESS) {
+                        if (m_handle)
+                            cublasDestroy(m_handle);
+                        cudaStreamDestroy(m_stream);
+                        detail::check(status, "cublasCreate");
+                    }
+                }
+
+            stream(const stream&) = delete;
+            stream& operator=(const stream&) = delete;
+
+            ~stream() {
+                cublasDestroy(m_handle);
+                cudaStreamDestroy(m_stream);
+            }
+
+            /// <summary>
+            /// wait until all operations of the stream are done
+            /// </summary>
+            void synchronize() const {
+                detail::check(cudaStreamSynchronize(m_stream), "cudaStreamSynchronize");
+            }
+
+            /// <summary>
+            /// the operations enqueued from now on wait for the operations enqueued on 'other' so far
+            /// </summary>
+            void wait(const stream& other) const {
+                if (&other == this)
+                    return;
+                cudaEvent_t event;
+                detail::check(cudaEventCreateWithFlags(&event, cudaEventDisableTiming), "cudaEventCreateWithFlags");
+                cudaError_t status = cudaEventRecord(event, other.m_stream);
+                if (status == cudaSuccess)
+                    status = cudaStreamWaitEvent(m_stream, event, 0);
+                // the event is released as soon as it is completed
+                cudaEventDestroy(event);
+                detail::check(status, "cudaStreamWaitEvent");
+            }
+
+            cudaStream_t native() const {
+                return m_stream;
+            }
+
+            cublasHandle_t blas_handle() const {
+                return m_handle;
+            }
+
+        private:
+            cudaStream_t m_stream = nullptr;
+            cublasHandle_t m_handle = nullptr;
+        };
+
+        /// <summary>
+        /// default stream of the calling thread
+        /// </summary>
+        inline stream& default_stream() {
+            thread_local stream instance;
+            return instance;
+        }
+
+        namespace detail {
+            /// <summary>
+            /// device memory of 'n' elements, allocated and released in stream order (cudaMallocAsync/cudaFreeAsync)
+            /// </summary>
+            template <class _T>
+            class storage {
+            public:
+                using size_type = size_t;
+
+                storage(size_type n, stream& s)
+                    : m_data(nullptr), m_size(n), m_stream(&s) {
+                        if (n > 0)
+                            check(cudaMallocAsync(reinterpret_cast<void**>(&m_data), n * sizeof(_T), s.native()), "cudaMallocAsync");
+                    }
+
+                /// <summary>
+                /// copy onto the stream 's'
+                /// </summary>
+                storage(const storage& other, stream& s)
+                    : storage(other.m_size, s) {
+                        s.wait(*other.m_stream);
+                        if (m_size > 0)
+                            check(cudaMemcpyAsync(m_data, other.m_data, m_size * sizeof(_T), cudaMemcpyDeviceToDevice, s.native()), "cudaMemcpyAsync");
+                        // the memory of 'other' is changed or released on its stream only after the copy
+                        other.m_stream->wait(s);
+                    }
+
+                storage(const storage& other)
+                    : storage(other, *other.m_stream) {}
+
+                storage(storage&& other) noexcept
+                    : m_data(other.m_data), m_size(other.m_size), m_stream(other.m_stream) {
+                        other.m_data = nullptr;
+                        other.m_size = 0;
+                    }
+
+                ~storage() {
+                    release();
+                }
+
+                /// <summary>
+                /// copy assignment, the storage keeps its stream
+                /// </summary>
+                storage& operator=(const storage& other) {
+                    if (this != &other) {
+                        storage copy(other, *m_stream);
+                        std::swap(m_data, copy.m_data);
+                        std::swap(m_size, copy.m_size);
+                    }
+                    return *this;
+                }
+
+                /// <summary>
+                /// move assignment, the storage keeps its stream and uses the memory of 'other' after the pending
+                /// operations of the stream of 'other'
+                /// </summary>
+                storage& operator=(storage&& other) {
+                    if (this != &other) {
+                        m_stream->wait(*other.m_stream);
+                        release();
+                        m_data = other.m_data;
+                        m_size = other.m_size;
+                        other.m_data = nullptr;
+                        other.m_size = 0;
+                    }
+                    return *this;
+                }
+
+                /// <summary>
+                /// give the storage 'n' elements, the values are not conserved
+                /// </summary>
+                void fit(size_type n) {
+                    if (n != m_size) {
+                        storage s(n, *m_stream);
+                        std::swap(m_data, s.m_data);
+                        std::swap(m_size, s.m_size);
+                    }
+                }
+
+                /// <summary>
+                /// set all bytes to zero (0.0 for float and double)
+                /// </summary>
+                void set_zero() {
+                    if (m_size > 0)
+                        check(cudaMemsetAsync(m_data, 0, m_size * sizeof(_T), m_stream->native()), "cudaMemsetAsync");
+                }
+
+                void upload(const _T* src) {
+                    if (m_size > 0)
+                        check(cudaMemcpyAsync(m_data, src, m_size * sizeof(_T), cudaMemcpyHostToDevice, m_stream->native()), "cudaMemcpyAsync");
+                }
+
+                /// <summary>
+                /// copy to host memory and wait for the stream
+                /// </summary>
+                void download(_T* dst) const {
+                    if (m_size > 0)
+                        check(cudaMemcpyAsync(dst, m_data, m_size * sizeof(_T), cudaMemcpyDeviceToHost, m_stream->native()), "cudaMemcpyAsync");
+                    m_stream->synchronize();
+                }
+
+                _T* data() const {
+                    return m_data;
+                }
+
+                size_type size() const {
+                    return m_size;
+                }
+
+                stream& get_stream() const {
+                    return *m_stream;
+                }
+
+            private:
+                void release() {
+                    // errors are not reported, this is called by the destructor
+                    if (m_data)
+                        cudaFreeAsync(m_data, m_stream->native());
+                    m_data = nullptr;
+                }
+
+                _T* m_data;
+                size_type m_size;
+                stream* m_stream;
+            };
+
+            /// <summary>
+            /// throw if the operands do not belong to the same stream
+            /// </summary>
+            template <class _A, class _B>
+            inline void same_stream(const _A& a, const _B& b, const char* what) {
+                if (&a.get_stream() != &b.get_stream())
+                    throw std::invalid_argument(std::string(what) + ": the operands belong to different streams");
+            }
+
+            /// <summary>
+            /// leading dimension of a dense matrix for cuBLAS (at least 1)
+            /// </summary>
+            template <class _M>
+            inline int leading_dimension(const _M& m) {
+                return static_cast<int>(std::max<size_t>(1, _M::row_major ? m.cols() : m.rows()));
+            }
+        }
+
+        /// <summary>
+        /// dynamic-size vector in device memory
+        /// </summary>
+        template <class _T>
+        class vector {
+            static_assert(std::is_same<_T, float>::value || std::is_same<_T, double>::value, "math::device::vector: the element type must be float or double");
+        public:
+            using value_type = _T;
+            using size_type = size_t;
+            using host_type = math::vector<_T>;
+
+            explicit vector(stream& s = default_stream())
+                : m_storage(0, s) {}
+
+            /// <summary>
+            /// vector with 'n' zeros
+            /// </summary>
+            explicit vector(size_type n, stream& s = default_stream())
+                : m_storage(n, s) {
+                    m_storage.set_zero();
+                }
+
+            /// <summary>
+            /// vector with 'n' elements which are not initialized
+            /// </summary>
+            vector(size_type n, uninitialized_t, stream& s = default_stream())
+                : m_storage(n, s) {}
+
+            /// <summary>
+            /// copy onto the stream 's'
+            /// </summary>
+            vector(const vector& other, stream& s)
+                : m_storage(other.m_storage, s) {}
+
+            size_type size() const {
+                return m_storage.size();
+            }
+
+            bool empty() const {
+                return size() == 0;
+            }
+
+            /// <summary>
+            /// pointer to the device memory
+            /// </summary>
+            _T* data() {
+                return m_storage.data();
+            }
+
+            const _T* data() const {
+                return m_storage.data();
+            }
+
+            stream& get_stream() const {
+                return m_storage.get_stream();
+            }
+
+            /// <summary>
+            /// change the size, the values are not conserved
+            /// </summary>
+            void resize_uninitialized(size_type n) {
+                m_storage.fit(n);
+            }
+
+            void set_zero() {
+                m_storage.set_zero();
+            }
+
+            vector& operator+=(const vector& rhs) {
+                return axpy(_T(1), rhs, "device::vector::operator+=");
+            }
+
+            vector& operator-=(const vector& rhs) {
+                return axpy(_T(-1), rhs, "device::vector::operator-=");
+            }
+
+            vector& operator*=(_T factor) {
+                if (size() > 0)
+                    detail::check(detail::blas<_T>::scal(get_stream().blas_handle(), static_cast<int>(size()), &factor, data(), 1), "cublas scal");
+                return *this;
+            }
+
+            vector& operator/=(_T divisor) {
+                return *this *= _T(1) / divisor;
+            }
+
+            /// <summary>
+            /// this += alpha * x
+            /// </summary>
+            vector& axpy(_T alpha, const vector& x, const char* what = "device::vector::axpy") {
+                detail::same_stream(*this, x, what);
+                if (x.size() != size())
+                    throw std::invalid_argument(std::string(what) + ": the sizes of the vectors differ");
+                if (size() > 0)
+                    detail::check(detail::blas<_T>::axpy(get_stream().blas_handle(), static_cast<int>(size()), &alpha, x.data(), 1, data(), 1), "cublas axpy");
+                return *this;
+            }
+
+            /// <summary>
+            /// upload from host memory, the size is changed to the size of 'src'
+            /// </summary>
+            void upload(const host_type& src) {
+                m_storage.fit(src.size());
+                m_storage.upload(src.data());
+            }
+
+            /// <summary>
+            /// download into host memory and wait for the stream, the size of 'dst' is changed to the size of the vector
+            /// </summary>
+            void download(host_type& dst) const {
+                math::detail::fit(dst, size());
+                m_storage.download(dst.data());
+            }
+
+        private:
+            detail::storage<_T> m_storage;
+        };
+
+        /// <summary>
+        /// dynamic-size matrix in device memory, the elements are stored in the layout of math::matrix
+        /// </summary>
+        template <class _T, int _Layout = Eigen::RowMajor>
+        class matrix {
+            static_assert(std::is_same<_T, float>::value || std::is_same<_T, double>::value, "math::device::matrix: the element type must be float or double");
+            static_assert(_Layout == Eigen::RowMajor || _Layout == Eigen::ColMajor, "math::device::matrix: the layout must be Eigen::RowMajor or Eigen::ColMajor");
+        public:
+            static constexpr bool row_major = _Layout == Eigen::RowMajor;
+            using value_type = _T;
+            using size_type = size_t;
+            using host_type = math::matrix<_T, Eigen::Dynamic, Eigen::Dynamic, _Layout>;
+
+            explicit matrix(stream& s = default_stream())
+                : m_storage(0, s), m_rows(0), m_cols(0) {}
+
+            /// <summary>
+            /// r x c matrix of zeros
+            /// </summary>
+            matrix(size_type r, size_type c, stream& s = default_stream())
+                : m_storage(r * c, s), m_rows(r), m_cols(c) {
+                    m_storage.set_zero();
+                }
+
+            /// <summary>
+            /// r x c matrix, the elements are not initialized
+            /// </summary>
+            matrix(size_type r, size_type c, uninitialized_t, stream& s = default_stream())
+                : m_storage(r * c, s), m_rows(r), m_cols(c) {}
+
+            /// <summary>
+            /// copy onto the stream 's'
+            /// </summary>
+            matrix(const matrix& other, stream& s)
+                : m_storage(other.m_storage, s), m_rows(other.m_rows), m_cols(other.m_cols) {}
+
+            size_type rows() const {
+                return m_rows;
+            }
+
+            size_type cols() const {
+                return m_cols;
+            }
+
+            size_type size() const {
+                return m_rows * m_cols;
+            }
+
+            bool empty() const {
+                return size() == 0;
+            }
+
+            _T* data() {
+                return m_storage.data();
+            }
+
+            const _T* data() const {
+                return m_storage.data();
+            }
+
+            stream& get_stream() const {
+                return m_storage.get_stream();
+            }
+
+            /// <summary>
+            /// change the shape, the values are not conserved
+            /// </summary>
+            void resize_uninitialized(size_type r, size_type c) {
+                m_storage.fit(r * c);
+                m_rows = r;
+                m_cols = c;
+            }
+
+            void set_zero() {
+                m_storage.set_zero();
+            }
+
+            matrix& operator+=(const matrix& rhs) {
+                return axpy(_T(1), rhs, "device::matrix::operator+=");
+            }
+
+            matrix& operator-=(const matrix& rhs) {
+                return axpy(_T(-1), rhs, "device::matrix::operator-=");
+            }
+
+            matrix& operator*=(_T factor) {
+                if (size() > 0)
+                    detail::check(detail::blas<_T>::scal(get_stream().blas_handle(), static_cast<int>(size()), &factor, data(), 1), "cublas scal");
+                return *this;
+            }
+
+            matrix& operator/=(_T divisor) {
+                return *this *= _T(1) / divisor;
+            }
+
+            /// <summary>
+            /// this += alpha * x, both matrices have the same layout and are added as contiguous arrays
+            /// </summary>
+            matrix& axpy(_T alpha, const matrix& x, const char* what = "device::matrix::axpy") {
+                detail::same_stream(*this, x, what);
+                if (x.rows() != rows() || x.cols() != cols())
+                    throw std::invalid_argument(std::string(what) + ": the shapes of the matrices differ");
+                if (size() > 0)
+                    detail::check(detail::blas<_T>::axpy(get_stream().blas_handle(), static_cast<int>(size()), &alpha, x.data(), 1, data(), 1), "cublas axpy");
+                return *this;
+            }
+
+            /// <summary>
+            /// upload from host memory, the shape is changed to the shape of 'src'
+            /// </summary>
+            void upload(const host_type& src) {
+                resize_uninitialized(src.rows(), src.cols());
+                m_storage.upload(src.data());
+            }
+
+            /// <summary>
+            /// download into host memory and wait for the stream, the shape of 'dst' is changed to the shape of the matrix
+            /// </summary>
+            void download(host_type& dst) const {
+                math::detail::fit(dst, rows(), cols());
+                m_storage.download(dst.data());
+            }
+
+        private:
+            detail::storage<_T> m_storage;
+            size_type m_rows;
+            size_type m_cols;
+        };
+
+        /// <summary>
+        /// arithmetic operators, the result belongs to the stream of the operands
+        /// Temporaries (e.g. A * x in A * x + y) are reused for the result.
+        /// </summary>
+        template <class _T>
+        inline vector<_T> operator+(vector<_T>&& a, const vector<_T>& b) {
+            a += b;
+            return std::move(a);
+        }
+
+        template <class _T>
+        inline vector<_T> operator+(const vector<_T>& a, vector<_T>&& b) {
+            b += a;
+            return std::move(b);
+        }
+
+        template <class _T>
+        inline vector<_T> operator+(vector<_T>&& a, vector<_T>&& b) {
+            a += b;
+            return std::move(a);
+        }
+
+        template <class _T>
+        inline vector<_T> operator+(const vector<_T>& a, const vector<_T>& b) {
+            return vector<_T>(a) + b;
+        }
+
+        template <class _T>
+        inline vector<_T> operator-(vector<_T>&& a, const vector<_T>& b) {
+            a -= b;
+            return std::move(a);
+        }
+
+        template <class _T>
+        inline vector<_T> operator-(const vector<_T>& a, const vector<_T>& b) {
+            return vector<_T>(a) - b;
+        }
+
+        template <class _T>
+        inline vector<_T> operator*(vector<_T>&& a, typename vector<_T>::value_type factor) {
+            a *= factor;
+            return std::move(a);
+        }
+
+        template <class _T>
+        inline vector<_T> operator*(const vector<_T>& a, typename vector<_T>::value_type factor) {
+            return vector<_T>(a) * factor;
+        }
+
+        template <class _T>
+        inline vector<_T> operator*(typename vector<_T>::value_type factor, vector<_T>&& a) {
+            return std::move(a) * factor;
+        }
+
+        template <class _T>
+        inline vector<_T> operator*(typename vector<_T>::value_type factor, const vector<_T>& a) {
+            return vector<_T>(a) * factor;
+        }
+
+        template <class _T>
+        inline vector<_T> operator/(vector<_T>&& a, typename vector<_T>::value_type divisor) {
+            a /= divisor;
+            return std::move(a);
+        }
+
+        template <class _T>
+        inline vector<_T> operator/(const vector<_T>& a, typename vector<_T>::value_type divisor) {
+            return vector<_T>(a) / divisor;
+        }
+
+        template <class _T, int _L>
+        inline matrix<_T, _L> operator+(matrix<_T, _L>&& a, const matrix<_T, _L>& b) {
+            a += b;
+            return std::move(a);
+        }
+
+        template <class _T, int _L>
+        inline matrix<_T, _L> operator+(const matrix<_T, _L>& a, matrix<_T, _L>&& b) {
+            b += a;
+            return std::move(b);
+        }
+
+        template <class _T, int _L>
+        inline matrix<_T, _L> operator+(matrix<_T, _L>&& a, matrix<_T, _L>&& b) {
+            a += b;
+            return std::move(a);
+        }
+
+        template <class _T, int _L>
+        inline matrix<_T, _L> operator+(const matrix<_T, _L>& a, const matrix<_T, _L>& b) {
+            return matrix<_T, _L>(a) + b;
+        }
+
+        template <class _T, int _L>
+        inline matrix<_T, _L> operator-(matrix<_T, _L>&& a, const matrix<_T, _L>& b) {
+            a -= b;
+            return std::move(a);
+        }
+
+        template <class _T, int _L>
+        inline matrix<_T, _L> operator-(const matrix<_T, _L>& a, const matrix<_T, _L>& b) {
+            return matrix<_T, _L>(a) - b;
+        }
+
+        template <class _T, int _L>
+        inline matrix<_T, _L> operator*(matrix<_T, _L>&& a, typename matrix<_T, _L>::value_type factor) {
+            a *= factor;
+            return std::move(a);
+        }
+
+        template <class _T, int _L>
+        inline matrix<_T, _L> operator*(const matrix<_T, _L>& a, typename matrix<_T, _L>::value_type factor) {
+            return matrix<_T, _L>(a) * factor;
+        }
+
+        template <class _T, int _L>
+        inline matrix<_T, _L> operator*(typename matrix<_T, _L>::value_type factor, matrix<_T, _L>&& a) {
+            return std::move(a) * factor;
+        }
+
+        template <class _T, int _L>
+        inline matrix<_T, _L> operator*(typename matrix<_T, _L>::value_type factor, const matrix<_T, _L>& a) {
+            return matrix<_T, _L>(a) * factor;
+        }
+
+        template <class _T, int _L>
+        inline matrix<_T, _L> operator/(matrix<_T, _L>&& a, typename matrix<_T, _L>::value_type divisor) {
+            a /= divisor;
+            return std::move(a);
+        }
+
+        template <class _T, int _L>
+        inline matrix<_T, _L> operator/(const matrix<_T, _L>& a, typename matrix<_T, _L>::value_type divisor) {
+            return matrix<_T, _L>(a) / divisor;
+        }
+    }
+
+    namespace eigen {
+        /// <summary>
+        /// matrix-matrix product dst = a * b with cublas gemm, dst is resized if its shape differs
+        /// </summary>
+        template <class _T, int _L1, int _L2, int _L3>
+        inline void multiply_into(device::matrix<_T, _L1>& dst, const device::matrix<_T, _L2>& a, const device::matrix<_T, _L3>& b) {
+            device::detail::same_stream(a, b, "eigen::multiply_into");
+            device::detail::same_stream(dst, a, "eigen::multiply_into");
+            if (a.cols() != b.rows())
+                throw std::invalid_argument("eigen::multiply_into: the inner dimensions of the product differ");
+            if (math::detail::aliases(dst, a) || math::detail::aliases(dst, b)) {
+                device::matrix<_T, _L1> tmp(a.rows(), b.cols(), uninitialized, dst.get_stream());
+                multiply_into(tmp, a, b);
+                dst = std::move(tmp);
+                return;
+            }
+            if (dst.rows() != a.rows() || dst.cols() != b.cols())
+                dst.resize_uninitialized(a.rows(), b.cols());
+            if (dst.empty())
+                return;
+
+            // cuBLAS is column-major: the memory of a row-major matrix is its transpose in column-major order
+            const _T one = 1;
+            const _T zero = 0;
+            const int m = static_cast<int>(dst.rows());
+            const int n = static_cast<int>(dst.cols());
+            const int k = static_cast<int>(a.cols());
+            const cublasOperation_t opA = device::matrix<_T, _L2>::row_major ? CUBLAS_OP_T : CUBLAS_OP_N;
+            const cublasOperation_t opB = device::matrix<_T, _L3>::row_major ? CUBLAS_OP_T : CUBLAS_OP_N;
+            const int lda = device::detail::leading_dimension(a);
+            const int ldb = device::detail::leading_dimension(b);
+            cublasHandle_t handle = dst.get_stream().blas_handle();
+            if constexpr (!device::matrix<_T, _L1>::row_major) {
+                device::detail::check(device::detail::blas<_T>::gemm(handle, opA, opB, m, n, k, &one, a.data(), lda, b.data(), ldb, &zero, dst.data(), std::max(1, m)), "cublas gemm");
+            }
+            else {
+                // dst^T = b^T * a^T
+                const cublasOperation_t opAt = opA == CUBLAS_OP_T ? CUBLAS_OP_N : CUBLAS_OP_T;
+                const cublasOperation_t opBt = opB == CUBLAS_OP_T ? CUBLAS_OP_N : CUBLAS_OP_T;
+                device::detail::check(device::detail::blas<_T>::gemm(handle, opBt, opAt, n, m, k, &one, b.data(), ldb, a.data(), lda, &zero, dst.data(), std::max(1, n)), "cublas gemm");
+            }
+        }
+
+        /// <summary>
+        /// matrix-vector product dst = a * x with cublas gemv, dst is resized if its size differs
+        /// </summary>
+        template <class _T, int _L>
+        inline void multiply_into(device::vector<_T>& dst, const device::matrix<_T, _L>& a, const device::vector<_T>& x) {
+            device::detail::same_stream(a, x, "eigen::multiply_into");
+            device::detail::same_stream(dst, a, "eigen::multiply_into");
+            if (a.cols() != x.size())
+                throw std::invalid_argument("eigen::multiply_into: the number of columns of the matrix differs from the size of the vector");
+            if (math::detail::aliases(dst, a) || math::detail::aliases(dst, x)) {
+                device::vector<_T> tmp(a.rows(), uninitialized, dst.get_stream());
+                multiply_into(tmp, a, x);
+                dst = std::move(tmp);
+                return;
+            }
+            if (dst.size() != a.rows())
+                dst.resize_uninitialized(a.rows());
+            if (dst.empty())
+                return;
+            if (x.empty()) {
+                dst.set_zero();
+                return;
+            }
+
+            const _T one = 1;
+            const _T zero = 0;
+            const int rows = static_cast<int>(a.rows());
+            const int cols = static_cast<int>(a.cols());
+            const int lda = device::detail::leading_dimension(a);
+            cublasHandle_t handle = dst.get_stream().blas_handle();
+            // the memory of a row-major matrix is the column-major cols x rows matrix a^T
+            if constexpr (device::matrix<_T, _L>::row_major)
+                device::detail::check(device::detail::blas<_T>::gemv(handle, CUBLAS_OP_T, cols, rows, &one, a.data(), lda, x.data(), 1, &zero, dst.data(), 1), "cublas gemv");
+            else
+                device::detail::check(device::detail::blas<_T>::gemv(handle, CUBLAS_OP_N, rows, cols, &one, a.data(), lda, x.data(), 1, &zero, dst.data(), 1), "cublas gemv");
+        }
+
+        /// <summary>
+        /// coefficient-wise product with cublas dgmm (diag(vec1) * vec2)
+        /// </summary>
+        template <class _T>
+        inline device::vector<_T> cprod(const device::vector<_T>& vec1, const device::vector<_T>& vec2) {
+            device::detail::same_stream(vec1, vec2, "eigen::cprod");
+            if (vec1.size() != vec2.size())
+                throw std::invalid_argument("eigen::cprod: the sizes of the vectors differ");
+            device::vector<_T> result(vec1.size(), uninitialized, vec1.get_stream());
+            if (result.empty())
+                return result;
+            const int n = static_cast<int>(vec1.size());
+            device::detail::check(device::detail::blas<_T>::dgmm(vec1.get_stream().blas_handle(), CUBLAS_SIDE_LEFT, n, 1, vec2.data(), n, vec1.data(), 1, result.data(), n), "cublas dgmm");
+            return result;
+        }
+
+        /// <summary>
+        /// dot product, waits for the stream
+        /// </summary>
+        template <class _T>
+        inline _T dot(const device::vector<_T>& vec1, const device::vector<_T>& vec2) {
+            device::detail::same_stream(vec1, vec2, "eigen::dot");
+            if (vec1.size() != vec2.size())
+                throw std::invalid_argument("eigen::dot: the sizes of the vectors differ");
+            _T result = 0;
+            if (vec1.size() > 0)
+                device::detail::check(device::detail::blas<_T>::dot(vec1.get_stream().blas_handle(), static_cast<int>(vec1.size()), vec1.data(), 1, vec2.data(), 1, &result), "cublas dot");
+            return result;
+        }
+
+        /// <summary>
+        /// Euclidean norm, waits for the stream
+        /// </summary>
+        template <class _T>
+        inline _T norm(const device::vector<_T>& vec) {
+            _T result = 0;
+            if (vec.size() > 0)
+                device::detail::check(device::detail::blas<_T>::nrm2(vec.get_stream().blas_handle(), static_cast<int>(vec.size()), vec.data(), 1, &result), "cublas nrm2");
+            return result;
+        }
+    }
+
+    namespace device {
+        /// <summary>
+        /// matrix-matrix product with cublas gemm, the result has the layout of 'a'
+        /// </summary>
+        template <class _T, int _L1, int _L2>
+        inline matrix<_T, _L1> operator*(const matrix<_T, _L1>& a, const matrix<_T, _L2>& b) {
+            matrix<_T, _L1> result(a.rows(), b.cols(), uninitialized, a.get_stream());
+            eigen::multiply_into(result, a, b);
+            return result;
+        }
+
+        /// <summary>
+        /// matrix-vector product with cublas gemv
+        /// </summary>
+        template <class _T, int _L>
+        inline vector<_T> operator*(const matrix<_T, _L>& a, const vector<_T>& x) {
+            vector<_T> result(a.rows(), uninitialized, a.get_stream());
+            eigen::multiply_into(result, a, x);
+            return result;
+        }
+    }
+
+    /// <summary>
+    /// upload a vector or a matrix into device memory of the stream 's'
+    /// For pageable host memory (the default resources) the call returns as soon as the host memory was read, the
+    /// transfer to the device is asynchronous.
+    /// </summary>
+    template <class _T>
+    inline device::vector<_T> to_device(const vector<_T>& src, device::stream& s = device::default_stream()) {
+        device::vector<_T> result(src.size(), uninitialized, s);
+        result.upload(src);
+        return result;
+    }
+
+    template <class _T, int _L>
+    inline device::matrix<_T, _L> to_device(const matrix<_T, Eigen::Dynamic, Eigen::Dynamic, _L>& src, device::stream& s = device::default_stream()) {
+        device::matrix<_T, _L> result(src.rows(), src.cols(), uninitialized, s);
+        result.upload(src);
+        return result;
+    }
+
+    /// <summary>
+    /// download a vector or a matrix from device memory, waits for the stream
+    /// </summary>
+    template <class _T>
+    inline vector<_T> to_host(const device::vector<_T>& src) {
+        vector<_T> result(src.size(), uninitialized);
+        src.download(result);
+        return result;
+    }
+
+    template <class _T, int _L>
+    inline matrix<_T, Eigen::Dynamic, Eigen::Dynamic, _L> to_host(const device::matrix<_T, _L>& src) {
+        matrix<_T, Eigen::Dynamic, Eigen::Dynamic, _L> result(src.rows(), src.cols(), uninitialized);
+        src.download(result);
+        return result;
+    }
+}
\ No newline at end of file
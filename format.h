@@ -0,0 +1,273 @@
+/*
+ *  format.h
+ *  Created by Matthias Kesenheimer on 19.06.22.
+ *  Copyright 2022. All rights reserved.
+ *  More information about the Eigen library at http://eigen.tuxfamily.org/dox/index.html
+ */
+
+#pragma once
+#include "vector.h"
+#include "matrix.h"
+#include <Eigen/Dense>
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+// size of the buffer of math::output_buffer in bytes
+#ifndef MATH_WRITE_BUFFER_SIZE
+#define MATH_WRITE_BUFFER_SIZE (1 << 20)
+#endif
+
+// Fast text and binary output:
+//     math::write_csv("a.csv", mat);                              // one line per row, values separated by ','
+//     math::text_format format; format.precision = 6; format.delimiter = '\t';
+//     std::cout << math::as_text(mat, format);                    // same formatting for any ostream
+//     math::output_buffer out(stream);                            // append several objects to one buffer
+//     math::write_text(out, vec); math::write_binary(out, mat);
+// The numbers are converted with std::to_chars into a large buffer, which is handed to the stream in few big
+// writes. operator<< (operators.h) keeps the aligned formatting of Eigen, which is much slower for large matrices.
+
+namespace math {
+    /// <summary>
+    /// formatting of math::write_text
+    /// </summary>
+    struct text_format {
+        int precision = -1;                                        // -1: shortest representation that reads back exactly
+        std::chars_format notation = std::chars_format::general;   // floating point values only
+        char delimiter = ',';                                      // between the values of a row
+        char newline = '\n';                                       // after each row
+    };
+
+    /// <summary>
+    /// output buffer in front of a std::ostream
+    /// The buffer is written to the stream when it is full, by flush() and by the destructor.
+    /// Write errors are reported as std::runtime_error.
+    /// </summary>
+    class output_buffer {
+    public:
+        explicit output_buffer(std::ostream& stream, size_t size = MATH_WRITE_BUFFER_SIZE)
+            : m_stream(&stream), m_data(new char[std::max<size_t>(size, 64)]), m_size(std::max<size_t>(size, 64)), m_used(0) {}
+
+        output_buffer(const output_buffer&) = delete;
+        output_buffer& operator=(const output_buffer&) = delete;
+
+        /// <summary>
+        /// writes the rest of the buffer, errors are ignored (call flush() to see them)
+        /// </summary>
+        ~output_buffer() {
+            try {
+                flush();
+            }
+            catch (...) {}
+        }
+
+        /// <summary>
+        /// append 'n' bytes, large blocks bypass the buffer
+        /// </summary>
+        void write(const char* data, size_t n) {
+            if (n > m_size - m_used)
+                write_buffer();
+            if (n >= m_size) {
+                m_stream->write(data, static_cast<std::streamsize>(n));
+                check();
+                return;
+            }
+            std::memcpy(m_data.get() + m_used, data, n);
+            m_used += n;
+        }
+
+        /// <summary>
+        /// append the raw bytes of 'n' elements
+        /// </summary>
+        template <class _T>
+        void write_binary(const _T* data, size_t n) {
+            static_assert(std::is_trivially_copyable<_T>::value, "math::output_buffer: the element type must be trivially copyable");
+            write(reinterpret_cast<const char*>(data), n * sizeof(_T));
+        }
+
+        /// <summary>
+        /// append a character
+        /// </summary>
+        void put(char c) {
+            if (m_used == m_size)
+                write_buffer();
+            m_data[m_used++] = c;
+        }
+
+        /// <summary>
+        /// append a 16 bit floating point number in text form (formatted as float)
+        /// </summary>
+        void put(Eigen::half value, const text_format& format = text_format()) {
+            put(static_cast<float>(value), format);
+        }
+
+        void put(Eigen::bfloat16 value, const text_format& format = text_format()) {
+            put(static_cast<float>(value), format);
+        }
+
+        /// <summary>
+        /// append a number in text form
+        /// </summary>
+        template <class _T>
+        void put(const _T& value, const text_format& format = text_format()) {
+            static_assert(std::is_arithmetic<_T>::value, "math::output_buffer: only numbers can be formatted");
+            for (;;) {
+                char* first = m_data.get() + m_used;
+                char* last = m_data.get() + m_size;
+                std::to_chars_result result;
+                if constexpr (std::is_floating_point<_T>::value) {
+                    if (format.precision < 0)
+                        result = std::to_chars(first, last, value, format.notation);
+                    else
+                        result = std::to_chars(first, last, value, format.notation, format.precision);
+                }
+                else if constexpr (std::is_same<_T, bool>::value)
+                    result = std::to_chars(first, last, static_cast<int>(value));
+                else
+                    result = std::to_chars(first, last, value);
+                if (result.ec == std::errc()) {
+                    m_used = static_cast<size_t>(result.ptr - m_data.get());
+                    return;
+                }
+                // the number does not fit: make room and try again
+                if (m_used > 0)
+                    write_buffer();
+                else
+                    grow();
+            }
+        }
+
+        /// <summary>
+        /// write the buffer to the stream and flush the stream
+        /// </summary>
+        void flush() {
+            write_buffer();
+            m_stream->flush();
+            check();
+        }
+
+    private:
+        void write_buffer() {
+            if (m_used == 0)
+                return;
+            m_stream->write(m_data.get(), static_cast<std::streamsize>(m_used));
+            m_used = 0;
+            check();
+        }
+
+        void grow() {
+            m_size *= 2;
+            m_data.reset(new char[m_size]);
+        }
+
+        void check() const {
+            if (!*m_stream)
+                throw std::runtime_error("math::output_buffer: write failed");
+        }
+
+        std::ostream* m_stream;
+        std::unique_ptr<char[]> m_data;
+        size_t m_size;
+        size_t m_used;
+    };
+
+    /// <summary>
+    /// write an Eigen matrix, array or expression as text, one line per row
+    /// Plain objects and maps (math::vector_view, math::matrix_view) are not copied, other expressions are
+    /// evaluated once.
+    /// </summary>
+    template <class _Derived>
+    inline void write_text(output_buffer& out, const Eigen::DenseBase<_Derived>& expr, const text_format& format = text_format()) {
+        typedef Eigen::Ref<const typename _Derived::PlainObject, 0, Eigen::Stride<Eigen::Dynamic, Eigen::Dynamic>> ref_type;
+        const ref_type m(expr.derived());
+        for (Eigen::Index r = 0; r < m.rows(); ++r) {
+            for (Eigen::Index c = 0; c < m.cols(); ++c) {
+                if (c > 0)
+                    out.put(format.delimiter);
+                out.put(m.coeff(r, c), format);
+            }
+            out.put(format.newline);
+        }
+    }
+
+    /// <summary>
+    /// write a matrix as text, one line per row
+    /// </summary>
+    template <class _T, int _R, int _C, int _L>
+    inline void write_text(output_buffer& out, const matrix<_T, _R, _C, _L>& mat, const text_format& format = text_format()) {
+        write_text(out, mat.eigen(), format);
+    }
+
+    /// <summary>
+    /// write a vector as text, one value per line (a column)
+    /// </summary>
+    template <class _T, int _N>
+    inline void write_text(output_buffer& out, const vector<_T, _N>& vec, const text_format& format = text_format()) {
+        write_text(out, vec.eigen(), format);
+    }
+
+    /// <summary>
+    /// write as text to 'stream'
+    /// </summary>
+    template <class _Object>
+    inline void write_text(std::ostream& stream, const _Object& object, const text_format& format = text_format()) {
+        output_buffer out(stream);
+        write_text(out, object, format);
+        out.flush();
+    }
+
+    /// <summary>
+    /// write a CSV file (or any other delimiter given by 'format'), throws std::runtime_error on failure
+    /// </summary>
+    template <class _Object>
+    inline void write_csv(const std::string& path, const _Object& object, const text_format& format = text_format()) {
+        std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+        if (!stream)
+            throw std::runtime_error("math::write_csv: cannot open " + path);
+        write_text(stream, object, format);
+    }
+
+    /// <summary>
+    /// append the raw elements of a matrix in its layout (no header, see math::save in io.h for a file format)
+    /// </summary>
+    template <class _T, int _R, int _C, int _L>
+    inline void write_binary(output_buffer& out, const matrix<_T, _R, _C, _L>& mat) {
+        out.write_binary(mat.data(), mat.size());
+    }
+
+    /// <summary>
+    /// append the raw elements of a vector
+    /// </summary>
+    template <class _T, int _N>
+    inline void write_binary(output_buffer& out, const vector<_T, _N>& vec) {
+        out.write_binary(vec.data(), vec.size());
+    }
+
+    /// <summary>
+    /// stream manipulator of math::as_text
+    /// </summary>
+    template <class _Object>
+    struct text_manipulator {
+        const _Object& object;
+        text_format format;
+    };
+
+    /// <summary>
+    /// stream << math::as_text(mat, format) writes 'mat' with math::write_text
+    /// </summary>
+    template <class _Object>
+    inline text_manipulator<_Object> as_text(const _Object& object, const text_format& format = text_format()) {
+        return text_manipulator<_Object>{object, format};
+    }
+
+    template <class _Object>
+    inline std::ostream& operator<< (std::ostream& stream, const text_manipulator<_Object>& manip) {
+        write_text(stream, manip.object, manip.format);
+        return stream;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,245 @@
+/*
+ *  instrument.h
+ *  Created by Matthias Kesenheimer on 19.06.22.
+ *  Copyright 2022. All rights reserved.
+ *  More information about the Eigen library at http://eigen.tuxfamily.org/dox/index.html
+ */
+
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <typeinfo>
+#include <typeindex>
+#include <vector>
+
+// Opt-in counters of the memory traffic of dynamic-size vectors and matrices, compiled in with -DMATH_INSTRUMENT:
+//     math::instrument::reset();
+//     ... code path ...
+//     math::instrument::snapshot s = math::instrument::take_snapshot();
+//     std::uint64_t n = s.of<double>().reallocations;        // per element type, s.total for all types
+//     math::instrument::set_hook(&my_profiler_callback);     // called for every event, e.g. to record call stacks
+// The counters are per element type and thread-safe (relaxed atomics). Without MATH_INSTRUMENT the events compile
+// to nothing and the snapshots are empty. Fixed-size vectors and matrices do not allocate, only their temporaries are
+// counted. Temporaries created inside of Eigen (e.g. by c = a * b without noalias) are not visible.
+
+#ifdef MATH_INSTRUMENT
+#define MATH_INSTRUMENT_EVENT(type, kind, bytes) ::math::instrument::detail::record<type>(::math::instrument::event::kind, (bytes))
+#else
+#define MATH_INSTRUMENT_EVENT(type, kind, bytes) ((void)0)
+#endif
+
+namespace math {
+    namespace instrument {
+        /// <summary>
+        /// is the instrumentation compiled in?
+        /// </summary>
+#ifdef MATH_INSTRUMENT
+        inline constexpr bool enabled = true;
+#else
+        inline constexpr bool enabled = false;
+#endif
+
+        /// <summary>
+        /// kinds of counted events
+        /// </summary>
+        enum class event {
+            allocation,   // memory block of a vector or a matrix
+            reallocation, // the capacity was changed, the elements were moved into the new block
+            copy,         // deep copy: copy construction or assignment, copy-on-write detach
+            temporary     // result of eigen::transpose/inverse or evaluation via a temporary because of aliasing (operators.h)
+        };
+
+        /// <summary>
+        /// values of the counters
+        /// </summary>
+        struct counters {
+            std::uint64_t allocations = 0;
+            std::uint64_t allocated_bytes = 0;
+            std::uint64_t reallocations = 0;
+            std::uint64_t copies = 0;
+            std::uint64_t copied_bytes = 0;     // by copies and reallocations
+            std::uint64_t temporaries = 0;
+            std::uint64_t temporary_bytes = 0;
+
+            counters& operator+=(const counters& other) {
+                allocations += other.allocations;
+                allocated_bytes += other.allocated_bytes;
+                reallocations += other.reallocations;
+                copies += other.copies;
+                copied_bytes += other.copied_bytes;
+                temporaries += other.temporaries;
+                temporary_bytes += other.temporary_bytes;
+                return *this;
+            }
+
+            counters& operator-=(const counters& other) {
+                allocations -= other.allocations;
+                allocated_bytes -= other.allocated_bytes;
+                reallocations -= other.reallocations;
+                copies -= other.copies;
+                copied_bytes -= other.copied_bytes;
+                temporaries -= other.temporaries;
+                temporary_bytes -= other.temporary_bytes;
+                return *this;
+            }
+        };
+
+        /// <summary>
+        /// difference of two snapshots, e.g. take_snapshot().total - before.total
+        /// </summary>
+        inline counters operator-(counters lhs, const counters& rhs) {
+            lhs -= rhs;
+            return lhs;
+        }
+
+        /// <summary>
+        /// counters of the element types, 'total' is the sum over all types
+        /// </summary>
+        struct snapshot {
+            struct entry {
+                std::type_index type;
+                counters values;
+            };
+
+            counters total;
+            std::vector<entry> types;
+
+            /// <summary>
+            /// counters of one element type (zero if the type has no events)
+            /// </summary>
+            counters of(const std::type_info& type) const {
+                for (const entry& e : types)
+                    if (e.type == std::type_index(type))
+                        return e.values;
+                return counters();
+            }
+
+            template <class _T>
+            counters of() const {
+                return of(typeid(_T));
+            }
+        };
+
+        /// <summary>
+        /// callback for external profilers, called for every event with the element type and the size in bytes
+        /// </summary>
+        using hook = void (*)(event kind, const std::type_info& type, std::size_t bytes);
+
+        namespace detail {
+            /// <summary>
+            /// counters of one element type, linked into a global list on first use
+            /// </summary>
+            struct type_counters {
+                explicit type_counters(const std::type_info& t)
+                    : type(&t), next(head().load(std::memory_order_relaxed)) {
+                        while (!head().compare_exchange_weak(next, this, std::memory_order_release, std::memory_order_relaxed)) {}
+                    }
+
+                static std::atomic<type_counters*>& head() {
+                    static std::atomic<type_counters*> instance(nullptr);
+                    return instance;
+                }
+
+                counters load() const {
+                    counters c;
+                    c.allocations = allocations.load(std::memory_order_relaxed);
+                    c.allocated_bytes = allocated_bytes.load(std::memory_order_relaxed);
+                    c.reallocations = reallocations.load(std::memory_order_relaxed);
+                    c.copies = copies.load(std::memory_order_relaxed);
+                    c.copied_bytes = copied_bytes.load(std::memory_order_relaxed);
+                    c.temporaries = temporaries.load(std::memory_order_relaxed);
+                    c.temporary_bytes = temporary_bytes.load(std::memory_order_relaxed);
+                    return c;
+                }
+
+                void clear() {
+                    allocations.store(0, std::memory_order_relaxed);
+                    allocated_bytes.store(0, std::memory_order_relaxed);
+                    reallocations.store(0, std::memory_order_relaxed);
+                    copies.store(0, std::memory_order_relaxed);
+                    copied_bytes.store(0, std::memory_order_relaxed);
+                    temporaries.store(0, std::memory_order_relaxed);
+                    temporary_bytes.store(0, std::memory_order_relaxed);
+                }
+
+                const std::type_info* type;
+                type_counters* next;
+                std::atomic<std::uint64_t> allocations{0};
+                std::atomic<std::uint64_t> allocated_bytes{0};
+                std::atomic<std::uint64_t> reallocations{0};
+                std::atomic<std::uint64_t> copies{0};
+                std::atomic<std::uint64_t> copied_bytes{0};
+                std::atomic<std::uint64_t> temporaries{0};
+                std::atomic<std::uint64_t> temporary_bytes{0};
+            };
+
+            inline std::atomic<hook>& hook_instance() {
+                static std::atomic<hook> instance(nullptr);
+                return instance;
+            }
+
+            template <class _T>
+            inline type_counters& counters_of() {
+                static type_counters instance(typeid(_T));
+                return instance;
+            }
+
+            /// <summary>
+            /// count an event of element type _T (use MATH_INSTRUMENT_EVENT, which compiles to nothing by default)
+            /// </summary>
+            template <class _T>
+            inline void record(event kind, std::size_t bytes) {
+                type_counters& c = counters_of<_T>();
+                switch (kind) {
+                    case event::allocation:
+                        c.allocations.fetch_add(1, std::memory_order_relaxed);
+                        c.allocated_bytes.fetch_add(bytes, std::memory_order_relaxed);
+                        break;
+                    case event::reallocation:
+                        c.reallocations.fetch_add(1, std::memory_order_relaxed);
+                        c.copied_bytes.fetch_add(bytes, std::memory_order_relaxed);
+                        break;
+                    case event::copy:
+                        c.copies.fetch_add(1, std::memory_order_relaxed);
+                        c.copied_bytes.fetch_add(bytes, std::memory_order_relaxed);
+                        break;
+                    case event::temporary:
+                        c.temporaries.fetch_add(1, std::memory_order_relaxed);
+                        c.temporary_bytes.fetch_add(bytes, std::memory_order_relaxed);
+                        break;
+                }
+                if (hook h = hook_instance().load(std::memory_order_relaxed))
+                    h(kind, typeid(_T), bytes);
+            }
+        }
+
+        /// <summary>
+        /// current values of the counters of all element types
+        /// </summary>
+        inline snapshot take_snapshot() {
+            snapshot s;
+            for (detail::type_counters* c = detail::type_counters::head().load(std::memory_order_acquire); c; c = c->next) {
+                counters values = c->load();
+                s.total += values;
+                s.types.push_back(snapshot::entry{std::type_index(*c->type), values});
+            }
+            return s;
+        }
+
+        /// <summary>
+        /// set all counters to zero
+        /// </summary>
+        inline void reset() {
+            for (detail::type_counters* c = detail::type_counters::head().load(std::memory_order_acquire); c; c = c->next)
+                c->clear();
+        }
+
+        /// <summary>
+        /// set the profiler callback (nullptr: none), returns the previous one
+        /// </summary>
+        inline hook set_hook(hook h) {
+            return detail::hook_instance().exchange(h, std::memory_order_acq_rel);
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,478 @@
+/*
+ *  io.h
+ *  Created by Matthias Kesenheimer on 19.06.22.
+ *  Copyright 2022. All rights reserved.
+ *  More information about the Eigen library at http://eigen.tuxfamily.org/dox/index.html
+ */
+
+#pragma once
+#include "vector.h"
+#include "matrix.h"
+#include "view.h"
+#include <Eigen/Dense>
+#include <type_traits>
+#include <stdexcept>
+#include <string>
+#include <fstream>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// alignment of the data in a binary file written by math::save (in bytes)
+#ifndef MATH_IO_ALIGNMENT
+#define MATH_IO_ALIGNMENT 64
+#endif
+
+// Binary persistence for math::vector and math::matrix:
+//     math::save("a.bin", mat);                              // header + raw data
+//     math::load("a.bin", mat);                              // read into a (resized) matrix
+//     math::mapped_matrix<double> view("a.bin");             // memory-mapped, opens instantly
+//     double s = view.eigen().sum();                         // pages are read on demand
+// The file starts with a 64 byte math::file_header (type, shape, layout, alignment), the data follows at
+// header.data_offset, which is a multiple of header.alignment. The data is stored in the byte order of the
+// writer, files with a different byte order are rejected.
+
+namespace math {
+    /// <summary>
+    /// element type codes of the binary format
+    /// </summary>
+    enum class dtype : std::uint32_t {
+        unknown = 0, // any other trivially copyable type, only the element size is checked
+        int8, uint8, int16, uint16, int32, uint32, int64, uint64,
+        float32, float64,
+        float16, bfloat16 // Eigen::half, Eigen::bfloat16
+    };
+
+    /// <summary>
+    /// header of the binary format (64 bytes)
+    /// </summary>
+    struct file_header {
+        char magic[8];              // "MATHBIN"
+        std::uint32_t version;      // 1
+        std::uint32_t endian;       // 0x01020304 in the byte order of the writer
+        std::uint32_t type;         // math::dtype
+        std::uint32_t element_size; // sizeof(_T)
+        std::uint32_t kind;         // 1 = vector, 2 = matrix
+        std::uint32_t layout;       // Eigen::RowMajor or Eigen::ColMajor
+        std::uint64_t rows;
+        std::uint64_t cols;
+        std::uint64_t data_offset;  // position of the first element in the file
+        std::uint32_t alignment;
+        std::uint32_t reserved;
+    };
+    static_assert(sizeof(file_header) == 64, "math::file_header: unexpected padding");
+
+    namespace detail {
+        static constexpr char file_magic[8] = {'M', 'A', 'T', 'H', 'B', 'I', 'N', '\0'};
+        static constexpr std::uint32_t file_version = 1;
+        static constexpr std::uint32_t file_endian = 0x01020304;
+        static constexpr std::uint32_t file_vector = 1;
+        static constexpr std::uint32_t file_matrix = 2;
+
+        /// <summary>
+        /// type code of _T
+        /// </summary>
+        template <class _T>
+        constexpr dtype dtype_of() {
+            if constexpr (std::is_same<_T, float>::value)
+                return dtype::float32;
+            else if constexpr (std::is_same<_T, double>::value)
+                return dtype::float64;
+            else if constexpr (std::is_same<_T, Eigen::half>::value)
+                return dtype::float16;
+            else if constexpr (std::is_same<_T, Eigen::bfloat16>::value)
+                return dtype::bfloat16;
+            else if constexpr (std::is_integral<_T>::value && !std::is_same<_T, bool>::value) {
+                switch (sizeof(_T)) {
+                    case 1: return std::is_signed<_T>::value ? dtype::int8 : dtype::uint8;
+                    case 2: return std::is_signed<_T>::value ? dtype::int16 : dtype::uint16;
+                    case 4: return std::is_signed<_T>::value ? dtype::int32 : dtype::uint32;
+                    case 8: return std::is_signed<_T>::value ? dtype::int64 : dtype::uint64;
+                    default: return dtype::unknown;
+                }
+            }
+            else
+                return dtype::unknown;
+        }
+
+        /// <summary>
+        /// header for 'rows' x 'cols' elements of type _T
+        /// </summary>
+        template <class _T>
+        inline file_header make_header(std::uint32_t kind, int layout, size_t rows, size_t cols) {
+            static_assert(std::is_trivially_copyable<_T>::value, "math::save: the element type must be trivially copyable");
+            static_assert((MATH_IO_ALIGNMENT & (MATH_IO_ALIGNMENT - 1)) == 0, "MATH_IO_ALIGNMENT must be a power of two");
+            file_header header{};
+            std::memcpy(header.magic, file_magic, sizeof(file_magic));
+            header.version = file_version;
+            header.endian = file_endian;
+            header.type = static_cast<std::uint32_t>(dtype_of<_T>());
+            header.element_size = sizeof(_T);
+            header.kind = kind;
+            header.layout = static_cast<std::uint32_t>(layout);
+            header.rows = rows;
+            header.cols = cols;
+            header.alignment = std::max<std::uint32_t>(MATH_IO_ALIGNMENT, sizeof(file_header));
+            header.data_offset = (sizeof(file_header) + header.alignment - 1) / header.alignment * header.alignment;
+            return header;
+        }
+
+        /// <summary>
+        /// throw std::runtime_error if the header is not valid or does not describe elements of type _T
+        /// </summary>
+        template <class _T>
+        inline void check_header(const file_header& header) {
+            if (std::memcmp(header.magic, file_magic, sizeof(file_magic)) != 0)
+                throw std::runtime_error("math::load: not a math binary file");
+            if (header.version != file_version)
+                throw std::runtime_error("math::load: unsupported file version");
+            if (header.endian != file_endian)
+                throw std::runtime_error("math::load: the file was written with a different byte order");
+            if (header.type != static_cast<std::uint32_t>(dtype_of<_T>()) || header.element_size != sizeof(_T))
+                throw std::runtime_error("math::load: the element type of the file does not match");
+            if (header.data_offset < sizeof(file_header))
+                throw std::runtime_error("math::load: invalid data offset");
+        }
+
+        /// <summary>
+        /// write header and data
+        /// </summary>
+        template <class _T>
+        inline void write_binary(std::ostream& stream, const file_header& header, const _T* data) {
+            static const char padding[MATH_IO_ALIGNMENT > 64 ? MATH_IO_ALIGNMENT : 64] = {};
+            stream.write(reinterpret_cast<const char*>(&header), sizeof(file_header));
+            stream.write(padding, static_cast<std::streamsize>(header.data_offset - sizeof(file_header)));
+            stream.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(header.rows * header.cols * sizeof(_T)));
+            if (!stream)
+                throw std::runtime_error("math::save: write failed");
+        }
+
+        /// <summary>
+        /// read and check the header, the stream is positioned at the first element afterwards
+        /// </summary>
+        template <class _T>
+        inline file_header read_header(std::istream& stream) {
+            file_header header;
+            if (!stream.read(reinterpret_cast<char*>(&header), sizeof(file_header)))
+                throw std::runtime_error("math::load: cannot read the header");
+            check_header<_T>(header);
+            stream.ignore(static_cast<std::streamsize>(header.data_offset - sizeof(file_header)));
+            return header;
+        }
+
+        template <class _T>
+        inline void read_data(std::istream& stream, _T* data, size_t n) {
+            if (!stream.read(reinterpret_cast<char*>(data), static_cast<std::streamsize>(n * sizeof(_T))))
+                throw std::runtime_error("math::load: the file is truncated");
+        }
+
+        inline std::ofstream open_output(const std::string& path) {
+            std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+            if (!stream)
+                throw std::runtime_error("math::save: cannot open " + path);
+            return stream;
+        }
+
+        inline std::ifstream open_input(const std::string& path) {
+            std::ifstream stream(path, std::ios::binary);
+            if (!stream)
+                throw std::runtime_error("math::load: cannot open " + path);
+            return stream;
+        }
+    }
+
+    /// <summary>
+    /// write a vector in the binary format
+    /// </summary>
+    template <class _T, int _N>
+    inline void save(std::ostream& stream, const vector<_T, _N>& vec) {
+        detail::write_binary(stream, detail::make_header<_T>(detail::file_vector, Eigen::ColMajor, vec.size(), 1), vec.data());
+    }
+
+    template <class _T, int _N>
+    inline void save(const std::string& path, const vector<_T, _N>& vec) {
+        std::ofstream stream = detail::open_output(path);
+        save(stream, vec);
+    }
+
+    /// <summary>
+    /// write a matrix in the binary format, the data is written in the layout of the matrix
+    /// </summary>
+    template <class _T, int _R, int _C, int _L>
+    inline void save(std::ostream& stream, const matrix<_T, _R, _C, _L>& mat) {
+        detail::write_binary(stream, detail::make_header<_T>(detail::file_matrix, _L, mat.rows(), mat.cols()), mat.data());
+    }
+
+    template <class _T, int _R, int _C, int _L>
+    inline void save(const std::string& path, const matrix<_T, _R, _C, _L>& mat) {
+        std::ofstream stream = detail::open_output(path);
+        save(stream, mat);
+    }
+
+    /// <summary>
+    /// read a vector (or a matrix with a single row or column) written by math::save
+    /// Throws std::runtime_error if the file is invalid, has another element type or does not fit into 'vec'.
+    /// </summary>
+    template <class _T, int _N>
+    inline void load(std::istream& stream, vector<_T, _N>& vec) {
+        const file_header header = detail::read_header<_T>(stream);
+        if (header.rows != 1 && header.cols != 1)
+            throw std::runtime_error("math::load: the file does not contain a vector");
+        const size_t n = header.rows * header.cols;
+        if constexpr (_N == Eigen::Dynamic) {
+            vec.clear();
+            vec.resize(n);
+        }
+        else if (n != vec.size())
+            throw std::runtime_error("math::load: the size of the file does not match");
+        detail::read_data(stream, vec.data(), n);
+    }
+
+    template <class _T, int _N>
+    inline void load(const std::string& path, vector<_T, _N>& vec) {
+        std::ifstream stream = detail::open_input(path);
+        load(stream, vec);
+    }
+
+    /// <summary>
+    /// read a matrix (or a vector as a column) written by math::save, a different layout is converted
+    /// Throws std::runtime_error if the file is invalid, has another element type or does not fit into 'mat'.
+    /// </summary>
+    template <class _T, int _R, int _C, int _L>
+    inline void load(std::istream& stream, matrix<_T, _R, _C, _L>& mat) {
+        const file_header header = detail::read_header<_T>(stream);
+        const size_t r = header.rows;
+        const size_t c = header.cols;
+        if constexpr (_R == Eigen::Dynamic) {
+            mat.clear();
+            mat.resize(r, c);
+        }
+        else if (r != mat.rows() || c != mat.cols())
+            throw std::runtime_error("math::load: the shape of the file does not match");
+        // vectors have the same memory in both layouts
+        if (header.layout == static_cast<std::uint32_t>(_L) || r == 1 || c == 1) {
+            detail::read_data(stream, mat.data(), r * c);
+        }
+        else {
+            using file_type = Eigen::Matrix<_T, Eigen::Dynamic, Eigen::Dynamic, _L == Eigen::RowMajor ? Eigen::ColMajor : Eigen::RowMajor>;
+            file_type tmp(r, c);
+            detail::read_data(stream, tmp.data(), r * c);
+            mat.eigen() = tmp;
+        }
+    }
+
+    template <class _T, int _R, int _C, int _L>
+    inline void load(const std::string& path, matrix<_T, _R, _C, _L>& mat) {
+        std::ifstream stream = detail::open_input(path);
+        load(stream, mat);
+    }
+
+    /// <summary>
+    /// read-only memory mapping of a whole file
+    /// </summary>
+    class mapped_file {
+    public:
+        mapped_file() noexcept
+            : m_data(nullptr), m_size(0) {}
+
+        /// <summary>
+        /// map the file 'path', throws std::runtime_error on failure
+        /// </summary>
+        explicit mapped_file(const std::string& path)
+            : m_data(nullptr), m_size(0) {
+#if defined(_WIN32)
+                HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+                if (file == INVALID_HANDLE_VALUE)
+                    throw std::runtime_error("math::mapped_file: cannot open " + path);
+                LARGE_INTEGER size;
+                if (!GetFileSizeEx(file, &size)) {
+                    CloseHandle(file);
+                    throw std::runtime_error("math::mapped_file: cannot stat " + path);
+                }
+                m_size = static_cast<size_t>(size.QuadPart);
+                if (m_size > 0) {
+                    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+                    if (mapping)
+                        m_data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+                    if (mapping)
+                        CloseHandle(mapping);
+                }
+                CloseHandle(file);
+                if (m_size > 0 && !m_data)
+                    throw std::runtime_error("math::mapped_file: cannot map " + path);
+#else
+                int fd = ::open(path.c_str(), O_RDONLY);
+                if (fd < 0)
+                    throw std::runtime_error("math::mapped_file: cannot open " + path);
+                struct stat st;
+                if (::fstat(fd, &st) != 0) {
+                    ::close(fd);
+                    throw std::runtime_error("math::mapped_file: cannot stat " + path);
+                }
+                m_size = static_cast<size_t>(st.st_size);
+                if (m_size > 0) {
+                    void* data = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+                    if (data != MAP_FAILED)
+                        m_data = data;
+                }
+                ::close(fd);
+                if (m_size > 0 && !m_data)
+                    throw std::runtime_error("math::mapped_file: cannot map " + path);
+#endif
+            }
+
+        mapped_file(const mapped_file&) = delete;
+        mapped_file& operator=(const mapped_file&) = delete;
+
+        mapped_file(mapped_file&& other) noexcept
+            : m_data(other.m_data), m_size(other.m_size) {
+                other.m_data = nullptr;
+                other.m_size = 0;
+            }
+
+        mapped_file& operator=(mapped_file&& other) noexcept {
+            if (this != &other) {
+                close();
+                std::swap(m_data, other.m_data);
+                std::swap(m_size, other.m_size);
+            }
+            return *this;
+        }
+
+        ~mapped_file() {
+            close();
+        }
+
+        /// <summary>
+        /// unmap the file
+        /// </summary>
+        void close() noexcept {
+            if (m_data) {
+#if defined(_WIN32)
+                UnmapViewOfFile(m_data);
+#else
+                ::munmap(m_data, m_size);
+#endif
+            }
+            m_data = nullptr;
+            m_size = 0;
+        }
+
+        const unsigned char* data() const noexcept {
+            return static_cast<const unsigned char*>(m_data);
+        }
+
+        size_t size() const noexcept {
+            return m_size;
+        }
+
+        bool is_open() const noexcept {
+            return m_data != nullptr;
+        }
+
+    private:
+        void* m_data;
+        size_t m_size;
+    };
+
+    namespace detail {
+        /// <summary>
+        /// mapped file with a checked header, base of mapped_vector and mapped_matrix
+        /// (a base class, such that the mapping exists before the view is constructed)
+        /// </summary>
+        template <class _T>
+        class mapped_storage {
+        public:
+            /// <summary>
+            /// header of the mapped file
+            /// </summary>
+            const file_header& header() const {
+                return m_header;
+            }
+
+        protected:
+            explicit mapped_storage(const std::string& path)
+                : m_file(path) {
+                    if (m_file.size() < sizeof(file_header))
+                        throw std::runtime_error("math::load: cannot read the header");
+                    std::memcpy(&m_header, m_file.data(), sizeof(file_header));
+                    check_header<_T>(m_header);
+                    if (m_header.data_offset + m_header.rows * m_header.cols * sizeof(_T) > m_file.size())
+                        throw std::runtime_error("math::load: the file is truncated");
+                }
+
+            const _T* mapped_data() const {
+                return reinterpret_cast<const _T*>(m_file.data() + m_header.data_offset);
+            }
+
+            mapped_file m_file;
+            file_header m_header;
+        };
+    }
+
+    /// <summary>
+    /// read-only vector view of a file written by math::save, the file is memory-mapped
+    /// The pages are read on first access, opening takes constant time independent of the file size.
+    /// The view is valid as long as the object lives.
+    /// </summary>
+    template <class _T>
+    class mapped_vector : public detail::mapped_storage<_T>, public vector_view<const _T> {
+    public:
+        using view_type = vector_view<const _T>;
+
+        explicit mapped_vector(const std::string& path)
+            : detail::mapped_storage<_T>(path), view_type(this->mapped_data(), this->m_header.rows * this->m_header.cols) {
+                if (this->m_header.rows != 1 && this->m_header.cols != 1)
+                    throw std::runtime_error("math::load: the file does not contain a vector");
+            }
+
+        mapped_vector(mapped_vector&& other) = default;
+        mapped_vector(const mapped_vector&) = delete;
+        mapped_vector& operator=(const mapped_vector&) = delete;
+    };
+
+    /// <summary>
+    /// read-only matrix view of a file written by math::save, the file is memory-mapped
+    /// _Layout must match the layout of the file: a math::matrix_view for Eigen::RowMajor, an Eigen::Map for Eigen::ColMajor.
+    /// The view is valid as long as the object lives.
+    /// </summary>
+    template <class _T, int _Layout = Eigen::RowMajor>
+    class mapped_matrix : public detail::mapped_storage<_T>,
+                          public std::conditional<_Layout == Eigen::RowMajor, matrix_view<const _T>,
+                                                  Eigen::Map<const Eigen::Matrix<_T, Eigen::Dynamic, Eigen::Dynamic, Eigen::ColMajor>>>::type {
+    public:
+        using view_type = typename std::conditional<_Layout == Eigen::RowMajor, matrix_view<const _T>,
+                                                    Eigen::Map<const Eigen::Matrix<_T, Eigen::Dynamic, Eigen::Dynamic, Eigen::ColMajor>>>::type;
+        using map_type = Eigen::Map<const Eigen::Matrix<_T, Eigen::Dynamic, Eigen::Dynamic, _Layout>, Eigen::Unaligned, Eigen::Stride<0, 0>>;
+
+        explicit mapped_matrix(const std::string& path)
+            : detail::mapped_storage<_T>(path), view_type(this->mapped_data(), this->m_header.rows, this->m_header.cols) {
+                const file_header& h = this->m_header;
+                if (h.layout != static_cast<std::uint32_t>(_Layout) && h.rows != 1 && h.cols != 1)
+                    throw std::runtime_error("math::load: the layout of the file does not match, use math::load() to convert it");
+            }
+
+        mapped_matrix(mapped_matrix&& other) = default;
+        mapped_matrix(const mapped_matrix&) = delete;
+        mapped_matrix& operator=(const mapped_matrix&) = delete;
+
+        /// <summary>
+        /// the Eigen map
+        /// </summary>
+        const map_type& eigen() const {
+            return *this;
+        }
+    };
+}
\ No newline at end of file
@@ -7,11 +7,19 @@
 
 #pragma once
 #include "vector.h"
+#include "memory.h"
 #include <Eigen/Dense>
 #include <Eigen/StdVector>
 #include <initializer_list>
 #include <vector>
-#include <atomic>
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+
+// growth factor of the row capacity if a push_back() runs out of reserved rows
+#ifndef MATH_MATRIX_GROWTH_FACTOR
+#define MATH_MATRIX_GROWTH_FACTOR 2
+#endif
 
 //#define _DEBUG
 #ifdef _DEBUG
@@ -19,113 +27,203 @@
 #endif
 
 namespace math {
+    /// <summary>
+    /// matrix class
+    /// _Rows = _Cols = Eigen::Dynamic (default): dynamic-size matrix, otherwise fixed-size matrix (see below)
+    /// _Layout = Eigen::RowMajor (default) or Eigen::ColMajor: storage order of the elements
+    /// </summary>
+    template <class _T, int _Rows = Eigen::Dynamic, int _Cols = Eigen::Dynamic, int _Layout = Eigen::RowMajor>
+    class matrix;
+
     /// <summary>
     /// matrix class
     /// Verknuepft die Daten gespeichert in m_data mit Eigen::matrix. Dadurch koennen Rechenoperationen einfacher und schneller durchgefuehrt werden.
+    /// The matrix is stored as a sequence of contiguous major vectors: rows for Eigen::RowMajor, columns for Eigen::ColMajor.
+    /// Only the number of major vectors can grow (push_back() appends a row, or a column respectively) and only
+    /// major vectors can be reserved (reserve_rows() or reserve_cols() respectively). operator[] returns a major vector.
     /// </summary>
-    template <class _T> 
-    class matrix {
+    template <class _T, int _Layout>
+    class matrix<_T, Eigen::Dynamic, Eigen::Dynamic, _Layout> {
+        static_assert(_Layout == Eigen::RowMajor || _Layout == Eigen::ColMajor, "math::matrix: the layout must be Eigen::RowMajor or Eigen::ColMajor");
+        static constexpr bool row_major = _Layout == Eigen::RowMajor;
+        static constexpr int other_layout = row_major ? Eigen::ColMajor : Eigen::RowMajor;
+        template <class, int, int, int> friend class matrix;
     public:
         /// <summary>
         /// typedefs
         /// </summary>
-        using eigen_type = Eigen::Matrix<_T, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+        using eigen_type = Eigen::Matrix<_T, Eigen::Dynamic, Eigen::Dynamic, _Layout>;
+        using transposed_eigen_type = Eigen::Matrix<_T, Eigen::Dynamic, Eigen::Dynamic, other_layout>;
         using vector_type = Eigen::Matrix<_T, Eigen::Dynamic, 1>;
         using map_type = Eigen::Map<eigen_type>;
+        using const_map_type = Eigen::Map<const eigen_type>;
+        using transposed_map_type = Eigen::Map<transposed_eigen_type>;
+        using const_transposed_map_type = Eigen::Map<const transposed_eigen_type>;
         using vector_map_type = Eigen::Map<vector_type>;
+        using const_vector_map_type = Eigen::Map<const vector_type>;
+        using row_stride_type = Eigen::InnerStride<row_major ? 1 : Eigen::Dynamic>;
+        using col_stride_type = Eigen::InnerStride<row_major ? Eigen::Dynamic : 1>;
+        using row_map_type = Eigen::Map<vector_type, Eigen::Unaligned, row_stride_type>;
+        using const_row_map_type = Eigen::Map<const vector_type, Eigen::Unaligned, row_stride_type>;
+        using col_map_type = Eigen::Map<vector_type, Eigen::Unaligned, col_stride_type>;
+        using const_col_map_type = Eigen::Map<const vector_type, Eigen::Unaligned, col_stride_type>;
+        using block_map_type = Eigen::Map<eigen_type, Eigen::Unaligned, Eigen::OuterStride<>>;
+        using const_block_map_type = Eigen::Map<const eigen_type, Eigen::Unaligned, Eigen::OuterStride<>>;
         using value_type = typename eigen_type::value_type;
         using size_type = size_t;
         using reference = value_type&;
         using const_reference = const value_type&;
         using iterator = typename vector_map_type::iterator;
-        using const_iterator = typename vector_map_type::const_iterator;
+        using const_iterator = typename const_vector_map_type::const_iterator;
         using reverse_iterator = typename std::reverse_iterator<iterator>;
         using const_reverse_iterator = typename std::reverse_iterator<const_iterator>;
+        static constexpr int layout = _Layout;
         
         /// <summary>
         /// construct a dynamic-size empty matrix
         /// </summary>
         matrix()
-            : m_eigen(0, 0), m_refCount(1), m_reserved_memory_left(0) {}
+            : m_buffer(), m_capacity_outer(0), m_inner(0), m_reserved_memory_left(0) {}
+
+        /// <summary>
+        /// construct a dynamic-size empty matrix, the memory is allocated from 'resource'
+        /// </summary>
+        explicit matrix(memory_resource* resource)
+            : m_buffer(resource), m_capacity_outer(0), m_inner(0), m_reserved_memory_left(0) {}
         
         /// <summary>
         /// construct a dynamic-size matrix with size 'rows'x'cols'
         /// </summary>
         matrix(size_type r, size_type c)
-            : m_eigen(eigen_type::Zero(r, c)), m_refCount(1), m_reserved_memory_left(0) {}
+            : m_buffer(r * c), m_capacity_outer(outer(r, c)), m_inner(inner(r, c)), m_reserved_memory_left(0) {
+                eigen().setZero();
+            }
+
+        /// <summary>
+        /// construct a dynamic-size matrix with size 'rows'x'cols', the memory is allocated from 'resource'
+        /// </summary>
+        matrix(size_type r, size_type c, memory_resource* resource)
+            : m_buffer(r * c, resource), m_capacity_outer(outer(r, c)), m_inner(inner(r, c)), m_reserved_memory_left(0) {
+                eigen().setZero();
+            }
+
+        /// <summary>
+        /// construct a dynamic-size matrix with size 'rows'x'cols', the elements are not initialized (no zero pass)
+        /// For outputs which are overwritten anyway, see eigen::fill() in parallel.h for a parallel first touch.
+        /// </summary>
+        matrix(size_type r, size_type c, uninitialized_t, memory_resource* resource = default_resource())
+            : m_buffer(r * c, resource), m_capacity_outer(outer(r, c)), m_inner(inner(r, c)), m_reserved_memory_left(0) {}
 
         /// <summary>
         /// construct a dynamic-size matrix with number of rows 'rows' and default column vectors 'vector'
         /// </summary>
         matrix(size_type r, const std::vector<_T>& v)
-            : m_eigen(matrixFromVector(r, v)), m_refCount(1), m_reserved_memory_left(0) {}
+            : m_buffer(), m_capacity_outer(0), m_inner(0), m_reserved_memory_left(0) {
+                matrixFromVector(r, v);
+            }
 
         /// <summary>
         /// construct a dynamic-size matrix with number of rows 'rows' and default column vectors 'vector'
         /// </summary>
         matrix(size_type r, const vector<_T>& v)
-            : m_eigen(matrixFromVector(r, v)), m_refCount(1), m_reserved_memory_left(0) {}
+            : m_buffer(), m_capacity_outer(0), m_inner(0), m_reserved_memory_left(0) {
+                matrixFromVector(r, v);
+            }
 
         /// <summary>
         /// construct a dynamic-size matrix with size 'cols * rows' and default value 'defaultValue'
         /// </summary>
         matrix(size_type r, size_type c, const value_type& defaultValue)
-            : m_eigen(eigen_type::Constant(r, c, defaultValue)), m_refCount(1), m_reserved_memory_left(0) {}
+            : m_buffer(r * c), m_capacity_outer(outer(r, c)), m_inner(inner(r, c)), m_reserved_memory_left(0) {
+                eigen().setConstant(defaultValue);
+            }
 
         /// <summary>
         /// construct a dynamic-size matrix from nested vector's
         /// </summary>
         matrix(const vector<vector<_T>>& mat)
-            : m_eigen(matrixFromVectors(mat)), m_refCount(1), m_reserved_memory_left(0) {}
+            : m_buffer(), m_capacity_outer(0), m_inner(0), m_reserved_memory_left(0) {
+                matrixFromVectors(mat);
+            }
 
         /// <summary>
         /// initialization by initializer list
         /// </summary>
         matrix(std::initializer_list<std::initializer_list<_T>> IList)
-            : m_eigen(matrixFromVectors(IList)), m_refCount(1), m_reserved_memory_left(0) {}
+            : m_buffer(), m_capacity_outer(0), m_inner(0), m_reserved_memory_left(0) {
+                matrixFromVectors(IList);
+            }
 
         /// <summary>
         /// initialization by initializer list
         /// </summary>
         matrix(std::initializer_list<vector<_T>> IList)
-            : m_eigen(matrixFromVectors(IList)), m_refCount(1), m_reserved_memory_left(0) {}
+            : m_buffer(), m_capacity_outer(0), m_inner(0), m_reserved_memory_left(0) {
+                matrixFromVectors(IList);
+            }
 
         /// <summary>
         /// copy constructor
+        /// If copy-on-write is enabled for 'other', the copy shares its memory until one of them is modified.
         /// </summary>
         matrix(const matrix& other)
-            : m_eigen(other.m_eigen), m_refCount(1), m_reserved_memory_left(0) {}
+            : m_buffer(other.copy_on_write() ? other.m_buffer.share() : buffer<_T>(other.size())),
+              m_capacity_outer(other.copy_on_write() ? other.m_capacity_outer : other.outer_size()), m_inner(other.m_inner),
+              m_reserved_memory_left(other.copy_on_write() ? other.m_reserved_memory_left : 0) {
+                if (!other.copy_on_write()) {
+                    MATH_INSTRUMENT_EVENT(_T, copy, other.size() * sizeof(_T));
+                    eigen() = other.eigen();
+                }
+            }
+
+        /// <summary>
+        /// copy constructor from a matrix with the other layout (the elements are reordered)
+        /// </summary>
+        explicit matrix(const matrix<_T, Eigen::Dynamic, Eigen::Dynamic, other_layout>& other)
+            : m_buffer(other.size()), m_capacity_outer(outer(other.rows(), other.cols())), m_inner(inner(other.rows(), other.cols())), m_reserved_memory_left(0) {
+                MATH_INSTRUMENT_EVENT(_T, copy, other.size() * sizeof(_T));
+                eigen() = other.eigen();
+            }
 
         /// <summary>
         /// move constructor
         /// </summary>
         matrix(matrix&& other) noexcept
-            : m_eigen(std::move(other.m_eigen)), m_refCount(1), m_reserved_memory_left(0) {}
+            : m_buffer(std::move(other.m_buffer)), m_capacity_outer(other.m_capacity_outer), m_inner(other.m_inner), m_reserved_memory_left(other.m_reserved_memory_left) {
+                other.m_capacity_outer = 0;
+                other.m_inner = 0;
+                other.m_reserved_memory_left = 0;
+            }
 
         /// <summary>
         /// construct from eigen type
         /// </summary>
         matrix(const eigen_type& eigenmat)
-            : m_eigen(eigenmat), m_refCount(1), m_reserved_memory_left(0) {}
+            : m_buffer(eigenmat.size()), m_capacity_outer(outer(eigenmat.rows(), eigenmat.cols())), m_inner(inner(eigenmat.rows(), eigenmat.cols())), m_reserved_memory_left(0) {
+                eigen() = eigenmat;
+            }
 
         /// <summary>
-        /// construct from eigen type
+        /// construct from an Eigen expression, the expression is evaluated in a single pass
         /// </summary>
-        matrix(eigen_type&& eigenmat) noexcept
-            : m_eigen(std::move(eigenmat)), m_refCount(1), m_reserved_memory_left(0) {}
+        template <class _Derived>
+        matrix(const Eigen::MatrixBase<_Derived>& expr)
+            : m_buffer(expr.size()), m_capacity_outer(outer(expr.rows(), expr.cols())), m_inner(inner(expr.rows(), expr.cols())), m_reserved_memory_left(0) {
+                eigen() = expr;
+            }
 
         /// <summary>
         /// number of rows of the matrix
         /// </summary>
         size_type rows() const {
-            return m_eigen.rows() - m_reserved_memory_left;
+            return row_major ? outer_size() : m_inner;
         }
 
         /// <summary>
         /// number of columns of the matrix
         /// </summary>
         size_type cols() const {
-            return m_eigen.cols();
+            return row_major ? m_inner : outer_size();
         }
 
         /// <summary>
@@ -135,47 +233,192 @@ namespace math {
             return cols() * rows();
         }
 
+        /// <summary>
+        /// number of rows that fit into the allocated memory (rows() for a column-major matrix)
+        /// </summary>
+        size_type capacity_rows() const {
+            return row_major ? m_capacity_outer : rows();
+        }
+
+        /// <summary>
+        /// number of columns that fit into the allocated memory (cols() for a row-major matrix)
+        /// </summary>
+        size_type capacity_cols() const {
+            return row_major ? cols() : m_capacity_outer;
+        }
+
+        /// <summary>
+        /// memory resource the matrix allocates from
+        /// </summary>
+        memory_resource* resource() const {
+            return m_buffer.resource();
+        }
+
+        /// <summary>
+        /// is copy-on-write enabled?
+        /// </summary>
+        bool copy_on_write() const {
+            return m_buffer.copy_on_write();
+        }
+
+        /// <summary>
+        /// enable or disable copy-on-write
+        /// With copy-on-write enabled, copies of the matrix share the memory with the matrix (and inherit
+        /// the mode). The memory is copied only when one of them is modified, i.e. by any non-const access
+        /// (operator[], operator(), at(), data(), eigen(), iterators, ...).
+        /// Note: pointers, maps and views obtained from a const matrix may refer to shared memory.
+        /// </summary>
+        void set_copy_on_write(bool enable) {
+            if (!enable)
+                m_buffer.detach(size());
+            m_buffer.set_copy_on_write(enable);
+        }
+
+        /// <summary>
+        /// does the matrix share its memory with a copy?
+        /// </summary>
+        bool shared() const {
+            return m_buffer.shared();
+        }
+
         /// <summary>
         /// returns the underlying data structure
         /// </summary>
         value_type* data() {
-            return m_eigen.data();
+            m_buffer.detach(size());
+            return m_buffer.data();
         }
 
         /// <summary>
         /// returns the underlying data structure
         /// </summary>
         const value_type* data() const {
-            return m_eigen.data();
+            return m_buffer.data();
         }
 
         /// <summary>
         /// returns the underlying data structure
+        /// Note: the returned map covers only the rows() rows, not the reserved rows.
         /// </summary>
-        eigen_type& eigen() {
-            return m_eigen;
+        map_type eigen() {
+            return map_type(data(), rows(), cols());
         }
 
         /// <summary>
         /// returns the underlying data structure
+        /// Note: the returned map covers only the rows() rows, not the reserved rows.
         /// </summary>
-        const eigen_type& eigen() const {
-            return m_eigen;
+        const_map_type eigen() const {
+            return const_map_type(data(), rows(), cols());
         }
 
         /// <summary>
-        /// give back the matrix as a reshaped vector 
+        /// the matrix reinterpreted as its transpose with the other layout, without copying:
+        /// a row-major r x c matrix has the same memory as the column-major c x r transpose (and vice versa)
         /// </summary>
-        const vector_map_type reshaped() const {
-            return vector_map_type(m_eigen.data(), cols(), 1);
+        transposed_map_type transposed_map() {
+            return transposed_map_type(data(), cols(), rows());
         }
 
         /// <summary>
-        /// give back the matrix as a reshaped vector
+        /// the matrix reinterpreted as its transpose with the other layout, without copying
+        /// </summary>
+        const_transposed_map_type transposed_map() const {
+            return const_transposed_map_type(data(), cols(), rows());
+        }
+
+        /// <summary>
+        /// move the memory into the transpose with the other layout, without copying:
+        ///     math::matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::ColMajor> t = std::move(m).reinterpret_transposed();
+        /// The reserved memory is kept, the matrix is empty afterwards.
+        /// </summary>
+        matrix<_T, Eigen::Dynamic, Eigen::Dynamic, other_layout> reinterpret_transposed() && {
+            matrix<_T, Eigen::Dynamic, Eigen::Dynamic, other_layout> result(resource());
+            result.m_buffer.swap(m_buffer);
+            result.m_capacity_outer = m_capacity_outer;
+            result.m_inner = m_inner;
+            result.m_reserved_memory_left = m_reserved_memory_left;
+            m_capacity_outer = 0;
+            m_inner = 0;
+            m_reserved_memory_left = 0;
+            return result;
+        }
+
+        /// <summary>
+        /// give back the matrix as a reshaped vector of all size() elements in the order of the layout
+        /// </summary>
+        const_vector_map_type reshaped() const {
+            return const_vector_map_type(data(), size(), 1);
+        }
+
+        /// <summary>
+        /// give back the matrix as a reshaped vector of all size() elements in the order of the layout
         /// </summary>
         vector_map_type reshaped() {
-            //return m_eigen.template reshaped<Eigen::RowMajor>(size(), 1);
-            return vector_map_type(m_eigen.data(), cols(), 1);
+            return vector_map_type(data(), size(), 1);
+        }
+
+        /// <summary>
+        /// row 'r' as a (column) vector, without copying
+        /// (strided for a column-major matrix)
+        /// </summary>
+        row_map_type row(const size_type r) {
+            eigen_assert(r < rows());
+            return row_map_type(data() + index(r, 0), cols(), row_stride_type(row_major ? 1 : m_inner));
+        }
+
+        const_row_map_type row(const size_type r) const {
+            eigen_assert(r < rows());
+            return const_row_map_type(data() + index(r, 0), cols(), row_stride_type(row_major ? 1 : m_inner));
+        }
+
+        /// <summary>
+        /// column 'c' as a vector, without copying
+        /// (strided for a row-major matrix)
+        /// </summary>
+        col_map_type col(const size_type c) {
+            eigen_assert(c < cols());
+            return col_map_type(data() + index(0, c), rows(), col_stride_type(row_major ? m_inner : 1));
+        }
+
+        const_col_map_type col(const size_type c) const {
+            eigen_assert(c < cols());
+            return const_col_map_type(data() + index(0, c), rows(), col_stride_type(row_major ? m_inner : 1));
+        }
+
+        /// <summary>
+        /// the h x w block with the top-left element (r, c), without copying
+        /// </summary>
+        block_map_type block(const size_type r, const size_type c, const size_type h, const size_type w) {
+            eigen_assert(r + h <= rows() && c + w <= cols());
+            return block_map_type(data() + index(r, c), h, w, Eigen::OuterStride<>(m_inner));
+        }
+
+        const_block_map_type block(const size_type r, const size_type c, const size_type h, const size_type w) const {
+            eigen_assert(r + h <= rows() && c + w <= cols());
+            return const_block_map_type(data() + index(r, c), h, w, Eigen::OuterStride<>(m_inner));
+        }
+
+        /// <summary>
+        /// the rows [first, last), without copying
+        /// </summary>
+        block_map_type rows(const size_type first, const size_type last) {
+            return block(first, 0, last - first, cols());
+        }
+
+        const_block_map_type rows(const size_type first, const size_type last) const {
+            return block(first, 0, last - first, cols());
+        }
+
+        /// <summary>
+        /// the columns [first, last), without copying
+        /// </summary>
+        block_map_type cols(const size_type first, const size_type last) {
+            return block(0, first, rows(), last - first);
+        }
+
+        const_block_map_type cols(const size_type first, const size_type last) const {
+            return block(0, first, rows(), last - first);
         }
 
         /// <summary>
@@ -183,7 +426,7 @@ namespace math {
         /// returns a const iterator
         /// </summary>
         const_iterator begin() const {
-            return reshaped().begin();
+            return reshaped().cbegin();
         }
 
         /// <summary>
@@ -199,7 +442,7 @@ namespace math {
         /// returns a const iterator
         /// </summary>
         const_iterator end() const {
-            return reshaped().end();
+            return reshaped().cend();
         }
 
         /// <summary>
@@ -215,7 +458,7 @@ namespace math {
         /// returns a const iterator
         /// </summary>
         const_reverse_iterator rbegin() const {
-            return std::reverse_iterator(reshaped().end());
+            return std::reverse_iterator(end());
         }
 
         /// <summary>
@@ -231,7 +474,7 @@ namespace math {
         /// returns a const iterator
         /// </summary>
         const_reverse_iterator rend() const {
-            return std::reverse_iterator(reshaped().begin());
+            return std::reverse_iterator(begin());
         }
 
         /// <summary>
@@ -250,271 +493,1107 @@ namespace math {
         }
 
         /// <summary>
-        /// add new row vector
+        /// add new row vector (column vector for a column-major matrix)
         /// </summary>
         template <class _Vec>
         void push_back(const _Vec& vec) {
-            size_type cols = m_eigen.cols();
-            if (m_eigen.cols() == 0)
-                cols = vec.size();
+            push_back_outer(vec.size(), [&](value_type* v) {
+                for (size_type i = 0; i < m_inner; ++i)
+                    v[i] = vec[i];
+            });
+        }
 
-#if defined(_DEBUG) || defined(DEBUG)
-            if (vector.size() != m_eigen.cols()) {
-                std::cout << "Warning: matrix::push_back: size of vector does not match the matrix layout." << std::endl;
-                std::cout << "vector.size() = " << vector.size() << ", matrix.cols() = " << m_eigen.cols() << std::endl;
+        /// <summary>
+        /// add new row vector (column vector for a column-major matrix)
+        /// </summary>
+        template <class _Vec>
+        void push_back(_Vec&& vec) noexcept {
+            push_back_outer(vec.size(), [&](value_type* v) {
+                for (size_type i = 0; i < m_inner; ++i)
+                    v[i] = std::move(vec[i]);
+            });
+        }
+
+        /// <summary>
+        /// add new row vector (column vector for a column-major matrix) by initializer list
+        /// </summary>
+        void push_back(std::initializer_list<_T> vec) {
+            push_back_outer(vec.size(), [&](value_type* v) {
+                size_type i = 0;
+                for (const auto& value : vec)
+                    v[i++] = value;
+            });
+        }
+
+        /// <summary>
+        /// append all rows of another row-major matrix with the same number of columns
+        /// Throws std::invalid_argument if the matrix has rows and the number of columns differs.
+        /// </summary>
+        void append_rows(const matrix& toAppend) {
+            static_assert(row_major, "matrix::append_rows: a column-major matrix grows by columns, use append_cols()");
+            if (toAppend.rows() > 0 && toAppend.cols() != cols()) {
+                if (rows() != 0)
+                    throw std::invalid_argument("matrix::append_rows: number of columns does not match the matrix layout");
+                resize_storage(m_capacity_outer, toAppend.cols());
             }
-#endif
+            append_outer(toAppend.data(), toAppend.rows());
+        }
 
-            if (m_reserved_memory_left > 0) {
-                for (size_type c = 0; c < m_eigen.cols(); ++c)
-                    m_eigen(rows(), c) = vec[c];
-                m_reserved_memory_left--;
-                return;
+        /// <summary>
+        /// append 'nrows' rows from a plain row-major array with cols() columns
+        /// </summary>
+        void append_rows(const value_type* data, size_type nrows) {
+            static_assert(row_major, "matrix::append_rows: a column-major matrix grows by columns, use append_cols()");
+            append_outer(data, nrows);
+        }
+
+        /// <summary>
+        /// append all columns of another column-major matrix with the same number of rows
+        /// Throws std::invalid_argument if the matrix has columns and the number of rows differs.
+        /// </summary>
+        void append_cols(const matrix& toAppend) {
+            static_assert(!row_major, "matrix::append_cols: a row-major matrix grows by rows, use append_rows()");
+            if (toAppend.cols() > 0 && toAppend.rows() != rows()) {
+                if (cols() != 0)
+                    throw std::invalid_argument("matrix::append_cols: number of rows does not match the matrix layout");
+                resize_storage(m_capacity_outer, toAppend.rows());
             }
+            append_outer(toAppend.data(), toAppend.cols());
+        }
 
-            m_eigen.conservativeResize(m_eigen.rows() + 1, cols);
-            for (size_type c = 0; c < vec.size(); ++c)
-                m_eigen(m_eigen.rows() - 1, c) = vec[c];
+        /// <summary>
+        /// append 'ncols' columns from a plain column-major array with rows() rows
+        /// </summary>
+        void append_cols(const value_type* data, size_type ncols) {
+            static_assert(!row_major, "matrix::append_cols: a row-major matrix grows by rows, use append_rows()");
+            append_outer(data, ncols);
         }
 
         /// <summary>
-        /// add new row vector
+        /// erase row 'r' of a row-major matrix, the following rows are moved up in one block
+        /// The row capacity is kept.
         /// </summary>
-        template <class _Vec>
-        void push_back(_Vec&& vec) noexcept {
-            size_type cols = m_eigen.cols();
-            if (m_eigen.cols() == 0)
-                cols = vec.size();
+        void erase_row(size_type r) {
+            static_assert(row_major, "matrix::erase_row: rows of a column-major matrix are not contiguous, use erase_col()");
+            erase_outer(r, r + 1);
+        }
 
-#if defined(_DEBUG) || defined(DEBUG)
-            if (vector.size() != m_eigen.cols()) {
-                std::cout << "Warning: matrix::push_back: size of vector does not match the matrix layout." << std::endl;
-                std::cout << "vector.size() = " << vector.size() << ", matrix.cols() = " << m_eigen.cols() << std::endl;
-            }
-#endif
+        /// <summary>
+        /// erase the rows [first, last) of a row-major matrix, the following rows are moved up in one block
+        /// The row capacity is kept.
+        /// </summary>
+        void erase_rows(size_type first, size_type last) {
+            static_assert(row_major, "matrix::erase_rows: rows of a column-major matrix are not contiguous, use erase_cols()");
+            erase_outer(first, last);
+        }
 
-            if (m_reserved_memory_left > 0) {
-                for (size_type c = 0; c < m_eigen.cols(); ++c)
-                    m_eigen(rows(), c) = std::move(vec[c]);
-                m_reserved_memory_left--;
+        /// <summary>
+        /// erase all rows for which pred(row) is true in a single pass, the order of the other rows and the row
+        /// capacity are kept
+        /// 'row' is a const_vector_map_type (like operator[]). Returns the number of erased rows.
+        /// </summary>
+        template <class _Pred>
+        size_type erase_rows_if(_Pred pred) {
+            static_assert(row_major, "matrix::erase_rows_if: rows of a column-major matrix are not contiguous, use erase_cols_if()");
+            return erase_outer_if(pred);
+        }
+
+        /// <summary>
+        /// insert all rows of another row-major matrix with the same number of columns before row 'pos'
+        /// The spare row capacity is used, the rows from 'pos' on are moved down in one block.
+        /// Throws std::invalid_argument if the matrix has rows and the number of columns differs.
+        /// </summary>
+        void insert_rows(size_type pos, const matrix& toInsert) {
+            static_assert(row_major, "matrix::insert_rows: rows of a column-major matrix are not contiguous, use insert_cols()");
+            if (&toInsert == this) {
+                matrix copy(toInsert);
+                insert_rows(pos, copy);
                 return;
             }
+            prepare_insert(toInsert.cols(), toInsert.rows());
+            insert_outer(pos, toInsert.data(), toInsert.rows());
+        }
+
+        /// <summary>
+        /// insert 'nrows' rows from a plain row-major array with cols() columns before row 'pos'
+        /// Note: data must not point into this matrix.
+        /// </summary>
+        void insert_rows(size_type pos, const value_type* data, size_type nrows) {
+            static_assert(row_major, "matrix::insert_rows: rows of a column-major matrix are not contiguous, use insert_cols()");
+            insert_outer(pos, data, nrows);
+        }
 
-            m_eigen.conservativeResize(m_eigen.rows() + 1, cols);
-            for (size_type c = 0; c < vec.size(); ++c)
-                m_eigen(m_eigen.rows() - 1, c) = std::move(vec[c]);
+        /// <summary>
+        /// erase column 'c' of a column-major matrix, the following columns are moved in one block
+        /// The column capacity is kept.
+        /// </summary>
+        void erase_col(size_type c) {
+            static_assert(!row_major, "matrix::erase_col: columns of a row-major matrix are not contiguous, use erase_row()");
+            erase_outer(c, c + 1);
         }
 
         /// <summary>
-        /// add new row vector by initializer list
+        /// erase the columns [first, last) of a column-major matrix, the following columns are moved in one block
+        /// The column capacity is kept.
         /// </summary>
-        void push_back(std::initializer_list<_T> vec) {
-            size_type cols = m_eigen.cols();
-            if (m_eigen.cols() == 0)
-                cols = vec.size();
+        void erase_cols(size_type first, size_type last) {
+            static_assert(!row_major, "matrix::erase_cols: columns of a row-major matrix are not contiguous, use erase_rows()");
+            erase_outer(first, last);
+        }
 
-#if defined(_DEBUG) || defined(DEBUG)
-            if (vector.size() != m_eigen.cols()) {
-                std::cout << "Warning: matrix::push_back: size of vector does not match the matrix layout." << std::endl;
-                std::cout << "vector.size() = " << vector.size() << ", matrix.cols() = " << m_eigen.cols() << std::endl;
-            }
-#endif
+        /// <summary>
+        /// erase all columns of a column-major matrix for which pred(column) is true in a single pass
+        /// Returns the number of erased columns.
+        /// </summary>
+        template <class _Pred>
+        size_type erase_cols_if(_Pred pred) {
+            static_assert(!row_major, "matrix::erase_cols_if: columns of a row-major matrix are not contiguous, use erase_rows_if()");
+            return erase_outer_if(pred);
+        }
 
-            if (m_reserved_memory_left > 0) {
-                size_type c = 0;
-                for (const auto& value : vec)
-                    m_eigen(rows(), c++) = value;
-                m_reserved_memory_left--;
+        /// <summary>
+        /// insert all columns of another column-major matrix with the same number of rows before column 'pos'
+        /// Throws std::invalid_argument if the matrix has columns and the number of rows differs.
+        /// </summary>
+        void insert_cols(size_type pos, const matrix& toInsert) {
+            static_assert(!row_major, "matrix::insert_cols: columns of a row-major matrix are not contiguous, use insert_rows()");
+            if (&toInsert == this) {
+                matrix copy(toInsert);
+                insert_cols(pos, copy);
                 return;
             }
+            prepare_insert(toInsert.rows(), toInsert.cols());
+            insert_outer(pos, toInsert.data(), toInsert.cols());
+        }
 
-            m_eigen.conservativeResize(m_eigen.rows() + 1, cols);
-            size_type c = 0;
-            for (const auto& value : vec)
-                m_eigen(m_eigen.rows() - 1, c) = value;
+        /// <summary>
+        /// insert 'ncols' columns from a plain column-major array with rows() rows before column 'pos'
+        /// Note: data must not point into this matrix.
+        /// </summary>
+        void insert_cols(size_type pos, const value_type* data, size_type ncols) {
+            static_assert(!row_major, "matrix::insert_cols: columns of a row-major matrix are not contiguous, use insert_rows()");
+            insert_outer(pos, data, ncols);
         }
 
         /// <summary>
         /// reserve memory for pushing back row vectors
         /// (does not change size, but subsequent push_back()'s are more efficient)
         /// Note: only rows can be reserved, since a push_back() does only increase rows and not columns.
-        /// If matrix is empty, reserve rows as well as columns.
+        /// If matrix has no rows, reserve rows as well as columns.
+        /// Throws std::invalid_argument if the matrix has rows and 'c' differs from cols().
+        /// (column-major matrices reserve columns, see reserve_cols())
         /// </summary>
         void reserve_rows(size_type r, size_type c) {
-            if ((m_eigen.rows() == 0 && m_eigen.cols() == 0) || (r > m_eigen.rows() && c == m_eigen.cols())) {
-                m_reserved_memory_left = r - m_eigen.rows();
-                m_eigen.conservativeResize(r, c);
-            }
+            static_assert(row_major, "matrix::reserve_rows: a column-major matrix grows by columns, use reserve_cols()");
+            reserve_outer(r, c);
         }
         void reserve_rows(size_type r) {
-#if defined(_DEBUG) || defined(DEBUG)
-            if (m_eigen.cols() == 0)
-                std::cout << "Error: Matrix empty. Use reserve_rows(size_type r, size_type c) instead." << std::endl;
-#endif
-            if (r > m_eigen.rows()) {
-                m_reserved_memory_left = r - m_eigen.rows();
-                m_eigen.conservativeResize(r, m_eigen.cols());
+            static_assert(row_major, "matrix::reserve_rows: a column-major matrix grows by columns, use reserve_cols()");
+            reserve_outer(r);
+        }
+
+        /// <summary>
+        /// reserve memory for pushing back column vectors into a column-major matrix
+        /// If matrix has no columns, reserve columns as well as rows.
+        /// Throws std::invalid_argument if the matrix has columns and 'r' differs from rows().
+        /// </summary>
+        void reserve_cols(size_type c, size_type r) {
+            static_assert(!row_major, "matrix::reserve_cols: a row-major matrix grows by rows, use reserve_rows()");
+            reserve_outer(c, r);
+        }
+        void reserve_cols(size_type c) {
+            static_assert(!row_major, "matrix::reserve_cols: a row-major matrix grows by rows, use reserve_rows()");
+            reserve_outer(c);
+        }
+
+        /// <summary>
+        /// release the reserved rows (columns) that are not used
+        /// </summary>
+        void shrink_to_fit() {
+            if (m_reserved_memory_left > 0) {
+                size_type n = outer_size();
+                conservative_resize(n, m_inner, n);
+                m_reserved_memory_left = 0;
             }
         }
 
         /// <summary>
         /// delete entries, leaving the container with a size of 0.
+        /// The row capacity is kept, use shrink_to_fit() to release the memory.
         /// </summary>
         void clear() {
-            m_eigen = eigen_type(0, 0);
+            m_reserved_memory_left = m_capacity_outer;
         }
 
         /// <summary>
         /// clear without change of size
         /// </summary>
         void reset() {
-            m_eigen = eigen_type::Zero(m_eigen.rows(), m_eigen.cols());
+            eigen().setZero();
         }
 
         /// <summary>
         /// assign a new size and new values to the vector
         /// </summary>
         void assign(size_type r, size_type c, const value_type& defaultValue) {
-            m_eigen = eigen_type::Constant(r, c, defaultValue);
+            resize_storage(outer(r, c), inner(r, c));
+            m_reserved_memory_left = 0;
+            eigen().setConstant(defaultValue);
         }
 
         /// <summary>
         /// resize, conserve the values
         /// </summary>
         void resize(size_type r, size_type c) {
-            m_eigen.resize(r, c);
+            size_type o = outer(r, c);
+            size_type i = inner(r, c);
+            if (i == m_inner && o <= m_capacity_outer) {
+                m_reserved_memory_left = m_capacity_outer - o;
+                return;
+            }
+            conservative_resize(o, i, outer_size());
+            m_reserved_memory_left = 0;
+        }
+
+        /// <summary>
+        /// resize without conserving the values: if the memory does not fit, new memory is allocated and nothing
+        /// is copied, all values are undefined afterwards
+        /// </summary>
+        void resize_uninitialized(size_type r, size_type c) {
+            size_type o = outer(r, c);
+            size_type i = inner(r, c);
+            if (i != m_inner || o > m_capacity_outer || shared())
+                resize_storage(o, i);
+            m_reserved_memory_left = m_capacity_outer - o;
         }
 
         /// <summary>
         /// accessing elements
         /// </summary>
         value_type& at(const size_type r, const size_type c) {
-            return m_eigen(r, c);
+            return eigen()(r, c);
         }
 
         /// <summary>
         /// accessing elements
         /// </summary>
         const value_type& at(const size_type r, const size_type c) const {
-            return m_eigen(r, c);
+            eigen_assert(r < rows() && c < cols());
+            return data()[index(r, c)];
         }
 
         /// <summary>
         /// bracket operator
         /// </summary>
         value_type& operator()(const size_type r, const size_type c) {
-            return m_eigen(r, c);
+            return eigen()(r, c);
         }
 
         /// <summary>
         /// bracket operator
         /// </summary>
         const value_type& operator()(const size_type r, const size_type c) const {
-            return m_eigen(r, c);
+            eigen_assert(r < rows() && c < cols());
+            return data()[index(r, c)];
         }
 
         /// <summary>
         /// bracket operator
+        /// returns row 'i' (column 'i' for a column-major matrix)
         /// </summary>
-        vector_map_type operator[](const size_type r) {
-            value_type* ptr = m_eigen.data() + r * cols();
-            return vector_map_type(ptr, cols(), 1);
+        vector_map_type operator[](const size_type i) {
+            value_type* ptr = data() + i * m_inner;
+            return vector_map_type(ptr, m_inner, 1);
         }
 
         /// <summary>
         /// bracket operator
+        /// returns row 'i' (column 'i' for a column-major matrix)
         /// </summary>
-        const vector_map_type operator[](const size_type r) const {
-            value_type* ptr = m_eigen.data() + r * cols();
-            return vector_map_type(ptr, cols(), 1);
+        const_vector_map_type operator[](const size_type i) const {
+            const value_type* ptr = data() + i * m_inner;
+            return const_vector_map_type(ptr, m_inner, 1);
         }
 
         /// <summary>
         /// assignment operator
         /// </summary>
-        const matrix<_T>& operator=(const matrix<_T>& rhs) {
-            if (this != &rhs)
-                m_eigen = rhs.m_eigen;
+        const matrix& operator=(const matrix& rhs) {
+            if (this != &rhs) {
+                if (rhs.copy_on_write()) {
+                    m_buffer = rhs.m_buffer.share();
+                    m_capacity_outer = rhs.m_capacity_outer;
+                    m_inner = rhs.m_inner;
+                    m_reserved_memory_left = rhs.m_reserved_memory_left;
+                    return *this;
+                }
+                MATH_INSTRUMENT_EVENT(_T, copy, rhs.size() * sizeof(_T));
+                evaluate(rhs.eigen());
+            }
             return *this;
         }
 
         /// <summary>
         /// assignment operator
         /// </summary>
-        matrix<_T>& operator=(matrix<_T>&& rhs) noexcept {
-            if (this != &rhs)
-                m_eigen = std::move(rhs.m_eigen);
+        matrix& operator=(matrix&& rhs) {
+            if (this != &rhs) {
+                m_buffer = std::move(rhs.m_buffer);
+                m_capacity_outer = rhs.m_capacity_outer;
+                m_inner = rhs.m_inner;
+                m_reserved_memory_left = rhs.m_reserved_memory_left;
+                rhs.m_buffer = buffer<_T>(rhs.resource());
+                rhs.m_capacity_outer = 0;
+                rhs.m_inner = 0;
+                rhs.m_reserved_memory_left = 0;
+            }
             return *this;
         }
 
         /// <summary>
-        /// increase the reference count
+        /// assignment operator
+        /// evaluates an Eigen expression directly into the memory of the matrix
         /// </summary>
-        void addRef() {
-            ++m_refCount;
+        template <class _Derived>
+        matrix& operator=(const Eigen::MatrixBase<_Derived>& expr) {
+            evaluate(expr);
+            return *this;
         }
 
         /// <summary>
-        /// decrese the reference count
+        /// copy with the elements converted to _U in a single (vectorized) pass, e.g. mat.cast<float>()
+        /// The layout is kept.
         /// </summary>
-        void release() {
-            if (!--m_refCount)
-                delete this;
+        template <class _U>
+        matrix<_U, Eigen::Dynamic, Eigen::Dynamic, _Layout> cast() const {
+            return matrix<_U, Eigen::Dynamic, Eigen::Dynamic, _Layout>(eigen().template cast<_U>());
         }
 
     private:
         /// <summary>
-        /// generate a matrix from a single vector
+        /// number of major vectors (rows or columns) for a r x c matrix
         /// </summary>
-        template <class _Vec>
-        const eigen_type matrixFromVector(size_type rows, const _Vec& v) {
-            eigen_type mat(rows, v.size());
-            for (size_type r = 0; r < rows; ++r)
-                for (size_type c = 0; c < v.size(); ++c)
-                    mat(r, c) = v[c];
-            return mat;
+        static size_type outer(size_type r, size_type c) {
+            return row_major ? r : c;
         }
 
         /// <summary>
-        /// generate a matrix from multiple vectors
+        /// size of the major vectors for a r x c matrix
         /// </summary>
-        template <class _Vec>
-        const eigen_type matrixFromVectors(const std::initializer_list<_Vec>& list) {
-#ifdef _DEBUG
-            size_type cols = (list.size() > 0 ? list.begin()->size() : 0);
-#else
-            size_type cols = list.begin()->size();
+        static size_type inner(size_type r, size_type c) {
+            return row_major ? c : r;
+        }
+
+        /// <summary>
+        /// number of major vectors in use
+        /// </summary>
+        size_type outer_size() const {
+            return m_capacity_outer - m_reserved_memory_left;
+        }
+
+        /// <summary>
+        /// position of element (r, c) in memory
+        /// </summary>
+        size_type index(size_type r, size_type c) const {
+            return row_major ? r * m_inner + c : c * m_inner + r;
+        }
+
+        /// <summary>
+        /// push_back() of a major vector with 'n' elements, fill(v) writes the elements to v
+        /// </summary>
+        template <class _Fill>
+        void push_back_outer(size_type n, _Fill&& fill) {
+            // the matrix has no rows (columns) yet: the first vector defines the layout
+            if (outer_size() == 0 && n != m_inner)
+                resize_storage(m_capacity_outer, n);
+
+#if defined(_DEBUG) || defined(DEBUG)
+            if (n != m_inner) {
+                std::cout << "Warning: matrix::push_back: size of vector does not match the matrix layout." << std::endl;
+                std::cout << "vector.size() = " << n << ", matrix." << (row_major ? "cols() = " : "rows() = ") << m_inner << std::endl;
+            }
 #endif
-            eigen_type mat(list.size(), cols);
-            size_type it = 0;
-            for (const auto& vec : list) // rows
-                for (const auto& value : vec) // columns
-                    mat.data()[it++] = value;
-            return mat;
+
+            size_type used = outer_size();
+            if (m_reserved_memory_left == 0) {
+                size_type capacity = next_capacity_outer(used + 1);
+                if (m_buffer.capacity() > 0)
+                    MATH_INSTRUMENT_EVENT(_T, reallocation, used * m_inner * sizeof(_T));
+                buffer<_T> b(capacity * m_inner, resource(), copy_on_write());
+                // write the new vector first, it may refer to this matrix (e.g. m.push_back(m.row(0)))
+                fill(b.data() + used * m_inner);
+                m_buffer.move_to(0, used * m_inner, b.data());
+                m_buffer.swap(b);
+                m_capacity_outer = capacity;
+                m_reserved_memory_left = capacity - used - 1;
+                return;
+            }
+            fill(data() + used * m_inner);
+            m_reserved_memory_left--;
         }
 
         /// <summary>
-        /// generate a matrix from multiple vectors
+        /// reserve 'n' major vectors with 'i' elements, see reserve_rows()
         /// </summary>
-        const eigen_type matrixFromVectors(const vector<vector<_T>>& mat) {
-#ifdef _DEBUG
-            size_type cols = (mat.size() > 0 ? mat.begin()->size() : 0);
-#else
-            size_type cols = mat.front().size();
+        void reserve_outer(size_type n, size_type i) {
+            if (outer_size() == 0 && i != m_inner) {
+                resize_storage(std::max(n, m_capacity_outer), i);
+                m_reserved_memory_left = m_capacity_outer;
+                return;
+            }
+            if (i != m_inner)
+                throw std::invalid_argument(row_major ? "matrix::reserve_rows: number of columns does not match the matrix layout"
+                                                      : "matrix::reserve_cols: number of rows does not match the matrix layout");
+            reserve_outer(n);
+        }
+        void reserve_outer(size_type n) {
+#if defined(_DEBUG) || defined(DEBUG)
+            if (m_inner == 0)
+                std::cout << "Error: Matrix empty. Use " << (row_major ? "reserve_rows(size_type r, size_type c)" : "reserve_cols(size_type c, size_type r)") << " instead." << std::endl;
 #endif
-            eigen_type matr(mat.size(), cols);
-            size_type it = 0;
-            for (const auto& vec : mat) // rows
-                for (const auto& value : vec) // columns
-                    matr.data()[it++] = value;
-            return matr;
+            if (n > m_capacity_outer) {
+                size_type used = outer_size();
+                conservative_resize(n, m_inner, used);
+                m_reserved_memory_left = n - used;
+            }
         }
 
         /// <summary>
-        /// private/underlying data structure
+        /// append 'n' major vectors with m_inner elements from a plain array in the layout of the matrix
         /// </summary>
-        eigen_type m_eigen;
-        std::atomic<int> m_refCount;
-        size_type m_reserved_memory_left;
+        void append_outer(const value_type* data, size_type n) {
+#if defined(_DEBUG) || defined(DEBUG)
+            if (m_inner == 0)
+                std::cout << "Error: Matrix empty. Use " << (row_major ? "reserve_rows(size_type r, size_type c)" : "reserve_cols(size_type c, size_type r)") << " first." << std::endl;
+#endif
+            if (n == 0)
+                return;
+            size_type used = outer_size();
+            if (n > m_reserved_memory_left) {
+                size_type capacity = next_capacity_outer(used + n);
+                if (m_buffer.capacity() > 0)
+                    MATH_INSTRUMENT_EVENT(_T, reallocation, used * m_inner * sizeof(_T));
+                buffer<_T> b(capacity * m_inner, resource(), copy_on_write());
+                // copy the new vectors first, data may point into this matrix
+                std::copy(data, data + n * m_inner, b.data() + used * m_inner);
+                m_buffer.move_to(0, used * m_inner, b.data());
+                m_buffer.swap(b);
+                m_capacity_outer = capacity;
+                m_reserved_memory_left = capacity - used - n;
+                return;
+            }
+            value_type* dst = this->data() + used * m_inner;
+            std::copy(data, data + n * m_inner, dst);
+            m_reserved_memory_left -= n;
+        }
+
+        /// <summary>
+        /// erase the major vectors [first, last), the capacity is kept
+        /// </summary>
+        void erase_outer(size_type first, size_type last) {
+            size_type used = outer_size();
+            eigen_assert(first <= last && last <= used);
+            if (first == last)
+                return;
+            value_type* d = data();
+            std::move(d + last * m_inner, d + used * m_inner, d + first * m_inner);
+            m_reserved_memory_left += last - first;
+        }
+
+        /// <summary>
+        /// erase the major vectors for which pred(vector) is true, every kept vector is moved at most once
+        /// </summary>
+        template <class _Pred>
+        size_type erase_outer_if(_Pred& pred) {
+            size_type used = outer_size();
+            value_type* d = data();
+            size_type kept = 0;
+            for (size_type k = 0; k < used; ++k) {
+                value_type* v = d + k * m_inner;
+                if (pred(const_vector_map_type(v, m_inner, 1)))
+                    continue;
+                if (kept != k)
+                    std::move(v, v + m_inner, d + kept * m_inner);
+                ++kept;
+            }
+            m_reserved_memory_left += used - kept;
+            return used - kept;
+        }
+
+        /// <summary>
+        /// check the inner size 'i' of 'n' major vectors to insert, an empty matrix takes it over
+        /// </summary>
+        void prepare_insert(size_type i, size_type n) {
+            if (n == 0 || i == m_inner)
+                return;
+            if (outer_size() != 0)
+                throw std::invalid_argument(row_major ? "matrix::insert_rows: number of columns does not match the matrix layout"
+                                                      : "matrix::insert_cols: number of rows does not match the matrix layout");
+            resize_storage(m_capacity_outer, i);
+        }
+
+        /// <summary>
+        /// insert 'n' major vectors with m_inner elements from a plain array before the major vector 'pos'
+        /// </summary>
+        void insert_outer(size_type pos, const value_type* data, size_type n) {
+            if (n == 0)
+                return;
+            size_type used = outer_size();
+            eigen_assert(pos <= used);
+            if (n > m_reserved_memory_left) {
+                size_type capacity = next_capacity_outer(used + n);
+                if (m_buffer.capacity() > 0)
+                    MATH_INSTRUMENT_EVENT(_T, reallocation, used * m_inner * sizeof(_T));
+                buffer<_T> b(capacity * m_inner, resource(), copy_on_write());
+                std::copy(data, data + n * m_inner, b.data() + pos * m_inner);
+                m_buffer.move_to(0, pos * m_inner, b.data());
+                m_buffer.move_to(pos * m_inner, (used - pos) * m_inner, b.data() + (pos + n) * m_inner);
+                m_buffer.swap(b);
+                m_capacity_outer = capacity;
+                m_reserved_memory_left = capacity - used - n;
+                return;
+            }
+            value_type* d = this->data();
+            std::move_backward(d + pos * m_inner, d + used * m_inner, d + (used + n) * m_inner);
+            std::copy(data, data + n * m_inner, d + pos * m_inner);
+            m_reserved_memory_left -= n;
+        }
+
+        /// <summary>
+        /// row (column) capacity after growing geometrically, such that at least 'required' rows (columns) fit
+        /// </summary>
+        size_type next_capacity_outer(size_type required) const {
+            size_type newCapacity = static_cast<size_type>(m_capacity_outer * MATH_MATRIX_GROWTH_FACTOR);
+            return std::max<size_type>(std::max<size_type>(newCapacity, required), 4);
+        }
+
+        /// <summary>
+        /// change the layout of the memory to 'capacityOuter' major vectors with 'i' elements, the values are not conserved
+        /// </summary>
+        void resize_storage(size_type capacityOuter, size_type i) {
+            if (capacityOuter * i != m_buffer.capacity() || shared())
+                m_buffer = buffer<_T>(capacityOuter * i, resource(), copy_on_write());
+            m_capacity_outer = capacityOuter;
+            m_inner = i;
+        }
+
+        /// <summary>
+        /// change the layout of the memory to 'capacityOuter' major vectors with 'i' elements and conserve the
+        /// values of the first 'keepOuter' major vectors (like Eigen's conservativeResize)
+        /// </summary>
+        void conservative_resize(size_type capacityOuter, size_type i, size_type keepOuter) {
+            size_type o = std::min(keepOuter, capacityOuter);
+            if (i == m_inner) {
+                m_buffer.reallocate(capacityOuter * i, o * i);
+            }
+            else {
+                buffer<_T> b(capacityOuter * i, resource(), copy_on_write());
+                size_type n = std::min(i, m_inner);
+                if (m_buffer.capacity() > 0)
+                    MATH_INSTRUMENT_EVENT(_T, reallocation, o * n * sizeof(_T));
+                for (size_type k = 0; k < o; ++k)
+                    m_buffer.move_to(k * m_inner, n, b.data() + k * i);
+                m_buffer.swap(b);
+            }
+            m_capacity_outer = capacityOuter;
+            m_inner = i;
+        }
+
+        /// <summary>
+        /// evaluate an Eigen expression into the memory of the matrix, reallocate if it does not fit
+        /// </summary>
+        template <class _Derived>
+        void evaluate(const Eigen::MatrixBase<_Derived>& expr) {
+            size_type o = outer(expr.rows(), expr.cols());
+            size_type i = inner(expr.rows(), expr.cols());
+            if (i != m_inner || o > m_capacity_outer || shared()) {
+                // evaluate into new memory first, expr may refer to this matrix
+                buffer<_T> b(o * i, resource(), copy_on_write());
+                map_type(b.data(), expr.rows(), expr.cols()) = expr;
+                m_buffer.swap(b);
+                m_capacity_outer = o;
+                m_inner = i;
+                m_reserved_memory_left = 0;
+                return;
+            }
+            m_reserved_memory_left = m_capacity_outer - o;
+            eigen() = expr;
+        }
+
+        /// <summary>
+        /// generate a matrix from a single vector
+        /// </summary>
+        template <class _Vec>
+        void matrixFromVector(size_type rows, const _Vec& v) {
+            resize_storage(outer(rows, v.size()), inner(rows, v.size()));
+            // broadcast: one block copy per row (row-major) or one fill per column (column-major)
+            eigen().rowwise() = const_vector_map_type(v.data(), v.size()).transpose();
+        }
+
+        /// <summary>
+        /// generate a matrix from multiple vectors
+        /// </summary>
+        template <class _Vec>
+        void matrixFromVectors(const std::initializer_list<_Vec>& list) {
+#ifdef _DEBUG
+            size_type cols = (list.size() > 0 ? list.begin()->size() : 0);
+#else
+            size_type cols = list.begin()->size();
+#endif
+            resize_storage(outer(list.size(), cols), inner(list.size(), cols));
+            size_type r = 0;
+            for (const auto& vec : list) { // rows
+                eigen_assert(vec.size() == cols && "math::matrix: all rows must have the same number of columns");
+                row(r++) = const_vector_map_type(data_of(vec), cols);
+            }
+        }
+
+        /// <summary>
+        /// generate a matrix from multiple vectors
+        /// </summary>
+        void matrixFromVectors(const vector<vector<_T>>& mat) {
+#ifdef _DEBUG
+            size_type cols = (mat.size() > 0 ? mat.begin()->size() : 0);
+#else
+            size_type cols = mat.front().size();
+#endif
+            resize_storage(outer(mat.size(), cols), inner(mat.size(), cols));
+            size_type r = 0;
+            for (const auto& vec : mat) { // rows
+                eigen_assert(vec.size() == cols && "math::matrix: all rows must have the same number of columns");
+                row(r++) = const_vector_map_type(vec.data(), cols);
+            }
+        }
+
+        /// <summary>
+        /// contiguous elements of a row given to matrixFromVectors()
+        /// </summary>
+        static const value_type* data_of(const std::initializer_list<_T>& list) {
+            return list.begin();
+        }
+        template <class _Vec>
+        static const value_type* data_of(const _Vec& vec) {
+            return vec.data();
+        }
+
+        /// <summary>
+        /// private/underlying data structure
+        /// m_capacity_outer: allocated rows (row-major) or columns (column-major)
+        /// m_inner: columns (row-major) or rows (column-major)
+        /// </summary>
+        buffer<_T> m_buffer;
+        size_type m_capacity_outer;
+        size_type m_inner;
+        size_type m_reserved_memory_left;
+    };
+
+    namespace detail {
+        /// <summary>
+        /// Eigen storage options of a fixed-size matrix, Eigen does not allow row-major matrices with a single
+        /// column (and column-major matrices with a single row)
+        /// </summary>
+        constexpr int matrix_options(int r, int c, int layout) {
+            return (c == 1 && r != 1) ? Eigen::ColMajor : ((r == 1 && c != 1) ? Eigen::RowMajor : layout);
+        }
+    }
+
+    /// <summary>
+    /// fixed-size matrix class
+    /// Same interface as the dynamic-size matrix, but the size is known at compile time.
+    /// The data is stored in place without heap allocation and Eigen unrolls and vectorizes the operations.
+    /// </summary>
+    template <class _T, int _Rows, int _Cols, int _Layout>
+    class matrix {
+        static_assert(_Rows > 0 && _Cols > 0, "math::matrix: the dimensions must be positive, or both Eigen::Dynamic");
+        static_assert(_Layout == Eigen::RowMajor || _Layout == Eigen::ColMajor, "math::matrix: the layout must be Eigen::RowMajor or Eigen::ColMajor");
+        static constexpr bool row_major = _Layout == Eigen::RowMajor;
+        static constexpr int other_layout = row_major ? Eigen::ColMajor : Eigen::RowMajor;
+    public:
+        /// <summary>
+        /// typedefs
+        /// </summary>
+        using eigen_type = Eigen::Matrix<_T, _Rows, _Cols, detail::matrix_options(_Rows, _Cols, _Layout)>;
+        using transposed_eigen_type = Eigen::Matrix<_T, _Cols, _Rows, detail::matrix_options(_Cols, _Rows, other_layout)>;
+        using vector_type = Eigen::Matrix<_T, row_major ? _Cols : _Rows, 1>;
+        using reshaped_type = Eigen::Matrix<_T, _Rows * _Cols, 1>;
+        using map_type = Eigen::Map<eigen_type>;
+        using const_map_type = Eigen::Map<const eigen_type>;
+        using transposed_map_type = Eigen::Map<transposed_eigen_type>;
+        using const_transposed_map_type = Eigen::Map<const transposed_eigen_type>;
+        using vector_map_type = Eigen::Map<vector_type>;
+        using const_vector_map_type = Eigen::Map<const vector_type>;
+        using reshaped_map_type = Eigen::Map<reshaped_type>;
+        using const_reshaped_map_type = Eigen::Map<const reshaped_type>;
+        using row_type = Eigen::Matrix<_T, _Cols, 1>;
+        using col_type = Eigen::Matrix<_T, _Rows, 1>;
+        using row_stride_type = Eigen::InnerStride<eigen_type::IsRowMajor ? 1 : _Rows>;
+        using col_stride_type = Eigen::InnerStride<eigen_type::IsRowMajor ? _Cols : 1>;
+        using row_map_type = Eigen::Map<row_type, Eigen::Unaligned, row_stride_type>;
+        using const_row_map_type = Eigen::Map<const row_type, Eigen::Unaligned, row_stride_type>;
+        using col_map_type = Eigen::Map<col_type, Eigen::Unaligned, col_stride_type>;
+        using const_col_map_type = Eigen::Map<const col_type, Eigen::Unaligned, col_stride_type>;
+        using block_eigen_type = Eigen::Matrix<_T, Eigen::Dynamic, Eigen::Dynamic, eigen_type::IsRowMajor ? Eigen::RowMajor : Eigen::ColMajor>;
+        using block_map_type = Eigen::Map<block_eigen_type, Eigen::Unaligned, Eigen::OuterStride<eigen_type::IsRowMajor ? _Cols : _Rows>>;
+        using const_block_map_type = Eigen::Map<const block_eigen_type, Eigen::Unaligned, Eigen::OuterStride<eigen_type::IsRowMajor ? _Cols : _Rows>>;
+        using value_type = typename eigen_type::value_type;
+        using size_type = size_t;
+        using reference = value_type&;
+        using const_reference = const value_type&;
+        using iterator = typename reshaped_map_type::iterator;
+        using const_iterator = typename const_reshaped_map_type::const_iterator;
+        using reverse_iterator = typename std::reverse_iterator<iterator>;
+        using const_reverse_iterator = typename std::reverse_iterator<const_iterator>;
+        static constexpr int layout = _Layout;
+
+        /// <summary>
+        /// construct a fixed-size matrix filled with zeros
+        /// </summary>
+        matrix()
+            : m_eigen(eigen_type::Zero()) {}
+
+        /// <summary>
+        /// construct without initializing the elements
+        /// </summary>
+        explicit matrix(uninitialized_t) {}
+
+        /// <summary>
+        /// construct from plain array in the layout of the matrix (row-major or column-major) with at least _Rows * _Cols elements
+        /// </summary>
+        explicit matrix(const value_type* v) {
+            std::copy(v, v + _Rows * _Cols, data());
+        }
+
+        /// <summary>
+        /// initialization by initializer list
+        /// </summary>
+        matrix(std::initializer_list<std::initializer_list<_T>> IList) {
+            eigen_assert(IList.size() == _Rows && "math::matrix: number of rows of the initializer list does not match");
+            size_type r = 0;
+            for (const auto& vec : IList) { // rows
+                eigen_assert(vec.size() == _Cols && "math::matrix: number of columns of the initializer list does not match");
+                m_eigen.row(r++) = Eigen::Map<const Eigen::Matrix<_T, 1, _Cols>>(vec.begin());
+            }
+        }
+
+        /// <summary>
+        /// construct from eigen type
+        /// </summary>
+        matrix(const eigen_type& eigenmat)
+            : m_eigen(eigenmat) {}
+
+        /// <summary>
+        /// construct from an Eigen expression, the expression is evaluated in a single pass
+        /// </summary>
+        template <class _Derived>
+        matrix(const Eigen::MatrixBase<_Derived>& expr)
+            : m_eigen(expr) {}
+
+        /// <summary>
+        /// number of rows of the matrix
+        /// </summary>
+        static constexpr size_type rows() {
+            return _Rows;
+        }
+
+        /// <summary>
+        /// number of columns of the matrix
+        /// </summary>
+        static constexpr size_type cols() {
+            return _Cols;
+        }
+
+        /// <summary>
+        /// total size
+        /// </summary>
+        static constexpr size_type size() {
+            return _Rows * _Cols;
+        }
+
+        /// <summary>
+        /// is the matrix empty?
+        /// </summary>
+        static constexpr bool empty() {
+            return false;
+        }
+
+        /// <summary>
+        /// returns the underlying data structure
+        /// </summary>
+        value_type* data() {
+            return m_eigen.data();
+        }
+
+        /// <summary>
+        /// returns the underlying data structure
+        /// </summary>
+        const value_type* data() const {
+            return m_eigen.data();
+        }
+
+        /// <summary>
+        /// returns the underlying data structure
+        /// </summary>
+        eigen_type& eigen() {
+            return m_eigen;
+        }
+
+        /// <summary>
+        /// returns the underlying data structure
+        /// </summary>
+        const eigen_type& eigen() const {
+            return m_eigen;
+        }
+
+        /// <summary>
+        /// the matrix reinterpreted as its transpose with the other layout, without copying
+        /// </summary>
+        transposed_map_type transposed_map() {
+            return transposed_map_type(m_eigen.data());
+        }
+
+        /// <summary>
+        /// the matrix reinterpreted as its transpose with the other layout, without copying
+        /// </summary>
+        const_transposed_map_type transposed_map() const {
+            return const_transposed_map_type(m_eigen.data());
+        }
+
+        /// <summary>
+        /// the transpose with the other layout, the memory is copied as it is (no reordering)
+        /// </summary>
+        matrix<_T, _Cols, _Rows, other_layout> reinterpret_transposed() const {
+            return matrix<_T, _Cols, _Rows, other_layout>(m_eigen.data());
+        }
+
+        /// <summary>
+        /// give back the matrix as a reshaped vector
+        /// </summary>
+        const_reshaped_map_type reshaped() const {
+            return const_reshaped_map_type(m_eigen.data());
+        }
+
+        /// <summary>
+        /// give back the matrix as a reshaped vector
+        /// </summary>
+        reshaped_map_type reshaped() {
+            return reshaped_map_type(m_eigen.data());
+        }
+
+        /// <summary>
+        /// row 'r' as a (column) vector, without copying
+        /// </summary>
+        row_map_type row(const size_type r) {
+            eigen_assert(r < _Rows);
+            return row_map_type(&m_eigen(r, 0));
+        }
+
+        const_row_map_type row(const size_type r) const {
+            eigen_assert(r < _Rows);
+            return const_row_map_type(&m_eigen(r, 0));
+        }
+
+        /// <summary>
+        /// column 'c' as a vector, without copying
+        /// </summary>
+        col_map_type col(const size_type c) {
+            eigen_assert(c < _Cols);
+            return col_map_type(&m_eigen(0, c));
+        }
+
+        const_col_map_type col(const size_type c) const {
+            eigen_assert(c < _Cols);
+            return const_col_map_type(&m_eigen(0, c));
+        }
+
+        /// <summary>
+        /// the h x w block with the top-left element (r, c), without copying
+        /// (use eigen().template block<h, w>(r, c) for blocks with a size known at compile time)
+        /// </summary>
+        block_map_type block(const size_type r, const size_type c, const size_type h, const size_type w) {
+            eigen_assert(r + h <= _Rows && c + w <= _Cols);
+            return block_map_type(m_eigen.data() + offset(r, c), h, w);
+        }
+
+        const_block_map_type block(const size_type r, const size_type c, const size_type h, const size_type w) const {
+            eigen_assert(r + h <= _Rows && c + w <= _Cols);
+            return const_block_map_type(m_eigen.data() + offset(r, c), h, w);
+        }
+
+        /// <summary>
+        /// the rows [first, last), without copying
+        /// </summary>
+        block_map_type rows(const size_type first, const size_type last) {
+            return block(first, 0, last - first, _Cols);
+        }
+
+        const_block_map_type rows(const size_type first, const size_type last) const {
+            return block(first, 0, last - first, _Cols);
+        }
+
+        /// <summary>
+        /// the columns [first, last), without copying
+        /// </summary>
+        block_map_type cols(const size_type first, const size_type last) {
+            return block(0, first, _Rows, last - first);
+        }
+
+        const_block_map_type cols(const size_type first, const size_type last) const {
+            return block(0, first, _Rows, last - first);
+        }
+
+        /// <summary>
+        /// begin of data container
+        /// returns a const iterator
+        /// </summary>
+        const_iterator begin() const {
+            return reshaped().begin();
+        }
+
+        /// <summary>
+        /// begin of data container
+        /// returns an iterator
+        /// </summary>
+        iterator begin() {
+            return reshaped().begin();
+        }
+
+        /// <summary>
+        /// end of data container
+        /// returns a const iterator
+        /// </summary>
+        const_iterator end() const {
+            return reshaped().end();
+        }
+
+        /// <summary>
+        /// end of data container
+        /// returns an iterator
+        /// </summary>
+        iterator end() {
+            return reshaped().end();
+        }
+
+        /// <summary>
+        /// rbegin of data container
+        /// returns a const iterator
+        /// </summary>
+        const_reverse_iterator rbegin() const {
+            return std::reverse_iterator(end());
+        }
+
+        /// <summary>
+        /// rbegin of data container
+        /// returns an iterator
+        /// </summary>
+        reverse_iterator rbegin() {
+            return std::reverse_iterator(end());
+        }
+
+        /// <summary>
+        /// rend of data container
+        /// returns a const iterator
+        /// </summary>
+        const_reverse_iterator rend() const {
+            return std::reverse_iterator(begin());
+        }
+
+        /// <summary>
+        /// rend of data container
+        /// returns an iterator
+        /// </summary>
+        reverse_iterator rend() {
+            return std::reverse_iterator(begin());
+        }
+
+        /// <summary>
+        /// clear without change of size
+        /// </summary>
+        void reset() {
+            m_eigen.setZero();
+        }
+
+        /// <summary>
+        /// assign a new value to all elements
+        /// </summary>
+        void fill(const value_type& value) {
+            m_eigen.setConstant(value);
+        }
+
+        /// <summary>
+        /// accessing elements
+        /// </summary>
+        value_type& at(const size_type r, const size_type c) {
+            return m_eigen(r, c);
+        }
+
+        /// <summary>
+        /// accessing elements
+        /// </summary>
+        const value_type& at(const size_type r, const size_type c) const {
+            return m_eigen(r, c);
+        }
+
+        /// <summary>
+        /// bracket operator
+        /// </summary>
+        value_type& operator()(const size_type r, const size_type c) {
+            return m_eigen(r, c);
+        }
+
+        /// <summary>
+        /// bracket operator
+        /// </summary>
+        const value_type& operator()(const size_type r, const size_type c) const {
+            return m_eigen(r, c);
+        }
+
+        /// <summary>
+        /// bracket operator
+        /// returns row 'i' (column 'i' for a column-major matrix)
+        /// </summary>
+        vector_map_type operator[](const size_type i) {
+            return vector_map_type(m_eigen.data() + i * vector_type::RowsAtCompileTime);
+        }
+
+        /// <summary>
+        /// bracket operator
+        /// returns row 'i' (column 'i' for a column-major matrix)
+        /// </summary>
+        const_vector_map_type operator[](const size_type i) const {
+            return const_vector_map_type(m_eigen.data() + i * vector_type::RowsAtCompileTime);
+        }
+
+        /// <summary>
+        /// assignment operator
+        /// evaluates an Eigen expression directly into the memory of the matrix
+        /// </summary>
+        template <class _Derived>
+        matrix& operator=(const Eigen::MatrixBase<_Derived>& expr) {
+            m_eigen = expr;
+            return *this;
+        }
+
+        /// <summary>
+        /// copy with the elements converted to _U, e.g. mat.cast<float>()
+        /// </summary>
+        template <class _U>
+        matrix<_U, _Rows, _Cols, _Layout> cast() const {
+            return matrix<_U, _Rows, _Cols, _Layout>(m_eigen.template cast<_U>());
+        }
+
+        EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+    private:
+        /// <summary>
+        /// position of element (r, c) in memory
+        /// </summary>
+        static constexpr size_type offset(size_type r, size_type c) {
+            return eigen_type::IsRowMajor ? r * _Cols + c : c * _Rows + r;
+        }
+
+        /// <summary>
+        /// private/underlying data structure
+        /// </summary>
+        eigen_type m_eigen;
     };
 }
\ No newline at end of file
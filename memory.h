@@ -0,0 +1,523 @@
+/*
+ *  memory.h
+ *  Created by Matthias Kesenheimer on 19.06.22.
+ *  Copyright 2022. All rights reserved.
+ *  More information about the Eigen library at http://eigen.tuxfamily.org/dox/index.html
+ */
+
+#pragma once
+#include "instrument.h"
+#include <Eigen/Dense>
+#include <memory_resource>
+#include <memory>
+#include <atomic>
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+namespace math {
+    /// <summary>
+    /// all dynamic-size vectors and matrices allocate their memory from a std::pmr::memory_resource
+    /// </summary>
+    using memory_resource = std::pmr::memory_resource;
+
+    /// <summary>
+    /// memory resource using the aligned malloc of Eigen (default)
+    /// </summary>
+    class aligned_resource : public memory_resource {
+    private:
+        void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+            if (alignment <= EIGEN_MAX_ALIGN_BYTES || alignment <= alignof(std::max_align_t))
+                return Eigen::internal::aligned_malloc(bytes);
+            return ::operator new(bytes, std::align_val_t(alignment));
+        }
+
+        void do_deallocate(void* ptr, std::size_t bytes, std::size_t alignment) override {
+            if (alignment <= EIGEN_MAX_ALIGN_BYTES || alignment <= alignof(std::max_align_t))
+                Eigen::internal::aligned_free(ptr);
+            else
+                ::operator delete(ptr, bytes, std::align_val_t(alignment));
+        }
+
+        bool do_is_equal(const memory_resource& other) const noexcept override {
+            return this == &other;
+        }
+    };
+
+    namespace detail {
+        /// <summary>
+        /// the memory resource that is used if no other resource is set
+        /// </summary>
+        inline memory_resource* aligned_resource_instance() {
+            static aligned_resource resource;
+            return &resource;
+        }
+
+        /// <summary>
+        /// current default resource of this thread
+        /// </summary>
+        inline memory_resource*& thread_resource() {
+            thread_local memory_resource* resource = aligned_resource_instance();
+            return resource;
+        }
+    }
+
+    /// <summary>
+    /// memory resource used by vectors and matrices that are constructed without an explicit resource
+    /// (including the results of operators.h and copies) in the current thread
+    /// </summary>
+    inline memory_resource* default_resource() {
+        return detail::thread_resource();
+    }
+
+    /// <summary>
+    /// set the default memory resource of the current thread, returns the previous one
+    /// nullptr restores Eigen's aligned malloc
+    /// </summary>
+    inline memory_resource* set_default_resource(memory_resource* resource) {
+        memory_resource* previous = detail::thread_resource();
+        detail::thread_resource() = (resource ? resource : detail::aligned_resource_instance());
+        return previous;
+    }
+
+    /// <summary>
+    /// sets the default memory resource of the current thread for the lifetime of the object
+    /// usage:
+    ///     math::arena arena;
+    ///     {
+    ///         math::resource_scope scope(&arena);
+    ///         ... all temporaries are allocated in the arena ...
+    ///     }
+    ///     arena.reset();
+    /// Move construction takes over the memory and the resource of the source. Move assignment keeps the resource
+    /// of the destination and copies the elements if the resources differ, i.e. a vector created before the scope,
+    /// which is assigned a temporary of the arena, does not refer to arena memory after arena.reset(). swap()
+    /// exchanges the resources.
+    /// </summary>
+    class resource_scope {
+    public:
+        explicit resource_scope(memory_resource* resource)
+            : m_previous(math::set_default_resource(resource)) {}
+
+        ~resource_scope() {
+            math::set_default_resource(m_previous);
+        }
+
+        resource_scope(const resource_scope&) = delete;
+        resource_scope& operator=(const resource_scope&) = delete;
+
+    private:
+        memory_resource* m_previous;
+    };
+
+    /// <summary>
+    /// monotonic arena
+    /// Allocation bumps a pointer, deallocation does nothing. reset() drops all allocations at once
+    /// and keeps the blocks for reuse. Not thread-safe: use one arena per thread.
+    /// </summary>
+    class arena : public memory_resource {
+    public:
+        using size_type = size_t;
+
+        /// <summary>
+        /// 'blockSize': size of the blocks requested from the upstream resource
+        /// </summary>
+        explicit arena(size_type blockSize = 1 << 20, memory_resource* upstream = detail::aligned_resource_instance())
+            : m_blockSize(blockSize), m_upstream(upstream), m_current(0), m_offset(0) {}
+
+        ~arena() {
+            release();
+        }
+
+        arena(const arena&) = delete;
+        arena& operator=(const arena&) = delete;
+
+        /// <summary>
+        /// drop all allocations, the memory blocks are kept for the next allocations
+        /// </summary>
+        void reset() {
+            m_current = 0;
+            m_offset = 0;
+        }
+
+        /// <summary>
+        /// drop all allocations and return the memory blocks to the upstream resource
+        /// </summary>
+        void release() {
+            for (const auto& b : m_blocks)
+                m_upstream->deallocate(b.ptr, b.size, alignment);
+            m_blocks.clear();
+            reset();
+        }
+
+        /// <summary>
+        /// number of bytes requested from the upstream resource
+        /// </summary>
+        size_type reserved_bytes() const {
+            size_type bytes = 0;
+            for (const auto& b : m_blocks)
+                bytes += b.size;
+            return bytes;
+        }
+
+    private:
+        static constexpr size_type alignment = std::max<size_type>(EIGEN_MAX_ALIGN_BYTES, alignof(std::max_align_t));
+
+        struct block {
+            void* ptr;
+            size_type size;
+        };
+
+        void* do_allocate(std::size_t bytes, std::size_t align) override {
+            while (m_current < m_blocks.size()) {
+                if (void* ptr = bump(m_blocks[m_current], bytes, align))
+                    return ptr;
+                // the allocation does not fit into the current block, continue with the next one
+                ++m_current;
+                m_offset = 0;
+            }
+
+            size_type size = std::max<size_type>(m_blockSize, bytes + align);
+            m_blocks.push_back(block{m_upstream->allocate(size, alignment), size});
+            m_current = m_blocks.size() - 1;
+            m_offset = 0;
+            return bump(m_blocks.back(), bytes, align);
+        }
+
+        /// <summary>
+        /// allocate from the block 'b', returns nullptr if the allocation does not fit
+        /// </summary>
+        void* bump(const block& b, size_type bytes, size_type align) {
+            std::uintptr_t begin = reinterpret_cast<std::uintptr_t>(b.ptr);
+            std::uintptr_t ptr = (begin + m_offset + align - 1) & ~(static_cast<std::uintptr_t>(align) - 1);
+            if (ptr + bytes > begin + b.size)
+                return nullptr;
+            m_offset = ptr + bytes - begin;
+            return reinterpret_cast<void*>(ptr);
+        }
+
+        void do_deallocate(void*, std::size_t, std::size_t) override {}
+
+        bool do_is_equal(const memory_resource& other) const noexcept override {
+            return this == &other;
+        }
+
+        std::vector<block> m_blocks;
+        size_type m_blockSize;
+        memory_resource* m_upstream;
+        size_type m_current;
+        size_type m_offset;
+    };
+
+    /// <summary>
+    /// pool with size classes
+    /// Requests are rounded up to the next power of two and served from per-class free lists,
+    /// requests larger than 'maxBlockSize' are forwarded to the upstream resource.
+    /// Not thread-safe: use one pool per thread.
+    /// </summary>
+    class pool : public memory_resource {
+    public:
+        using size_type = size_t;
+
+        explicit pool(size_type maxBlockSize = 1 << 20, size_type blocksPerChunk = 16, memory_resource* upstream = detail::aligned_resource_instance())
+            : m_maxBlockSize(std::max(next_pow2(maxBlockSize), min_block_size)), m_blocksPerChunk(std::max<size_type>(blocksPerChunk, 1)),
+              m_upstream(upstream), m_freeLists(class_index(m_maxBlockSize) + 1, nullptr) {}
+
+        ~pool() {
+            release();
+        }
+
+        pool(const pool&) = delete;
+        pool& operator=(const pool&) = delete;
+
+        /// <summary>
+        /// return all memory to the upstream resource
+        /// Attention: all memory that was allocated from the pool is invalid afterwards.
+        /// </summary>
+        void release() {
+            for (const auto& c : m_chunks)
+                m_upstream->deallocate(c.ptr, c.size, alignment);
+            m_chunks.clear();
+            std::fill(m_freeLists.begin(), m_freeLists.end(), nullptr);
+        }
+
+    private:
+        static constexpr size_type alignment = std::max<size_type>(EIGEN_MAX_ALIGN_BYTES, alignof(std::max_align_t));
+        static constexpr size_type min_block_size = std::max<size_type>(64, alignment);
+
+        struct node {
+            node* next;
+        };
+
+        struct chunk {
+            void* ptr;
+            size_type size;
+        };
+
+        static size_type next_pow2(size_type n) {
+            size_type p = 1;
+            while (p < n)
+                p <<= 1;
+            return p;
+        }
+
+        static size_type class_index(size_type blockSize) {
+            size_type index = 0;
+            for (size_type s = min_block_size; s < blockSize; s <<= 1)
+                ++index;
+            return index;
+        }
+
+        void* do_allocate(std::size_t bytes, std::size_t align) override {
+            size_type blockSize = std::max(next_pow2(bytes), min_block_size);
+            if (blockSize > m_maxBlockSize || align > alignment)
+                return m_upstream->allocate(bytes, std::max<size_type>(align, alignment));
+
+            node*& head = m_freeLists[class_index(blockSize)];
+            if (!head) {
+                // refill the free list of this size class with a new chunk
+                size_type size = blockSize * m_blocksPerChunk;
+                char* ptr = static_cast<char*>(m_upstream->allocate(size, alignment));
+                m_chunks.push_back(chunk{ptr, size});
+                for (size_type i = m_blocksPerChunk; i-- > 0;) {
+                    node* n = reinterpret_cast<node*>(ptr + i * blockSize);
+                    n->next = head;
+                    head = n;
+                }
+            }
+            node* n = head;
+            head = n->next;
+            return n;
+        }
+
+        void do_deallocate(void* ptr, std::size_t bytes, std::size_t align) override {
+            size_type blockSize = std::max(next_pow2(bytes), min_block_size);
+            if (blockSize > m_maxBlockSize || align > alignment) {
+                m_upstream->deallocate(ptr, bytes, std::max<size_type>(align, alignment));
+                return;
+            }
+            node*& head = m_freeLists[class_index(blockSize)];
+            node* n = static_cast<node*>(ptr);
+            n->next = head;
+            head = n;
+        }
+
+        bool do_is_equal(const memory_resource& other) const noexcept override {
+            return this == &other;
+        }
+
+        size_type m_maxBlockSize;
+        size_type m_blocksPerChunk;
+        memory_resource* m_upstream;
+        std::vector<node*> m_freeLists;
+        std::vector<chunk> m_chunks;
+    };
+
+    /// <summary>
+    /// tag of the constructors which do not initialize the elements, e.g. math::vector<double> v(n, math::uninitialized)
+    /// </summary>
+    struct uninitialized_t {
+        explicit uninitialized_t() = default;
+    };
+    inline constexpr uninitialized_t uninitialized{};
+
+    /// <summary>
+    /// aligned memory block with a fixed capacity allocated from a memory resource
+    /// used as storage of the dynamic-size vector and matrix
+    /// All 'capacity()' elements are constructed.
+    /// Copy-on-write: if enabled, share() returns a second buffer referring to the same memory.
+    /// The counter of the shared memory is only allocated for copy-on-write buffers.
+    /// The owner has to call detach() before it writes into memory which is shared().
+    /// </summary>
+    template <class _T>
+    class buffer {
+    public:
+        using size_type = size_t;
+
+        explicit buffer(memory_resource* resource = default_resource())
+            : m_data(nullptr), m_capacity(0), m_resource(resource), m_shares(nullptr) {}
+
+        explicit buffer(size_type capacity, memory_resource* resource = default_resource(), bool copyOnWrite = false)
+            : m_data(nullptr), m_capacity(0), m_resource(resource), m_shares(nullptr) {
+            m_data = allocate(capacity);
+            m_capacity = capacity;
+            set_copy_on_write(copyOnWrite);
+        }
+
+        buffer(buffer&& other) noexcept
+            : m_data(other.m_data), m_capacity(other.m_capacity), m_resource(other.m_resource), m_shares(other.m_shares) {
+            other.m_data = nullptr;
+            other.m_capacity = 0;
+            other.m_shares = nullptr;
+        }
+
+        /// <summary>
+        /// move assignment, the buffer keeps its memory resource (like the std::pmr containers)
+        /// The memory of 'other' is taken over if both resources are equal, otherwise the elements are moved (copied if
+        /// shared) into memory of the own resource. Therefore, a long-lived buffer never adopts e.g. arena memory.
+        /// </summary>
+        buffer& operator=(buffer&& other) {
+            if (m_resource == other.m_resource || m_resource->is_equal(*other.m_resource)) {
+                swap(other);
+                return *this;
+            }
+            MATH_INSTRUMENT_EVENT(_T, copy, other.m_capacity * sizeof(_T));
+            buffer b(other.m_capacity, m_resource, other.copy_on_write());
+            other.move_to(0, other.m_capacity, b.m_data);
+            swap(b);
+            return *this;
+        }
+
+        buffer(const buffer&) = delete;
+        buffer& operator=(const buffer&) = delete;
+
+        ~buffer() {
+            release();
+        }
+
+        _T* data() {
+            return m_data;
+        }
+
+        const _T* data() const {
+            return m_data;
+        }
+
+        size_type capacity() const {
+            return m_capacity;
+        }
+
+        memory_resource* resource() const {
+            return m_resource;
+        }
+
+        /// <summary>
+        /// is copy-on-write enabled?
+        /// </summary>
+        bool copy_on_write() const {
+            return m_shares != nullptr;
+        }
+
+        /// <summary>
+        /// enable or disable copy-on-write, the buffer must not be shared() when disabling
+        /// </summary>
+        void set_copy_on_write(bool enable) {
+            if (enable && !m_shares) {
+                void* ptr = m_resource->allocate(sizeof(std::atomic<int>), alignof(std::atomic<int>));
+                m_shares = new (ptr) std::atomic<int>(1);
+            }
+            else if (!enable && m_shares) {
+                eigen_assert(!shared());
+                m_shares->~atomic();
+                m_resource->deallocate(m_shares, sizeof(std::atomic<int>), alignof(std::atomic<int>));
+                m_shares = nullptr;
+            }
+        }
+
+        /// <summary>
+        /// is the memory referred to by more than one buffer?
+        /// </summary>
+        bool shared() const {
+            return m_shares && m_shares->load(std::memory_order_acquire) > 1;
+        }
+
+        /// <summary>
+        /// returns a buffer referring to the same memory (copy-on-write buffers only)
+        /// </summary>
+        buffer share() const {
+            eigen_assert(copy_on_write());
+            m_shares->fetch_add(1, std::memory_order_relaxed);
+            buffer b(m_resource);
+            b.m_data = m_data;
+            b.m_capacity = m_capacity;
+            b.m_shares = m_shares;
+            return b;
+        }
+
+        /// <summary>
+        /// make the memory exclusive to this buffer, the first 'keep' elements are copied
+        /// </summary>
+        void detach(size_type keep) {
+            if (shared()) {
+                MATH_INSTRUMENT_EVENT(_T, copy, std::min(keep, m_capacity) * sizeof(_T));
+                replace(m_capacity, keep);
+            }
+        }
+
+        /// <summary>
+        /// move the elements [first, first + n) to 'dest', the elements are copied if the memory is shared
+        /// </summary>
+        void move_to(size_type first, size_type n, _T* dest) {
+            if (shared())
+                std::copy(m_data + first, m_data + first + n, dest);
+            else
+                std::move(m_data + first, m_data + first + n, dest);
+        }
+
+        /// <summary>
+        /// change the capacity, the first 'keep' elements are moved into the new memory
+        /// </summary>
+        void reallocate(size_type capacity, size_type keep) {
+            if (m_capacity > 0)
+                MATH_INSTRUMENT_EVENT(_T, reallocation, std::min(keep, capacity) * sizeof(_T));
+            replace(capacity, keep);
+        }
+
+        /// <summary>
+        /// exchange the memory and the memory resources
+        /// </summary>
+        void swap(buffer& other) noexcept {
+            std::swap(m_data, other.m_data);
+            std::swap(m_capacity, other.m_capacity);
+            std::swap(m_resource, other.m_resource);
+            std::swap(m_shares, other.m_shares);
+        }
+
+    private:
+        static constexpr size_type alignment = std::max<size_type>(EIGEN_MAX_ALIGN_BYTES, alignof(_T));
+
+        /// <summary>
+        /// move the first 'keep' elements into new memory with 'capacity' elements
+        /// </summary>
+        void replace(size_type capacity, size_type keep) {
+            buffer b(capacity, m_resource, copy_on_write());
+            move_to(0, std::min(keep, capacity), b.m_data);
+            swap(b);
+        }
+
+        _T* allocate(size_type n) {
+            if (n == 0)
+                return nullptr;
+            MATH_INSTRUMENT_EVENT(_T, allocation, n * sizeof(_T));
+            _T* ptr = static_cast<_T*>(m_resource->allocate(n * sizeof(_T), alignment));
+            std::uninitialized_default_construct_n(ptr, n);
+            return ptr;
+        }
+
+        void deallocate(_T* ptr, size_type n) {
+            if (!ptr)
+                return;
+            std::destroy_n(ptr, n);
+            m_resource->deallocate(ptr, n * sizeof(_T), alignment);
+        }
+
+        /// <summary>
+        /// drop the reference to the memory, the last reference frees it
+        /// </summary>
+        void release() {
+            if (m_shares) {
+                if (m_shares->fetch_sub(1, std::memory_order_acq_rel) != 1)
+                    return;
+                m_shares->~atomic();
+                m_resource->deallocate(m_shares, sizeof(std::atomic<int>), alignof(std::atomic<int>));
+            }
+            deallocate(m_data, m_capacity);
+        }
+
+        _T* m_data;
+        size_type m_capacity;
+        memory_resource* m_resource;
+        std::atomic<int>* m_shares;
+    };
+}
\ No newline at end of file
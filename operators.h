@@ -7,14 +7,41 @@
 #pragma once
 #include "vector.h"
 #include "matrix.h"
+#include "view.h"
+#include "sparse.h"
 #include <iostream>
+#include <functional>
+#include <stdexcept>
+#include <type_traits>
+
+// Note on the arithmetic operators:
+// The operators do not evaluate their result, they return the (lazy) Eigen expression instead.
+// The expression is evaluated in a single pass as soon as it is assigned to a math::vector or a
+// math::matrix. Therefore, an expression like a + b * s - c does not create any temporaries.
+// Since the expressions keep references to their operands, do not store them with 'auto'
+// if an operand is a temporary:
+//     math::vector<double> c = a + b; // ok
+//     auto c = a + b;                 // expression, valid only as long as a and b are alive
+//
+// math::vector_view and math::matrix_view are Eigen::Maps. Operations between views and Eigen
+// expressions use the operators of Eigen, all other combinations are defined below.
+//
+// Products with a math::sparse_matrix return Eigen's sparse expressions, sparse * dense is dense
+// and can be assigned to a math::vector or a math::matrix, sparse * sparse to a math::sparse_matrix.
+//
+// Mixed precision (16 bit storage, e.g. weights in Eigen::half or Eigen::bfloat16):
+//     math::matrix<Eigen::half> w = weights.cast<Eigen::half>();  // half the memory and bandwidth
+//     float s = math::eigen::dot(a, b);                            // accumulates in math::accumulator_t
+//     math::vector<float> y = math::eigen::gemv(w, x);             // x may be float or half
+//     math::eigen::multiply_into(y, w, x);                         // same without allocating
+// The operators above keep the element type of their operands, i.e. they also accumulate in 16 bit.
 
 namespace math {
     /// <summary>
-    /// ostream
+    /// ostream (aligned formatting of Eigen, use math::as_text from format.h for large matrices)
     /// </summary>
-    template <class _T>
-    std::ostream& operator<< (std::ostream& stream, const matrix<_T>& mat) {
+    template <class _T, int _R, int _C, int _L>
+    std::ostream& operator<< (std::ostream& stream, const matrix<_T, _R, _C, _L>& mat) {
         stream << mat.eigen();
         return stream;
     }
@@ -22,74 +49,297 @@ namespace math {
     /// <summary>
     /// ostream
     /// </summary>
-    template <class _T>
-    std::ostream& operator<< (std::ostream& stream, const vector<_T>& vec) {
+    template <class _T, int _N>
+    std::ostream& operator<< (std::ostream& stream, const vector<_T, _N>& vec) {
         stream << vec.eigen();
         return stream;
     }
 
+    /// <summary>
+    /// type to accumulate sums of _T in: float for the 16 bit floating point types, _T itself otherwise
+    /// </summary>
+    template <class _T>
+    struct accumulator {
+        using type = _T;
+    };
+
+    template <>
+    struct accumulator<Eigen::half> {
+        using type = float;
+    };
+
+    template <>
+    struct accumulator<Eigen::bfloat16> {
+        using type = float;
+    };
+
+    /// <summary>
+    /// accumulator of products of _T1 and _T2, e.g. float for (Eigen::half, Eigen::half) and double for (Eigen::half, double)
+    /// </summary>
+    template <class _T1, class _T2 = _T1>
+    using accumulator_t = typename std::common_type<typename accumulator<_T1>::type, typename accumulator<_T2>::type>::type;
+
+    namespace detail {
+        /// <summary>
+        /// true if the elements of 'a' and 'b' overlap in memory
+        /// </summary>
+        template <class _A, class _B>
+        inline bool aliases(const _A& a, const _B& b) {
+            const void* a0 = a.data();
+            const void* a1 = a.data() + a.size();
+            const void* b0 = b.data();
+            const void* b1 = b.data() + b.size();
+            return a.size() > 0 && b.size() > 0 && std::less<const void*>()(a0, b1) && std::less<const void*>()(b0, a1);
+        }
+
+        /// <summary>
+        /// give a dynamic-size output the shape r x c (fixed-size outputs have the right shape already)
+        /// </summary>
+        template <class _T, int _R, int _C, int _L>
+        inline void fit(matrix<_T, _R, _C, _L>& dst, size_t r, size_t c) {
+            if constexpr (_R == Eigen::Dynamic)
+                if (dst.rows() != r || dst.cols() != c)
+                    dst.resize(r, c);
+        }
+
+        template <class _T, int _N>
+        inline void fit(vector<_T, _N>& dst, size_t n) {
+            if constexpr (_N == Eigen::Dynamic)
+                if (dst.size() != n)
+                    dst.resize(n);
+        }
+
+        /// <summary>
+        /// output vector of size 'n' without initialized elements
+        /// </summary>
+        template <class _T, int _N>
+        inline vector<_T, _N> uninitialized_vector(size_t n) {
+            if constexpr (_N == Eigen::Dynamic)
+                return vector<_T, _N>(n, uninitialized);
+            else
+                return vector<_T, _N>(uninitialized);
+        }
+    }
+
     namespace eigen {
         /// <summary>
         /// transpose a matrix
         /// </summary>
-        template <class _T>
-        inline matrix<_T> transpose(const matrix<_T>& mat) {
-            return matrix<_T>(mat.eigen().transpose());
+        template <class _T, int _R, int _C, int _L>
+        inline matrix<_T, _C, _R, _L> transpose(const matrix<_T, _R, _C, _L>& mat) {
+            MATH_INSTRUMENT_EVENT(_T, temporary, mat.size() * sizeof(_T));
+            return matrix<_T, _C, _R, _L>(mat.eigen().transpose());
         }
 
         /// <summary>
         /// inverse of a matrix
+        /// (to solve linear systems, a math::solver of solver.h is faster and more accurate)
         /// </summary>
-        template <class _T>
-        inline matrix<_T> inverse(const matrix<_T>& mat) {
-            return matrix<_T>(mat.eigen().inverse());
+        template <class _T, int _R, int _C, int _L>
+        inline matrix<_T, _R, _C, _L> inverse(const matrix<_T, _R, _C, _L>& mat) {
+            MATH_INSTRUMENT_EVENT(_T, temporary, mat.size() * sizeof(_T));
+            return matrix<_T, _R, _C, _L>(mat.eigen().inverse());
+        }
+
+        /// <summary>
+        /// transpose 'src' into 'dst' without allocating, if 'dst' has the right size (or enough capacity)
+        /// If 'dst' and 'src' share memory, the matrix is transposed in place (square) or via a temporary.
+        /// </summary>
+        template <class _T, int _R, int _C, int _L>
+        inline void transpose_into(matrix<_T, _C, _R, _L>& dst, const matrix<_T, _R, _C, _L>& src) {
+            // distinct fixed-size objects of different types cannot share memory
+            if constexpr (_R == _C) {
+                if (detail::aliases(dst, src)) {
+                    if (src.rows() == src.cols() && &dst == &src) {
+                        dst.eigen().transposeInPlace();
+                        return;
+                    }
+#if defined(_DEBUG) || defined(DEBUG)
+                    std::cout << "Warning: transpose_into: destination aliases the source, evaluating into a temporary." << std::endl;
+#endif
+                    MATH_INSTRUMENT_EVENT(_T, temporary, src.size() * sizeof(_T));
+                    dst = src.eigen().transpose().eval();
+                    return;
+                }
+            }
+            detail::fit(dst, src.cols(), src.rows());
+            dst.eigen() = src.eigen().transpose();
+        }
+
+        /// <summary>
+        /// transpose a square matrix in place
+        /// Throws std::invalid_argument if a dynamic-size matrix is not square.
+        /// </summary>
+        template <class _T, int _N, int _L>
+        inline void transpose_inplace(matrix<_T, _N, _N, _L>& mat) {
+            if (mat.rows() != mat.cols())
+                throw std::invalid_argument("transpose_inplace: the matrix is not square");
+            mat.eigen().transposeInPlace();
+        }
+
+        /// <summary>
+        /// invert 'src' into 'dst', fixed-size matrices are inverted without allocating
+        /// (dynamic-size matrices are inverted via an LU decomposition, which allocates its own memory)
+        /// </summary>
+        template <class _T, int _R, int _C, int _L>
+        inline void inverse_into(matrix<_T, _R, _C, _L>& dst, const matrix<_T, _R, _C, _L>& src) {
+            if (detail::aliases(dst, src)) {
+                // the inverse of a fixed-size matrix is evaluated on the stack
+                MATH_INSTRUMENT_EVENT(_T, temporary, src.size() * sizeof(_T));
+                dst.eigen() = src.eigen().inverse().eval();
+                return;
+            }
+            detail::fit(dst, src.rows(), src.cols());
+            dst.eigen() = src.eigen().inverse();
+        }
+
+        /// <summary>
+        /// matrix-matrix product dst = a * b without allocating, if 'dst' has the right size (or enough capacity)
+        /// If 'dst' shares memory with 'a' or 'b', the product is evaluated into a temporary.
+        /// </summary>
+        template <class _T, int _R, int _K, int _C, int _L1, int _L2, int _L3>
+        inline void multiply_into(matrix<_T, _R, _C, _L1>& dst, const matrix<_T, _R, _K, _L2>& a, const matrix<_T, _K, _C, _L3>& b) {
+            if (detail::aliases(dst, a) || detail::aliases(dst, b)) {
+#if defined(_DEBUG) || defined(DEBUG)
+                std::cout << "Warning: multiply_into: destination aliases an operand, evaluating into a temporary." << std::endl;
+#endif
+                MATH_INSTRUMENT_EVENT(_T, temporary, a.rows() * b.cols() * sizeof(_T));
+                dst = (a.eigen() * b.eigen()).eval();
+                return;
+            }
+            detail::fit(dst, a.rows(), b.cols());
+            dst.eigen().noalias() = a.eigen() * b.eigen();
+        }
+
+        /// <summary>
+        /// matrix-vector product dst = a * x without allocating, if 'dst' has the right size (or enough capacity)
+        /// If 'dst' shares memory with 'a' or 'x', the product is evaluated into a temporary.
+        /// </summary>
+        template <class _T, int _R, int _C, int _L>
+        inline void multiply_into(vector<_T, _R>& dst, const matrix<_T, _R, _C, _L>& a, const vector<_T, _C>& x) {
+            if (detail::aliases(dst, a) || detail::aliases(dst, x)) {
+#if defined(_DEBUG) || defined(DEBUG)
+                std::cout << "Warning: multiply_into: destination aliases an operand, evaluating into a temporary." << std::endl;
+#endif
+                MATH_INSTRUMENT_EVENT(_T, temporary, a.rows() * sizeof(_T));
+                dst = (a.eigen() * x.eigen()).eval();
+                return;
+            }
+            detail::fit(dst, a.rows());
+            dst.eigen().noalias() = a.eigen() * x.eigen();
         }
 
         /// <summary>
         /// general l-norm of a vector
         /// </summary>
-        template <int _l, class _T>
-        inline _T norm(const vector<_T>& vec) {
+        template <int _l, class _T, int _N>
+        inline _T norm(const vector<_T, _N>& vec) {
             return vec.eigen().template lpNorm<_l>();
         }
 
         /// <summary>
         /// norm of a vector
         /// </summary>
-        template <class _T>
-        inline _T norm(const vector<_T>& vec) {
+        template <class _T, int _N>
+        inline _T norm(const vector<_T, _N>& vec) {
             return vec.eigen().norm();
         }
 
         /// <summary>
         /// normalize a vector via general l-norm
         /// </summary>
-        template <int _l, class _T>
-        inline void normalize(vector<_T>& vec) {
-            vec = vec / norm<_l, _T>(vec);
+        template <int _l, class _T, int _N>
+        inline void normalize(vector<_T, _N>& vec) {
+            vec.eigen() /= norm<_l>(vec);
         }
 
         /// <summary>
         /// normalize a vector
         /// </summary>
-        template <class _T>
-        inline void normalize(vector<_T>& vec) {
+        template <class _T, int _N>
+        inline void normalize(vector<_T, _N>& vec) {
             vec.eigen().normalize();
         }
 
         /// <summary>
         /// Frobenius norm of a matrix
         /// </summary>
-        template <class _T>
-        inline _T norm(const matrix<_T>& mat) {
+        template <class _T, int _R, int _C, int _L>
+        inline _T norm(const matrix<_T, _R, _C, _L>& mat) {
             return mat.eigen().norm();
         }
 
         /// <summary>
         /// accumulate/sum all entries of a vector
         /// </summary>
-        template <class _T>
-        inline _T sum(const vector<_T>& vec) {
+        template <class _T, int _N>
+        inline _T sum(const vector<_T, _N>& vec) {
+            return vec.eigen().sum();
+        }
+
+        /// <summary>
+        /// transpose a matrix view
+        /// </summary>
+        template <class _T, class _S>
+        inline matrix<typename std::remove_const<_T>::type> transpose(const matrix_view<_T, _S>& mat) {
+            MATH_INSTRUMENT_EVENT(typename std::remove_const<_T>::type, temporary, mat.size() * sizeof(_T));
+            return matrix<typename std::remove_const<_T>::type>(mat.eigen().transpose());
+        }
+
+        /// <summary>
+        /// inverse of a matrix view
+        /// </summary>
+        template <class _T, class _S>
+        inline matrix<typename std::remove_const<_T>::type> inverse(const matrix_view<_T, _S>& mat) {
+            MATH_INSTRUMENT_EVENT(typename std::remove_const<_T>::type, temporary, mat.size() * sizeof(_T));
+            return matrix<typename std::remove_const<_T>::type>(mat.eigen().inverse());
+        }
+
+        /// <summary>
+        /// general l-norm of a vector view
+        /// </summary>
+        template <int _l, class _T, class _S>
+        inline typename std::remove_const<_T>::type norm(const vector_view<_T, _S>& vec) {
+            return vec.eigen().template lpNorm<_l>();
+        }
+
+        /// <summary>
+        /// norm of a vector view
+        /// </summary>
+        template <class _T, class _S>
+        inline typename std::remove_const<_T>::type norm(const vector_view<_T, _S>& vec) {
+            return vec.eigen().norm();
+        }
+
+        /// <summary>
+        /// normalize a vector view via general l-norm (in place)
+        /// </summary>
+        template <int _l, class _T, class _S>
+        inline void normalize(vector_view<_T, _S>& vec) {
+            vec.eigen() /= norm<_l>(vec);
+        }
+
+        /// <summary>
+        /// normalize a vector view (in place)
+        /// </summary>
+        template <class _T, class _S>
+        inline void normalize(vector_view<_T, _S>& vec) {
+            vec.eigen().normalize();
+        }
+
+        /// <summary>
+        /// Frobenius norm of a matrix view
+        /// </summary>
+        template <class _T, class _S>
+        inline typename std::remove_const<_T>::type norm(const matrix_view<_T, _S>& mat) {
+            return mat.eigen().norm();
+        }
+
+        /// <summary>
+        /// accumulate/sum all entries of a vector view
+        /// </summary>
+        template <class _T, class _S>
+        inline typename std::remove_const<_T>::type sum(const vector_view<_T, _S>& vec) {
             return vec.eigen().sum();
         }
     }
@@ -97,132 +347,190 @@ namespace math {
     /// <summary>
     /// vector-scalar multiplication
     /// </summary>
-    template <class _T>
-    inline vector<_T> operator*(const vector<_T>& vec, const _T& scalar) {
-        return vector<_T>(vec.eigen() * scalar);
+    template <class _T, int _N>
+    inline auto operator*(const vector<_T, _N>& vec, const _T& scalar) {
+        return vec.eigen() * scalar;
     }
 
     /// <summary>
     /// vector-scalar multiplication
     /// </summary>
-    template <class _T>
-    inline vector<_T> operator*(const _T& scalar, const vector<_T>& vec) {
-        return vector<_T>(scalar * vec.eigen());
+    template <class _T, int _N>
+    inline auto operator*(const _T& scalar, const vector<_T, _N>& vec) {
+        return scalar * vec.eigen();
     }
 
     /// <summary>
     /// vector-scalar division
     /// </summary>
-    template <class _T>
-    inline vector<_T> operator/(const vector<_T>& vec, const _T& scalar) {
-        return vector<_T>(vec.eigen() / scalar);
+    template <class _T, int _N>
+    inline auto operator/(const vector<_T, _N>& vec, const _T& scalar) {
+        return vec.eigen() / scalar;
     }
 
     /// <summary>
     /// vector-vector multiplication
     /// </summary>
-    template <class _T>
-    inline _T operator*(const vector<_T>& vecT, const vector<_T>& vec) {
-        return static_cast<_T>(vecT.eigen().transpose() * vec.eigen());
+    template <class _T, int _N>
+    inline _T operator*(const vector<_T, _N>& vecT, const vector<_T, _N>& vec) {
+        return vecT.eigen().dot(vec.eigen());
     }
 
     /// <summary>
-    /// vector-vector multiplication (with eigen:Map)
+    /// vector-vector multiplication (with Eigen expression, e.g. eigen::Map)
+    /// matrix-vector multiplication, if the expression is not a column vector
     /// </summary>
-    template <class _T>
-    inline _T operator*(const typename vector<_T>::map_type& vecT, const vector<_T>& vec) {
-        return static_cast<_T>(vecT.transpose() * vec.eigen());
+    template <class _Derived, class _T, int _N>
+    inline auto operator*(const Eigen::MatrixBase<_Derived>& lhs, const vector<_T, _N>& vec) {
+        if constexpr (_Derived::ColsAtCompileTime == 1)
+            return static_cast<_T>(lhs.dot(vec.eigen()));
+        else
+            return lhs.derived() * vec.eigen();
     }
 
     /// <summary>
-    /// vector-vector multiplication (with eigen:Map)
+    /// vector-vector multiplication (with Eigen expression, e.g. eigen::Map)
+    /// vector-matrix multiplication, if the expression is not a column vector
     /// </summary>
-    template <class _T>
-    inline _T operator*(const vector<_T>& vecT, const typename vector<_T>::map_type& vec) {
-        return static_cast<_T>(vecT.eigen().transpose() * vec);
+    template <class _T, int _N, class _Derived>
+    inline auto operator*(const vector<_T, _N>& vecT, const Eigen::MatrixBase<_Derived>& rhs) {
+        if constexpr (_Derived::ColsAtCompileTime == 1)
+            return static_cast<_T>(vecT.eigen().dot(rhs));
+        else
+            return vecT.eigen().transpose() * rhs.derived();
     }
 
     namespace eigen {
         /// <summary>
         /// coefficient-wise vector multiplication: a[i] * b[i] = c[i]
         /// </summary>
-        template <class _T>
-        inline vector<_T> cprod(const vector<_T>& vec1, const vector<_T>& vec2) {
-            return vector<_T>(vec1.eigen().cwiseProduct(vec2.eigen()));
+        template <class _T, int _N>
+        inline auto cprod(const vector<_T, _N>& vec1, const vector<_T, _N>& vec2) {
+            return vec1.eigen().cwiseProduct(vec2.eigen());
         }
 
         /// <summary>
-        /// coefficient-wise vector multiplication: a[i] * b[i] = c[i] (with eigen::Map)
+        /// coefficient-wise vector multiplication: a[i] * b[i] = c[i] (with Eigen expression, e.g. eigen::Map)
         /// </summary>
-        template <class _T>
-        inline vector<_T> cprod(const typename vector<_T>::map_type& vec1, const vector<_T>& vec2) {
-            return vector<_T>(vec1.cwiseProduct(vec2.eigen()));
+        template <class _Derived, class _T, int _N>
+        inline auto cprod(const Eigen::MatrixBase<_Derived>& vec1, const vector<_T, _N>& vec2) {
+            return vec1.cwiseProduct(vec2.eigen());
         }
 
         /// <summary>
-        /// coefficient-wise vector multiplication: a[i] * b[i] = c[i] (with eigen::Map)
+        /// coefficient-wise vector multiplication: a[i] * b[i] = c[i] (with Eigen expression, e.g. eigen::Map)
         /// </summary>
-        template <class _T>
-        inline vector<_T> cprod(const vector<_T>& vec1, const typename vector<_T>::map_type& vec2) {
-            return vector<_T>(vec1.eigen().cwiseProduct(vec2));
+        template <class _T, int _N, class _Derived>
+        inline auto cprod(const vector<_T, _N>& vec1, const Eigen::MatrixBase<_Derived>& vec2) {
+            return vec1.eigen().cwiseProduct(vec2.derived());
+        }
+
+        /// <summary>
+        /// coefficient-wise vector multiplication: a[i] * b[i] = c[i] (Eigen expressions or views)
+        /// </summary>
+        template <class _Derived1, class _Derived2>
+        inline auto cprod(const Eigen::MatrixBase<_Derived1>& vec1, const Eigen::MatrixBase<_Derived2>& vec2) {
+            return vec1.cwiseProduct(vec2.derived());
         }
 
         /// <summary>
         /// coefficient-wise vector division: a[i] / b[i] = c[i]
         /// </summary>
-        template <class _T>
-        inline vector<_T> cdiv(const vector<_T>& vec1, const vector<_T>& vec2) {
-            return vector<_T>(vec1.eigen().cwiseQuotient(vec2.eigen()));
+        template <class _T, int _N>
+        inline auto cdiv(const vector<_T, _N>& vec1, const vector<_T, _N>& vec2) {
+            return vec1.eigen().cwiseQuotient(vec2.eigen());
+        }
+
+        /// <summary>
+        /// coefficient-wise vector division: a[i] / b[i] = c[i] (with Eigen expression, e.g. eigen::Map)
+        /// </summary>
+        template <class _Derived, class _T, int _N>
+        inline auto cdiv(const Eigen::MatrixBase<_Derived>& vec1, const vector<_T, _N>& vec2) {
+            return vec1.cwiseQuotient(vec2.eigen());
+        }
+
+        /// <summary>
+        /// coefficient-wise vector division: a[i] / b[i] = c[i] (with Eigen expression, e.g. eigen::Map)
+        /// </summary>
+        template <class _T, int _N, class _Derived>
+        inline auto cdiv(const vector<_T, _N>& vec1, const Eigen::MatrixBase<_Derived>& vec2) {
+            return vec1.eigen().cwiseQuotient(vec2.derived());
+        }
+
+        /// <summary>
+        /// coefficient-wise vector division: a[i] / b[i] = c[i] (Eigen expressions or views)
+        /// </summary>
+        template <class _Derived1, class _Derived2>
+        inline auto cdiv(const Eigen::MatrixBase<_Derived1>& vec1, const Eigen::MatrixBase<_Derived2>& vec2) {
+            return vec1.cwiseQuotient(vec2.derived());
         }
     }
 
     /// <summary>
     /// vector-vector addition
     /// </summary>
-    template <class _T>
-    inline vector<_T> operator+(const vector<_T>& lhs, const vector<_T>& rhs) {
-        return vector<_T>(lhs.eigen() + rhs.eigen());
+    template <class _T, int _N>
+    inline auto operator+(const vector<_T, _N>& lhs, const vector<_T, _N>& rhs) {
+        return lhs.eigen() + rhs.eigen();
     }
 
     /// <summary>
-    /// vector-vector addition (with eigen::Map)
+    /// vector-vector addition (with Eigen expression, e.g. eigen::Map)
     /// </summary>
-    template <class _T>
-    inline vector<_T> operator+(const typename vector<_T>::map_type& lhs, const vector<_T>& rhs) {
-        return vector<_T>(lhs + rhs.eigen());
+    template <class _Derived, class _T, int _N>
+    inline auto operator+(const Eigen::MatrixBase<_Derived>& lhs, const vector<_T, _N>& rhs) {
+        return lhs.derived() + rhs.eigen();
     }
 
     /// <summary>
-    /// vector-vector addition (with eigen::Map)
+    /// vector-vector addition (with Eigen expression, e.g. eigen::Map)
     /// </summary>
-    template <class _T>
-    inline vector<_T> operator+(const vector<_T>& lhs, const typename vector<_T>::map_type& rhs) {
-        return vector<_T>(lhs.eigen() + rhs);
+    template <class _T, int _N, class _Derived>
+    inline auto operator+(const vector<_T, _N>& lhs, const Eigen::MatrixBase<_Derived>& rhs) {
+        return lhs.eigen() + rhs.derived();
     }
 
     /// <summary>
     /// vector-vector addition
     /// </summary>
-    template <class _T>
-    inline vector<_T>& operator+=(vector<_T>& lhs, const vector<_T>& rhs) {
+    template <class _T, int _N>
+    inline vector<_T, _N>& operator+=(vector<_T, _N>& lhs, const vector<_T, _N>& rhs) {
         lhs.eigen() += rhs.eigen();
         return lhs;
     }
 
+    /// <summary>
+    /// vector-vector addition (with Eigen expression)
+    /// </summary>
+    template <class _T, int _N, class _Derived>
+    inline vector<_T, _N>& operator+=(vector<_T, _N>& lhs, const Eigen::MatrixBase<_Derived>& rhs) {
+        lhs.eigen() += rhs;
+        return lhs;
+    }
+
     /// <summary>
     /// vector-vector subtraction
     /// </summary>
-    template <class _T>
-    inline vector<_T>& operator-=(vector<_T>& lhs, const vector<_T>& rhs) {
+    template <class _T, int _N>
+    inline vector<_T, _N>& operator-=(vector<_T, _N>& lhs, const vector<_T, _N>& rhs) {
         lhs.eigen() -= rhs.eigen();
         return lhs;
     }
 
+    /// <summary>
+    /// vector-vector subtraction (with Eigen expression)
+    /// </summary>
+    template <class _T, int _N, class _Derived>
+    inline vector<_T, _N>& operator-=(vector<_T, _N>& lhs, const Eigen::MatrixBase<_Derived>& rhs) {
+        lhs.eigen() -= rhs;
+        return lhs;
+    }
+
     /// <summary>
     /// vector-scalar multiplication
     /// </summary>
-    template <class _T>
-    inline vector<_T>& operator*=(vector<_T>& lhs, const _T& rhs) {
+    template <class _T, int _N>
+    inline vector<_T, _N>& operator*=(vector<_T, _N>& lhs, const _T& rhs) {
         lhs.eigen() *= rhs;
         return lhs;
     }
@@ -230,8 +538,8 @@ namespace math {
     /// <summary>
     /// vector-scalar division
     /// </summary>
-    template <class _T>
-    inline vector<_T>& operator/=(vector<_T>& lhs, const _T& rhs) {
+    template <class _T, int _N>
+    inline vector<_T, _N>& operator/=(vector<_T, _N>& lhs, const _T& rhs) {
         lhs.eigen() /= rhs;
         return lhs;
     }
@@ -239,104 +547,384 @@ namespace math {
     /// <summary>
     /// vector-vector subtraction
     /// </summary>
-    template <class _T>
-    inline typename vector<_T>::eigen_type operator-(const vector<_T>& lhs, const vector<_T>& rhs) {
+    template <class _T, int _N>
+    inline auto operator-(const vector<_T, _N>& lhs, const vector<_T, _N>& rhs) {
         return lhs.eigen() - rhs.eigen();
     }
 
     /// <summary>
-    /// vector-vector subtraction (with eigen::Map)
+    /// vector-vector subtraction (with Eigen expression, e.g. eigen::Map)
     /// </summary>
-    template <class _T>
-    inline typename vector<_T>::eigen_type operator-(const typename vector<_T>::map_type& lhs, const vector<_T>& rhs) {
-        return lhs - rhs.eigen();
+    template <class _Derived, class _T, int _N>
+    inline auto operator-(const Eigen::MatrixBase<_Derived>& lhs, const vector<_T, _N>& rhs) {
+        return lhs.derived() - rhs.eigen();
     }
 
     /// <summary>
-    /// vector-vector subtraction (with eigen::Map)
+    /// vector-vector subtraction (with Eigen expression, e.g. eigen::Map)
     /// </summary>
-    template <class _T>
-    inline typename vector<_T>::eigen_type operator-(const vector<_T>& lhs, const typename vector<_T>::map_type& rhs) {
-        return lhs.eigen() - rhs;
+    template <class _T, int _N, class _Derived>
+    inline auto operator-(const vector<_T, _N>& lhs, const Eigen::MatrixBase<_Derived>& rhs) {
+        return lhs.eigen() - rhs.derived();
     }
 
     /// <summary>
     /// matrix-scalar multiplication
     /// </summary>
-    template <class _T>
-    inline typename matrix<_T>::eigen_type operator*(const matrix<_T>& mat, const _T& scalar) {
+    template <class _T, int _R, int _C, int _L>
+    inline auto operator*(const matrix<_T, _R, _C, _L>& mat, const _T& scalar) {
         return mat.eigen() * scalar;
     }
 
     /// <summary>
     /// matrix-scalar multiplication
     /// </summary>
-    template <class _T>
-    inline typename matrix<_T>::eigen_type operator*(const _T& scalar, const matrix<_T>& mat) {
+    template <class _T, int _R, int _C, int _L>
+    inline auto operator*(const _T& scalar, const matrix<_T, _R, _C, _L>& mat) {
         return scalar * mat.eigen();
     }
 
     /// <summary>
     /// matrix-scalar division
     /// </summary>
-    template <class _T>
-    inline typename matrix<_T>::eigen_type operator/(const matrix<_T>& mat, const _T& scalar) {
+    template <class _T, int _R, int _C, int _L>
+    inline auto operator/(const matrix<_T, _R, _C, _L>& mat, const _T& scalar) {
         return mat.eigen() / scalar;
     }
 
     /// <summary>
     /// matrix-vector multiplication
     /// </summary>
-    template <class _T>
-    inline typename vector<_T>::eigen_type operator*(const matrix<_T>& mat, const vector<_T>& vec) {
+    template <class _T, int _R, int _C, int _N, int _L>
+    inline auto operator*(const matrix<_T, _R, _C, _L>& mat, const vector<_T, _N>& vec) {
         return mat.eigen() * vec.eigen();
     }
 
     /// <summary>
-    /// matrix-vector multiplication (with eigen::Map)
+    /// vector-matrix multiplication
+    /// </summary>
+    template <class _T, int _R, int _C, int _N, int _L>
+    inline auto operator*(const vector<_T, _N>& vecT, const matrix<_T, _R, _C, _L>& mat) {
+        return vecT.eigen().transpose() * mat.eigen();
+    }
+
+    /// <summary>
+    /// matrix-matrix multiplication
+    /// </summary>
+    template <class _T, int _R1, int _C1, int _R2, int _C2, int _L1, int _L2>
+    inline auto operator*(const matrix<_T, _R1, _C1, _L1>& lhs, const matrix<_T, _R2, _C2, _L2>& rhs) {
+        return lhs.eigen() * rhs.eigen();
+    }
+
+    /// <summary>
+    /// matrix-matrix multiplication (with Eigen expression, e.g. eigen::Map)
+    /// matrix-vector multiplication, if the expression is a vector
+    /// </summary>
+    template <class _T, int _R, int _C, class _Derived, int _L>
+    inline auto operator*(const matrix<_T, _R, _C, _L>& lhs, const Eigen::MatrixBase<_Derived>& rhs) {
+        return lhs.eigen() * rhs.derived();
+    }
+
+    /// <summary>
+    /// matrix-matrix multiplication (with Eigen expression, e.g. eigen::Map)
+    /// </summary>
+    template <class _Derived, class _T, int _R, int _C, int _L>
+    inline auto operator*(const Eigen::MatrixBase<_Derived>& lhs, const matrix<_T, _R, _C, _L>& rhs) {
+        return lhs.derived() * rhs.eigen();
+    }
+
+    /// <summary>
+    /// matrix-matrix addition
+    /// </summary>
+    template <class _T, int _R, int _C, int _L1, int _L2>
+    inline auto operator+(const matrix<_T, _R, _C, _L1>& lhs, const matrix<_T, _R, _C, _L2>& rhs) {
+        return lhs.eigen() + rhs.eigen();
+    }
+
+    /// <summary>
+    /// matrix-matrix addition (with Eigen expression)
+    /// </summary>
+    template <class _Derived, class _T, int _R, int _C, int _L>
+    inline auto operator+(const Eigen::MatrixBase<_Derived>& lhs, const matrix<_T, _R, _C, _L>& rhs) {
+        return lhs.derived() + rhs.eigen();
+    }
+
+    /// <summary>
+    /// matrix-matrix addition (with Eigen expression)
+    /// </summary>
+    template <class _T, int _R, int _C, class _Derived, int _L>
+    inline auto operator+(const matrix<_T, _R, _C, _L>& lhs, const Eigen::MatrixBase<_Derived>& rhs) {
+        return lhs.eigen() + rhs.derived();
+    }
+
+    /// <summary>
+    /// matrix-matrix subtraction
+    /// </summary>
+    template <class _T, int _R, int _C, int _L1, int _L2>
+    inline auto operator-(const matrix<_T, _R, _C, _L1>& lhs, const matrix<_T, _R, _C, _L2>& rhs) {
+        return lhs.eigen() - rhs.eigen();
+    }
+
+    /// <summary>
+    /// matrix-matrix subtraction (with Eigen expression)
+    /// </summary>
+    template <class _Derived, class _T, int _R, int _C, int _L>
+    inline auto operator-(const Eigen::MatrixBase<_Derived>& lhs, const matrix<_T, _R, _C, _L>& rhs) {
+        return lhs.derived() - rhs.eigen();
+    }
+
+    /// <summary>
+    /// matrix-matrix subtraction (with Eigen expression)
+    /// </summary>
+    template <class _T, int _R, int _C, class _Derived, int _L>
+    inline auto operator-(const matrix<_T, _R, _C, _L>& lhs, const Eigen::MatrixBase<_Derived>& rhs) {
+        return lhs.eigen() - rhs.derived();
+    }
+
+    /// <summary>
+    /// view-view multiplication (scalar product)
+    /// </summary>
+    template <class _T1, class _S1, class _T2, class _S2>
+    inline auto operator*(const vector_view<_T1, _S1>& vecT, const vector_view<_T2, _S2>& vec) {
+        return static_cast<typename std::remove_const<_T1>::type>(vecT.eigen().dot(vec.eigen()));
+    }
+
+    /// <summary>
+    /// view-vector multiplication with an Eigen expression (scalar product)
+    /// view-matrix multiplication, if the expression is not a column vector
+    /// </summary>
+    template <class _T, class _S, class _Derived>
+    inline auto operator*(const vector_view<_T, _S>& vecT, const Eigen::MatrixBase<_Derived>& rhs) {
+        if constexpr (_Derived::ColsAtCompileTime == 1)
+            return static_cast<typename std::remove_const<_T>::type>(vecT.eigen().dot(rhs));
+        else
+            return vecT.eigen().transpose() * rhs.derived();
+    }
+
+    /// <summary>
+    /// vector-view multiplication with an Eigen expression (scalar product)
+    /// matrix-view multiplication, if the expression is not a column vector
+    /// </summary>
+    template <class _Derived, class _T, class _S>
+    inline auto operator*(const Eigen::MatrixBase<_Derived>& lhs, const vector_view<_T, _S>& vec) {
+        if constexpr (_Derived::ColsAtCompileTime == 1)
+            return static_cast<typename std::remove_const<_T>::type>(lhs.dot(vec.eigen()));
+        else
+            return lhs.derived() * vec.eigen();
+    }
+
+    /// <summary>
+    /// view-matrix multiplication
+    /// </summary>
+    template <class _T, class _S, int _R, int _C, int _L>
+    inline auto operator*(const vector_view<_T, _S>& vecT, const matrix<typename std::remove_const<_T>::type, _R, _C, _L>& mat) {
+        return vecT.eigen().transpose() * mat.eigen();
+    }
+
+    /// <summary>
+    /// view-vector addition (in place)
+    /// </summary>
+    template <class _T, class _S, int _N>
+    inline vector_view<_T, _S>& operator+=(vector_view<_T, _S>& lhs, const vector<_T, _N>& rhs) {
+        lhs.eigen() += rhs.eigen();
+        return lhs;
+    }
+
+    /// <summary>
+    /// view-vector subtraction (in place)
+    /// </summary>
+    template <class _T, class _S, int _N>
+    inline vector_view<_T, _S>& operator-=(vector_view<_T, _S>& lhs, const vector<_T, _N>& rhs) {
+        lhs.eigen() -= rhs.eigen();
+        return lhs;
+    }
+
+    /// <summary>
+    /// ostream
     /// </summary>
     template <class _T>
-    inline typename vector<_T>::eigen_type operator*(const typename matrix<_T>::map_type& mat, const vector<_T>& vec) {
-        return mat * vec.eigen();
+    std::ostream& operator<< (std::ostream& stream, const sparse_matrix<_T>& mat) {
+        stream << mat.eigen();
+        return stream;
     }
 
     /// <summary>
-    /// matrix-vector multiplication (with eigen::Map)
+    /// sparse matrix-scalar multiplication
     /// </summary>
     template <class _T>
-    inline typename vector<_T>::eigen_type operator*(const matrix<_T>& mat, const typename vector<_T>::map_type& vec) {
-        return mat.eigen() * vec;
+    inline auto operator*(const sparse_matrix<_T>& mat, const _T& scalar) {
+        return mat.eigen() * scalar;
     }
 
     /// <summary>
-    /// vector-matrix multiplication
+    /// sparse matrix-scalar multiplication
     /// </summary>
     template <class _T>
-    inline typename vector<_T>::eigen_type operator*(const vector<_T>& vecT, const matrix<_T>& mat) {
+    inline auto operator*(const _T& scalar, const sparse_matrix<_T>& mat) {
+        return scalar * mat.eigen();
+    }
+
+    /// <summary>
+    /// sparse matrix-vector multiplication (dense result)
+    /// </summary>
+    template <class _T, int _N>
+    inline auto operator*(const sparse_matrix<_T>& mat, const vector<_T, _N>& vec) {
+        return mat.eigen() * vec.eigen();
+    }
+
+    /// <summary>
+    /// vector-sparse matrix multiplication (dense result)
+    /// </summary>
+    template <class _T, int _N>
+    inline auto operator*(const vector<_T, _N>& vecT, const sparse_matrix<_T>& mat) {
         return vecT.eigen().transpose() * mat.eigen();
     }
 
     /// <summary>
-    /// matrix-matrix multiplication
+    /// sparse matrix-dense matrix multiplication (dense result)
+    /// </summary>
+    template <class _T, int _R, int _C, int _L>
+    inline auto operator*(const sparse_matrix<_T>& lhs, const matrix<_T, _R, _C, _L>& rhs) {
+        return lhs.eigen() * rhs.eigen();
+    }
+
+    /// <summary>
+    /// dense matrix-sparse matrix multiplication (dense result)
+    /// </summary>
+    template <class _T, int _R, int _C, int _L>
+    inline auto operator*(const matrix<_T, _R, _C, _L>& lhs, const sparse_matrix<_T>& rhs) {
+        return lhs.eigen() * rhs.eigen();
+    }
+
+    /// <summary>
+    /// sparse matrix-sparse matrix multiplication (sparse result)
     /// </summary>
     template <class _T>
-    inline typename matrix<_T>::eigen_type operator*(const matrix<_T>& lhs, const matrix<_T>& rhs) {
+    inline auto operator*(const sparse_matrix<_T>& lhs, const sparse_matrix<_T>& rhs) {
         return lhs.eigen() * rhs.eigen();
     }
 
     /// <summary>
-    /// matrix-matrix addition
+    /// sparse matrix-sparse matrix addition
     /// </summary>
     template <class _T>
-    inline typename matrix<_T>::eigen_type operator+(const matrix<_T>& lhs, const matrix<_T>& rhs) {
+    inline auto operator+(const sparse_matrix<_T>& lhs, const sparse_matrix<_T>& rhs) {
         return lhs.eigen() + rhs.eigen();
     }
 
     /// <summary>
-    /// matrix-matrix subtraction
+    /// sparse matrix-sparse matrix subtraction
     /// </summary>
     template <class _T>
-    inline typename matrix<_T>::eigen_type operator-(const matrix<_T>& lhs, const matrix<_T>& rhs) {
+    inline auto operator-(const sparse_matrix<_T>& lhs, const sparse_matrix<_T>& rhs) {
         return lhs.eigen() - rhs.eigen();
     }
-}
\ No newline at end of file
+
+    namespace eigen {
+        /// <summary>
+        /// transpose a sparse matrix
+        /// </summary>
+        template <class _T>
+        inline sparse_matrix<_T> transpose(const sparse_matrix<_T>& mat) {
+            return sparse_matrix<_T>(mat.eigen().transpose());
+        }
+
+        /// <summary>
+        /// Frobenius norm of a sparse matrix
+        /// </summary>
+        template <class _T>
+        inline _T norm(const sparse_matrix<_T>& mat) {
+            return mat.eigen().norm();
+        }
+
+        /// <summary>
+        /// sparse matrix-vector product dst = a * x without allocating, if 'dst' has the right size (or enough capacity)
+        /// If 'dst' shares memory with 'x', the product is evaluated into a temporary.
+        /// </summary>
+        template <class _T, int _N>
+        inline void multiply_into(vector<_T, _N>& dst, const sparse_matrix<_T>& a, const vector<_T, _N>& x) {
+            if (detail::aliases(dst, x)) {
+#if defined(_DEBUG) || defined(DEBUG)
+                std::cout << "Warning: multiply_into: destination aliases an operand, evaluating into a temporary." << std::endl;
+#endif
+                MATH_INSTRUMENT_EVENT(_T, temporary, a.rows() * sizeof(_T));
+                dst = (a.eigen() * x.eigen()).eval();
+                return;
+            }
+            detail::fit(dst, a.rows());
+            dst.eigen().noalias() = a.eigen() * x.eigen();
+        }
+    }
+
+    namespace eigen {
+        /// <summary>
+        /// dot product accumulated in _Acc, the elements are converted on the fly (no temporaries)
+        /// </summary>
+        template <class _Acc = void, class _T1, class _T2, int _N1, int _N2>
+        inline auto dot(const vector<_T1, _N1>& a, const vector<_T2, _N2>& b) {
+            using acc_type = typename std::conditional<std::is_void<_Acc>::value, accumulator_t<_T1, _T2>, _Acc>::type;
+            eigen_assert(a.size() == b.size());
+            return a.eigen().template cast<acc_type>().dot(b.eigen().template cast<acc_type>());
+        }
+
+        /// <summary>
+        /// matrix-vector product dst = a * x accumulated in the element type of 'dst', without allocating if 'dst' has
+        /// the right size (or enough capacity)
+        /// The elements of 'a' are converted on the fly, i.e. the matrix is read once in its storage type.
+        /// 'x' is converted once into a temporary, if its element type differs from the one of 'dst'.
+        /// If 'dst' shares memory with 'a' or 'x', the product is evaluated into a temporary.
+        /// </summary>
+        template <class _TD, class _TA, class _TX, int _R, int _C, int _L, int _N>
+        inline typename std::enable_if<!(std::is_same<_TD, _TA>::value && std::is_same<_TD, _TX>::value)>::type
+        multiply_into(vector<_TD, _R>& dst, const matrix<_TA, _R, _C, _L>& a, const vector<_TX, _N>& x) {
+            eigen_assert(a.cols() == x.size());
+            if (detail::aliases(dst, a) || detail::aliases(dst, x)) {
+#if defined(_DEBUG) || defined(DEBUG)
+                std::cout << "Warning: multiply_into: destination aliases an operand, evaluating into a temporary." << std::endl;
+#endif
+                MATH_INSTRUMENT_EVENT(_TD, temporary, a.rows() * sizeof(_TD));
+                vector<_TD, _R> tmp = detail::uninitialized_vector<_TD, _R>(a.rows());
+                multiply_into(tmp, a, x);
+                dst = std::move(tmp);
+                return;
+            }
+            typedef Eigen::Matrix<_TD, Eigen::Dynamic, 1> acc_vector;
+            if constexpr (!std::is_same<_TD, _TX>::value)
+                MATH_INSTRUMENT_EVENT(_TD, temporary, x.size() * sizeof(_TD));
+            const Eigen::Ref<const acc_vector> xa(x.eigen().template cast<_TD>());
+            detail::fit(dst, a.rows());
+            const Eigen::Index rows = static_cast<Eigen::Index>(a.rows());
+            const Eigen::Index cols = static_cast<Eigen::Index>(a.cols());
+            if constexpr (_L == Eigen::RowMajor) {
+                // one dot product per row, the rows are contiguous
+                for (Eigen::Index r = 0; r < rows; ++r)
+                    dst[r] = a.eigen().row(r).template cast<_TD>().dot(xa);
+            }
+            else {
+                // sum of the scaled columns, the columns are contiguous
+                dst.eigen().setZero();
+                for (Eigen::Index c = 0; c < cols; ++c)
+                    dst.eigen() += a.eigen().col(c).template cast<_TD>() * xa[c];
+            }
+        }
+
+        /// <summary>
+        /// matrix-vector product a * x accumulated in _Acc (see multiply_into)
+        /// </summary>
+        template <class _Acc = void, class _TA, class _TX, int _R, int _C, int _L, int _N>
+        inline auto gemv(const matrix<_TA, _R, _C, _L>& a, const vector<_TX, _N>& x) {
+            using acc_type = typename std::conditional<std::is_void<_Acc>::value, accumulator_t<_TA, _TX>, _Acc>::type;
+            vector<acc_type, _R> result = detail::uninitialized_vector<acc_type, _R>(a.rows());
+            if constexpr (std::is_same<acc_type, _TA>::value && std::is_same<acc_type, _TX>::value)
+                result.eigen().noalias() = a.eigen() * x.eigen();
+            else
+                multiply_into(result, a, x);
+            return result;
+        }
+    }
+}
+
+#ifdef MATH_CUDA
+// operators of the device-resident vectors and matrices (cuBLAS)
+#include "device.h"
+#endif
\ No newline at end of file
@@ -0,0 +1,691 @@
+/*
+ *  parallel.h
+ *  Created by Matthias Kesenheimer on 19.06.22.
+ *  Copyright 2022. All rights reserved.
+ *  More information about the Eigen library at http://eigen.tuxfamily.org/dox/index.html
+ */
+
+#pragma once
+#include "operators.h"
+#include <Eigen/Dense>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <exception>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+// vectors with fewer elements are evaluated by the calling thread only
+#ifndef MATH_PARALLEL_MIN_SIZE
+#define MATH_PARALLEL_MIN_SIZE 32768
+#endif
+
+// number of elements of a block of the deterministic reductions (sum, norm)
+// The result of a reduction depends on the block size, but not on the number of threads.
+#ifndef MATH_PARALLEL_BLOCK_SIZE
+#define MATH_PARALLEL_BLOCK_SIZE 4096
+#endif
+
+// matrix-matrix products with fewer multiply-adds are evaluated by the calling thread
+#ifndef MATH_PARALLEL_MIN_PRODUCT
+#define MATH_PARALLEL_MIN_PRODUCT (1 << 21)
+#endif
+
+// size of a cache line in bytes, the chunks written by different threads do not share cache lines
+#ifndef MATH_CACHE_LINE_SIZE
+#define MATH_CACHE_LINE_SIZE 64
+#endif
+
+// Usage:
+//     math::vector<double> c = math::eigen::cprod(math::execution::par, a, b);
+//     double s = math::eigen::sum(math::execution::par, a);
+//     math::eigen::assign(math::execution::par, c, a + b * 2.0 - c);  // any coefficient-wise expression
+//     math::vector<double> d(n, math::uninitialized);                 // no zero pass
+//     math::eigen::fill(math::execution::par, d, 0.0);                // first touch from the threads of the pool
+//     math::eigen::multiply_into(math::execution::par, C, A, B);      // blocks of rows (columns) of C per thread
+// The reductions sum and norm add up blocks of MATH_PARALLEL_BLOCK_SIZE elements and combine the block results
+// pairwise in a fixed order. Therefore, execution::seq and execution::par give bitwise identical results, independent
+// of the number of threads (but they may differ in the last digits from the plain eigen::sum/eigen::norm).
+
+namespace math {
+    /// <summary>
+    /// fixed-size pool of worker threads
+    /// </summary>
+    class thread_pool {
+    public:
+        /// <summary>
+        /// 'threads' = number of threads working on a parallel_for, including the calling thread
+        /// </summary>
+        explicit thread_pool(size_t threads = std::max(1u, std::thread::hardware_concurrency()))
+            : m_stop(false) {
+                for (size_t i = 1; i < threads; ++i)
+                    m_workers.emplace_back([this] { work(); });
+            }
+
+        thread_pool(const thread_pool&) = delete;
+        thread_pool& operator=(const thread_pool&) = delete;
+
+        ~thread_pool() {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_stop = true;
+            }
+            m_cv.notify_all();
+            for (auto& worker : m_workers)
+                worker.join();
+        }
+
+        /// <summary>
+        /// number of threads working on a parallel_for, including the calling thread
+        /// </summary>
+        size_t size() const {
+            return m_workers.size() + 1;
+        }
+
+        /// <summary>
+        /// call fn(i) for all i in [0, n) and return when all calls have finished
+        /// The calling thread takes part in the work, therefore parallel_for can be nested.
+        /// An exception thrown by fn is rethrown in the calling thread.
+        /// </summary>
+        template <class _Fn>
+        void parallel_for(size_t n, _Fn&& fn) {
+            if (n == 0)
+                return;
+            size_t helpers = std::min(m_workers.size(), n - 1);
+            if (helpers == 0) {
+                for (size_t i = 0; i < n; ++i)
+                    fn(i);
+                return;
+            }
+
+            auto job = std::make_shared<parallel_job>(n);
+            std::function<void(size_t)> task = std::ref(fn);
+            job->fn = &task;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                for (size_t i = 0; i < helpers; ++i)
+                    m_tasks.emplace_back([job] { job->run(); });
+            }
+            if (helpers == 1)
+                m_cv.notify_one();
+            else
+                m_cv.notify_all();
+
+            job->run();
+            std::unique_lock<std::mutex> lock(job->mutex);
+            job->finished.wait(lock, [&job] { return job->done == job->n; });
+            if (job->error)
+                std::rethrow_exception(job->error);
+        }
+
+    private:
+        /// <summary>
+        /// state of one parallel_for, shared by the calling thread and the helpers
+        /// </summary>
+        struct parallel_job {
+            explicit parallel_job(size_t count)
+                : n(count), next(0), done(0), fn(nullptr) {}
+
+            void run() {
+                size_t finishedHere = 0;
+                for (size_t i = next++; i < n; i = next++) {
+                    try {
+                        (*fn)(i);
+                    }
+                    catch (...) {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        if (!error)
+                            error = std::current_exception();
+                    }
+                    ++finishedHere;
+                }
+                if (finishedHere == 0)
+                    return;
+                std::lock_guard<std::mutex> lock(mutex);
+                done += finishedHere;
+                if (done == n)
+                    finished.notify_all();
+            }
+
+            const size_t n;
+            std::atomic<size_t> next;
+            size_t done;
+            // valid as long as done < n, the calling thread waits for all calls
+            std::function<void(size_t)>* fn;
+            std::exception_ptr error;
+            std::mutex mutex;
+            std::condition_variable finished;
+        };
+
+        void work() {
+            for (;;) {
+                std::function<void()> task;
+                {
+                    std::unique_lock<std::mutex> lock(m_mutex);
+                    m_cv.wait(lock, [this] { return m_stop || !m_tasks.empty(); });
+                    if (m_stop && m_tasks.empty())
+                        return;
+                    task = std::move(m_tasks.front());
+                    m_tasks.pop_front();
+                }
+                task();
+            }
+        }
+
+        std::vector<std::thread> m_workers;
+        std::deque<std::function<void()>> m_tasks;
+        std::mutex m_mutex;
+        std::condition_variable m_cv;
+        bool m_stop;
+    };
+
+    /// <summary>
+    /// pool used by execution::par (one thread per hardware thread)
+    /// </summary>
+    inline thread_pool& default_thread_pool() {
+        static thread_pool pool;
+        return pool;
+    }
+
+    /// <summary>
+    /// execution policies (in the spirit of std::execution)
+    /// </summary>
+    namespace execution {
+        /// <summary>
+        /// run in the calling thread
+        /// </summary>
+        struct sequenced_policy {};
+
+        /// <summary>
+        /// split the work across the threads of a thread pool
+        /// </summary>
+        struct parallel_policy {
+            parallel_policy()
+                : pool(nullptr) {}
+
+            explicit parallel_policy(thread_pool& p)
+                : pool(&p) {}
+
+            /// <summary>
+            /// the same policy, but running on the threads of 'p'
+            /// </summary>
+            parallel_policy on(thread_pool& p) const {
+                return parallel_policy(p);
+            }
+
+            thread_pool& threads() const {
+                return pool ? *pool : default_thread_pool();
+            }
+
+            thread_pool* pool;
+        };
+
+        inline const sequenced_policy seq{};
+        inline const parallel_policy par{};
+    }
+
+    namespace detail {
+        /// <summary>
+        /// call fn(first, length) for consecutive chunks covering [0, n)
+        /// The chunk boundaries of 'dst' are aligned to cache lines, such that threads never write into the same cache line.
+        /// </summary>
+        template <class _T, class _Fn>
+        inline void for_each_chunk(const execution::parallel_policy& policy, const _T* dst, size_t n, _Fn&& fn) {
+            thread_pool& pool = policy.threads();
+            if (n < MATH_PARALLEL_MIN_SIZE || pool.size() == 1) {
+                fn(size_t(0), n);
+                return;
+            }
+            const size_t line = std::max<size_t>(1, MATH_CACHE_LINE_SIZE / sizeof(_T));
+            // a few chunks per thread for load balancing, each a multiple of a cache line
+            size_t chunk = std::max<size_t>(MATH_PARALLEL_MIN_SIZE / 4, n / (4 * pool.size()));
+            chunk = (chunk + line - 1) / line * line;
+            // elements in front of the first cache line boundary
+            size_t head = ((MATH_CACHE_LINE_SIZE - reinterpret_cast<std::uintptr_t>(dst) % MATH_CACHE_LINE_SIZE) % MATH_CACHE_LINE_SIZE) / sizeof(_T);
+            head = std::min(head, n);
+            size_t chunks = (head > 0 ? 1 : 0) + (n - head + chunk - 1) / chunk;
+            pool.parallel_for(chunks, [&](size_t i) {
+                if (head > 0) {
+                    if (i == 0) {
+                        fn(size_t(0), head);
+                        return;
+                    }
+                    --i;
+                }
+                size_t first = head + i * chunk;
+                fn(first, std::min(chunk, n - first));
+            });
+        }
+
+        /// <summary>
+        /// combine the values [first, first + n) pairwise, in a fixed order
+        /// </summary>
+        template <class _T, class _Op>
+        inline _T pairwise(const _T* first, size_t n, _Op op) {
+            if (n == 1)
+                return first[0];
+            size_t half = n / 2;
+            return op(pairwise(first, half, op), pairwise(first + half, n - half, op));
+        }
+
+        /// <summary>
+        /// deterministic blocked reduction: partial(first, length) of every block, combined pairwise
+        /// </summary>
+        template <class _T, class _Policy, class _Partial, class _Op>
+        inline _T reduce(const _Policy& policy, size_t n, _T init, _Partial partial, _Op op) {
+            if (n == 0)
+                return init;
+            const size_t block = MATH_PARALLEL_BLOCK_SIZE;
+            const size_t blocks = (n + block - 1) / block;
+            std::vector<_T> partials(blocks);
+            auto compute = [&](size_t b) {
+                size_t first = b * block;
+                partials[b] = partial(first, std::min(block, n - first));
+            };
+            if constexpr (std::is_same<_Policy, execution::parallel_policy>::value) {
+                thread_pool& pool = policy.threads();
+                if (n >= MATH_PARALLEL_MIN_SIZE && pool.size() > 1) {
+                    // several blocks per task, the result does not depend on the grouping
+                    const size_t group = std::max<size_t>(1, blocks / (4 * pool.size()));
+                    pool.parallel_for((blocks + group - 1) / group, [&](size_t g) {
+                        for (size_t b = g * group; b < std::min(blocks, (g + 1) * group); ++b)
+                            compute(b);
+                    });
+                    return pairwise(partials.data(), blocks, op);
+                }
+            }
+            for (size_t b = 0; b < blocks; ++b)
+                compute(b);
+            return pairwise(partials.data(), blocks, op);
+        }
+
+        /// <summary>
+        /// sum of |x|^_l of a segment (the maximum of |x| for _l = Eigen::Infinity)
+        /// </summary>
+        template <int _l, class _Derived>
+        inline typename _Derived::RealScalar lp_partial(const Eigen::MatrixBase<_Derived>& segment) {
+            using std::pow;
+            if constexpr (_l == Eigen::Infinity)
+                return segment.cwiseAbs().maxCoeff();
+            else if constexpr (_l == 1)
+                return segment.cwiseAbs().sum();
+            else if constexpr (_l == 2)
+                return segment.squaredNorm();
+            else
+                return segment.cwiseAbs().array().pow(static_cast<typename _Derived::RealScalar>(_l)).sum();
+        }
+
+        /// <summary>
+        /// call fn(first, length) for 'parts' consecutive ranges covering [0, n), one range per task
+        /// </summary>
+        template <class _Fn>
+        inline void for_each_range(thread_pool& pool, size_t n, size_t parts, _Fn&& fn) {
+            parts = std::max<size_t>(1, std::min(parts, n));
+            const size_t length = n / parts;
+            const size_t rest = n % parts;
+            pool.parallel_for(parts, [&](size_t i) {
+                fn(i * length + std::min(i, rest), length + (i < rest ? 1 : 0));
+            });
+        }
+
+        /// <summary>
+        /// evaluate a vector expression into 'dst' chunk by chunk (dst has the size of the expression)
+        /// </summary>
+        template <class _Dst, class _Derived>
+        inline void assign_chunks(const execution::parallel_policy& policy, _Dst&& dst, const Eigen::MatrixBase<_Derived>& expr) {
+            for_each_chunk(policy, dst.data(), static_cast<size_t>(expr.size()), [&](size_t first, size_t length) {
+                dst.segment(first, length) = expr.segment(first, length);
+            });
+        }
+    }
+
+    namespace eigen {
+        /// <summary>
+        /// evaluate a coefficient-wise vector expression into 'dst', sequential
+        /// </summary>
+        template <class _T, class _Derived>
+        inline void assign(const execution::sequenced_policy&, vector<_T>& dst, const Eigen::MatrixBase<_Derived>& expr) {
+            dst = expr;
+        }
+
+        /// <summary>
+        /// evaluate a coefficient-wise vector expression into 'dst', in parallel
+        /// Note: every thread evaluates only a segment of the expression, therefore the expression must not
+        /// contain products or other operations which need the whole operand for one coefficient.
+        /// The expression may refer to 'dst' coefficient-wise (e.g. dst = dst * 2.0).
+        /// </summary>
+        template <class _T, class _Derived>
+        inline void assign(const execution::parallel_policy& policy, vector<_T>& dst, const Eigen::MatrixBase<_Derived>& expr) {
+            EIGEN_STATIC_ASSERT_VECTOR_ONLY(_Derived);
+            if (static_cast<size_t>(expr.size()) != dst.size()) {
+                // evaluate into new memory of the resource of dst, expr may refer to dst; the threads write every element
+                vector<_T> tmp(expr.size(), math::uninitialized, dst.resource());
+                detail::assign_chunks(policy, tmp.eigen(), expr);
+                dst = std::move(tmp);
+                return;
+            }
+            detail::assign_chunks(policy, dst.eigen(), expr);
+        }
+
+        /// <summary>
+        /// evaluate a coefficient-wise vector expression into a view, in parallel
+        /// </summary>
+        template <class _T, class _S, class _Derived>
+        inline void assign(const execution::parallel_policy& policy, vector_view<_T, _S>& dst, const Eigen::MatrixBase<_Derived>& expr) {
+            EIGEN_STATIC_ASSERT_VECTOR_ONLY(_Derived);
+            eigen_assert(expr.size() == dst.size());
+            detail::assign_chunks(policy, dst.eigen(), expr);
+        }
+
+        /// <summary>
+        /// evaluate a coefficient-wise vector expression into a view, sequential
+        /// </summary>
+        template <class _T, class _S, class _Derived>
+        inline void assign(const execution::sequenced_policy&, vector_view<_T, _S>& dst, const Eigen::MatrixBase<_Derived>& expr) {
+            dst = expr;
+        }
+
+        /// <summary>
+        /// set all elements of a vector to 'value', sequential
+        /// </summary>
+        template <class _T>
+        inline void fill(const execution::sequenced_policy&, vector<_T>& dst, const _T& value) {
+            dst.eigen().setConstant(value);
+        }
+
+        /// <summary>
+        /// set all elements of a vector to 'value', in parallel chunks
+        /// After an uninitialized construction (math::uninitialized), this is the first touch of the memory: the
+        /// pages are mapped by the threads of the pool and placed on their NUMA nodes, instead of all on the node of
+        /// the calling thread.
+        /// </summary>
+        template <class _T>
+        inline void fill(const execution::parallel_policy& policy, vector<_T>& dst, const _T& value) {
+            _T* data = dst.data();
+            detail::for_each_chunk(policy, data, dst.size(), [&](size_t first, size_t length) {
+                std::fill_n(data + first, length, value);
+            });
+        }
+
+        /// <summary>
+        /// set all elements of a matrix to 'value', sequential
+        /// </summary>
+        template <class _T, int _L>
+        inline void fill(const execution::sequenced_policy&, matrix<_T, Eigen::Dynamic, Eigen::Dynamic, _L>& dst, const _T& value) {
+            dst.eigen().setConstant(value);
+        }
+
+        /// <summary>
+        /// set all elements of a matrix to 'value', in parallel chunks (first touch, see above)
+        /// </summary>
+        template <class _T, int _L>
+        inline void fill(const execution::parallel_policy& policy, matrix<_T, Eigen::Dynamic, Eigen::Dynamic, _L>& dst, const _T& value) {
+            _T* data = dst.data();
+            detail::for_each_chunk(policy, data, dst.size(), [&](size_t first, size_t length) {
+                std::fill_n(data + first, length, value);
+            });
+        }
+
+        /// <summary>
+        /// accumulate/sum all entries of a vector expression (deterministic blocked pairwise summation)
+        /// </summary>
+        template <class _Policy, class _Derived>
+        inline typename _Derived::Scalar sum(const _Policy& policy, const Eigen::MatrixBase<_Derived>& vec) {
+            EIGEN_STATIC_ASSERT_VECTOR_ONLY(_Derived);
+            using scalar_type = typename _Derived::Scalar;
+            return detail::reduce<scalar_type>(policy, vec.size(), scalar_type(0),
+                [&vec](size_t first, size_t length) { return vec.segment(first, length).sum(); },
+                [](const scalar_type& a, const scalar_type& b) { return a + b; });
+        }
+
+        /// <summary>
+        /// accumulate/sum all entries of a vector (deterministic blocked pairwise summation)
+        /// </summary>
+        template <class _Policy, class _T, int _N>
+        inline _T sum(const _Policy& policy, const vector<_T, _N>& vec) {
+            return sum(policy, vec.eigen());
+        }
+
+        /// <summary>
+        /// general l-norm of a vector expression, _l = Eigen::Infinity: maximum norm (deterministic)
+        /// </summary>
+        template <int _l, class _Policy, class _Derived>
+        inline typename _Derived::RealScalar norm(const _Policy& policy, const Eigen::MatrixBase<_Derived>& vec) {
+            EIGEN_STATIC_ASSERT_VECTOR_ONLY(_Derived);
+            using std::pow;
+            using std::sqrt;
+            using real_type = typename _Derived::RealScalar;
+            if constexpr (_l == Eigen::Infinity) {
+                return detail::reduce<real_type>(policy, vec.size(), real_type(0),
+                    [&vec](size_t first, size_t length) { return detail::lp_partial<_l>(vec.segment(first, length)); },
+                    [](const real_type& a, const real_type& b) { return std::max(a, b); });
+            }
+            else {
+                real_type s = detail::reduce<real_type>(policy, vec.size(), real_type(0),
+                    [&vec](size_t first, size_t length) { return detail::lp_partial<_l>(vec.segment(first, length)); },
+                    [](const real_type& a, const real_type& b) { return a + b; });
+                if constexpr (_l == 1)
+                    return s;
+                else if constexpr (_l == 2)
+                    return sqrt(s);
+                else
+                    return pow(s, real_type(1) / real_type(_l));
+            }
+        }
+
+        /// <summary>
+        /// general l-norm of a vector (deterministic)
+        /// </summary>
+        template <int _l, class _Policy, class _T, int _N>
+        inline _T norm(const _Policy& policy, const vector<_T, _N>& vec) {
+            return norm<_l>(policy, vec.eigen());
+        }
+
+        /// <summary>
+        /// norm of a vector expression (deterministic)
+        /// </summary>
+        template <class _Policy, class _Derived>
+        inline typename _Derived::RealScalar norm(const _Policy& policy, const Eigen::MatrixBase<_Derived>& vec) {
+            return norm<2>(policy, vec);
+        }
+
+        /// <summary>
+        /// norm of a vector (deterministic)
+        /// </summary>
+        template <class _Policy, class _T, int _N>
+        inline _T norm(const _Policy& policy, const vector<_T, _N>& vec) {
+            return norm<2>(policy, vec.eigen());
+        }
+
+        /// <summary>
+        /// normalize a vector via general l-norm
+        /// </summary>
+        template <int _l, class _Policy, class _T>
+        inline void normalize(const _Policy& policy, vector<_T>& vec) {
+            _T n = norm<_l>(policy, vec);
+            assign(policy, vec, vec.eigen() / n);
+        }
+
+        /// <summary>
+        /// normalize a vector
+        /// </summary>
+        template <class _Policy, class _T>
+        inline void normalize(const _Policy& policy, vector<_T>& vec) {
+            normalize<2>(policy, vec);
+        }
+
+        /// <summary>
+        /// normalize a vector view via general l-norm (in place)
+        /// </summary>
+        template <int _l, class _Policy, class _T, class _S>
+        inline void normalize(const _Policy& policy, vector_view<_T, _S>& vec) {
+            _T n = norm<_l>(policy, vec.eigen());
+            assign(policy, vec, vec.eigen() / n);
+        }
+
+        /// <summary>
+        /// normalize a vector view (in place)
+        /// </summary>
+        template <class _Policy, class _T, class _S>
+        inline void normalize(const _Policy& policy, vector_view<_T, _S>& vec) {
+            normalize<2>(policy, vec);
+        }
+
+        /// <summary>
+        /// coefficient-wise vector multiplication: a[i] * b[i] = c[i]
+        /// </summary>
+        template <class _Policy, class _T, int _N>
+        inline vector<_T> cprod(const _Policy& policy, const vector<_T, _N>& vec1, const vector<_T, _N>& vec2) {
+            vector<_T> result;
+            assign(policy, result, vec1.eigen().cwiseProduct(vec2.eigen()));
+            return result;
+        }
+
+        /// <summary>
+        /// coefficient-wise vector division: a[i] / b[i] = c[i]
+        /// </summary>
+        template <class _Policy, class _T, int _N>
+        inline vector<_T> cdiv(const _Policy& policy, const vector<_T, _N>& vec1, const vector<_T, _N>& vec2) {
+            vector<_T> result;
+            assign(policy, result, vec1.eigen().cwiseQuotient(vec2.eigen()));
+            return result;
+        }
+
+        /// <summary>
+        /// vector-vector addition
+        /// </summary>
+        template <class _Policy, class _T, int _N>
+        inline vector<_T> add(const _Policy& policy, const vector<_T, _N>& lhs, const vector<_T, _N>& rhs) {
+            vector<_T> result;
+            assign(policy, result, lhs.eigen() + rhs.eigen());
+            return result;
+        }
+
+        /// <summary>
+        /// vector-vector subtraction
+        /// </summary>
+        template <class _Policy, class _T, int _N>
+        inline vector<_T> subtract(const _Policy& policy, const vector<_T, _N>& lhs, const vector<_T, _N>& rhs) {
+            vector<_T> result;
+            assign(policy, result, lhs.eigen() - rhs.eigen());
+            return result;
+        }
+
+        /// <summary>
+        /// vector-scalar multiplication
+        /// </summary>
+        template <class _Policy, class _T, int _N>
+        inline vector<_T> multiply(const _Policy& policy, const vector<_T, _N>& vec, const _T& scalar) {
+            vector<_T> result;
+            assign(policy, result, vec.eigen() * scalar);
+            return result;
+        }
+
+        /// <summary>
+        /// vector-scalar division
+        /// </summary>
+        template <class _Policy, class _T, int _N>
+        inline vector<_T> divide(const _Policy& policy, const vector<_T, _N>& vec, const _T& scalar) {
+            vector<_T> result;
+            assign(policy, result, vec.eigen() / scalar);
+            return result;
+        }
+
+        /// <summary>
+        /// matrix-matrix product dst = a * b, sequential (see multiply_into of operators.h)
+        /// </summary>
+        template <class _T, int _R, int _K, int _C, int _L1, int _L2, int _L3>
+        inline void multiply_into(const execution::sequenced_policy&, matrix<_T, _R, _C, _L1>& dst, const matrix<_T, _R, _K, _L2>& a, const matrix<_T, _K, _C, _L3>& b) {
+            multiply_into(dst, a, b);
+        }
+
+        /// <summary>
+        /// matrix-matrix product dst = a * b, parallel
+        /// Each thread computes one block of rows (row-major 'dst') or columns (column-major 'dst') of the result with the
+        /// blocked product of Eigen, the blocks of different threads do not overlap. Small products, and a 'dst' sharing
+        /// memory with 'a' or 'b', are evaluated by the calling thread.
+        /// </summary>
+        template <class _T, int _R, int _K, int _C, int _L1, int _L2, int _L3>
+        inline void multiply_into(const execution::parallel_policy& policy, matrix<_T, _R, _C, _L1>& dst, const matrix<_T, _R, _K, _L2>& a, const matrix<_T, _K, _C, _L3>& b) {
+            thread_pool& pool = policy.threads();
+            const size_t work = a.rows() * a.cols() * b.cols();
+            if (work < MATH_PARALLEL_MIN_PRODUCT || pool.size() == 1 || detail::aliases(dst, a) || detail::aliases(dst, b)) {
+                multiply_into(dst, a, b);
+                return;
+            }
+            detail::fit(dst, a.rows(), b.cols());
+            // obtained once by the calling thread: a copy-on-write 'dst' is detached here, not by the workers
+            auto&& d = dst.eigen();
+            if constexpr (_L1 == Eigen::RowMajor) {
+                detail::for_each_range(pool, a.rows(), pool.size(), [&](size_t first, size_t length) {
+                    d.middleRows(first, length).noalias() = a.eigen().middleRows(first, length) * b.eigen();
+                });
+            }
+            else {
+                detail::for_each_range(pool, b.cols(), pool.size(), [&](size_t first, size_t length) {
+                    d.middleCols(first, length).noalias() = a.eigen() * b.eigen().middleCols(first, length);
+                });
+            }
+        }
+
+        /// <summary>
+        /// matrix-vector product dst = a * x, sequential (see multiply_into of operators.h)
+        /// </summary>
+        template <class _T, int _R, int _C, int _L>
+        inline void multiply_into(const execution::sequenced_policy&, vector<_T, _R>& dst, const matrix<_T, _R, _C, _L>& a, const vector<_T, _C>& x) {
+            multiply_into(dst, a, x);
+        }
+
+        /// <summary>
+        /// matrix-vector product dst = a * x, parallel over blocks of rows of 'a'
+        /// Small products, and a 'dst' sharing memory with 'a' or 'x', are evaluated by the calling thread.
+        /// </summary>
+        template <class _T, int _R, int _C, int _L>
+        inline void multiply_into(const execution::parallel_policy& policy, vector<_T, _R>& dst, const matrix<_T, _R, _C, _L>& a, const vector<_T, _C>& x) {
+            thread_pool& pool = policy.threads();
+            if (a.size() < MATH_PARALLEL_MIN_SIZE || pool.size() == 1 || detail::aliases(dst, a) || detail::aliases(dst, x)) {
+                multiply_into(dst, a, x);
+                return;
+            }
+            detail::fit(dst, a.rows());
+            // obtained once by the calling thread: a copy-on-write 'dst' is detached here, not by the workers
+            auto&& d = dst.eigen();
+            // a few blocks per thread for load balancing, the blocks of dst start at cache line boundaries
+            const size_t line = std::max<size_t>(1, MATH_CACHE_LINE_SIZE / sizeof(_T));
+            const size_t rows = a.rows();
+            size_t block = std::max<size_t>(line, rows / (4 * pool.size()));
+            block = (block + line - 1) / line * line;
+            pool.parallel_for((rows + block - 1) / block, [&](size_t i) {
+                const size_t first = i * block;
+                const size_t length = std::min(block, rows - first);
+                d.segment(first, length).noalias() = a.eigen().middleRows(first, length) * x.eigen();
+            });
+        }
+
+        /// <summary>
+        /// matrix-matrix product a * b
+        /// </summary>
+        template <class _Policy, class _T, int _R, int _K, int _C, int _L1, int _L2>
+        inline matrix<_T, _R, _C, _L1> multiply(const _Policy& policy, const matrix<_T, _R, _K, _L1>& a, const matrix<_T, _K, _C, _L2>& b) {
+            matrix<_T, _R, _C, _L1> result;
+            multiply_into(policy, result, a, b);
+            return result;
+        }
+
+        /// <summary>
+        /// matrix-vector product a * x
+        /// </summary>
+        template <class _Policy, class _T, int _R, int _C, int _L>
+        inline vector<_T, _R> multiply(const _Policy& policy, const matrix<_T, _R, _C, _L>& a, const vector<_T, _C>& x) {
+            vector<_T, _R> result;
+            multiply_into(policy, result, a, x);
+            return result;
+        }
+    }
+}
\ No newline at end of file
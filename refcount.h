@@ -0,0 +1,274 @@
+/*
+ *  refcount.h
+ *  Created by Matthias Kesenheimer on 19.06.22.
+ *  Copyright 2022. All rights reserved.
+ *  More information about the Eigen library at http://eigen.tuxfamily.org/dox/index.html
+ */
+
+#pragma once
+#include <atomic>
+#include <utility>
+#include <cstddef>
+
+namespace math {
+    /// <summary>
+    /// reference counting policies for refcounted<_Base, _Policy>
+    /// </summary>
+    namespace refcount {
+        /// <summary>
+        /// no reference counter (plain value semantics, no addRef()/release())
+        /// </summary>
+        struct none {};
+
+        /// <summary>
+        /// plain integer counter, for objects shared within one thread only
+        /// </summary>
+        struct non_atomic {
+            using counter_type = int;
+
+            static void increment(counter_type& count) {
+                ++count;
+            }
+
+            /// <summary>
+            /// returns true if the last reference was removed
+            /// </summary>
+            static bool decrement(counter_type& count) {
+                return --count == 0;
+            }
+
+            static int load(const counter_type& count) {
+                return count;
+            }
+        };
+
+        /// <summary>
+        /// atomic counter, for objects shared across threads
+        /// </summary>
+        struct atomic {
+            using counter_type = std::atomic<int>;
+
+            static void increment(counter_type& count) {
+                // a new reference can only be made from an existing one, no ordering needed
+                count.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            /// <summary>
+            /// returns true if the last reference was removed
+            /// </summary>
+            static bool decrement(counter_type& count) {
+                // acquire/release: all writes of other owners are visible before the object is deleted
+                return count.fetch_sub(1, std::memory_order_acq_rel) == 1;
+            }
+
+            static int load(const counter_type& count) {
+                return count.load(std::memory_order_relaxed);
+            }
+        };
+    }
+
+    /// <summary>
+    /// intrusively reference counted container, e.g. refcounted<math::vector<double>, math::refcount::atomic>
+    /// math::vector and math::matrix have no reference counter themselves, only the objects which are shared
+    /// via addRef()/release() (or math::intrusive_ptr) pay for the counter.
+    /// The object is derived from _Base and can be used wherever a _Base is expected.
+    /// Notiz zum Zaehlen der Referenzen:
+    /// - Beim Anlegen eines Objekts muss der Referenzzaehler immer 1 sein, d.h. auch wenn der move-constructor
+    ///   verwendet wird. Es wird ein neues Objekt erzeugt, auf die bisher nur eine Referenz zeigt.
+    ///   Beim Move-Konstruktor sollen ja nur die Daten verschoben werden. Die Referenzen zum alten Objekt sollen trotzdem bestehen
+    ///   bleiben.
+    /// - Bei den Kopier- bzw. Move-Operatoren werden ausserdem auch nur die Daten kopiert bzw. verschoben.
+    ///   Die urspruenglichen Referenzen duerfen von dieser Aktion nicht beeinflusst werden.
+    ///   Deshalb werden in diesen Faellen die Referenzzaehler nicht veraendert.
+    /// </summary>
+    template <class _Base, class _Policy = refcount::atomic>
+    class refcounted : public _Base {
+    public:
+        using base_type = _Base;
+        using policy_type = _Policy;
+        using _Base::_Base;
+        using _Base::operator=;
+
+        refcounted()
+            : _Base() {}
+
+        refcounted(const refcounted& other)
+            : _Base(other) {}
+
+        refcounted(refcounted&& other) noexcept
+            : _Base(std::move(other)) {}
+
+        refcounted(const _Base& other)
+            : _Base(other) {}
+
+        refcounted(_Base&& other) noexcept
+            : _Base(std::move(other)) {}
+
+        refcounted& operator=(const refcounted& rhs) {
+            _Base::operator=(rhs);
+            return *this;
+        }
+
+        refcounted& operator=(refcounted&& rhs) {
+            _Base::operator=(std::move(rhs));
+            return *this;
+        }
+
+        /// <summary>
+        /// add reference
+        /// </summary>
+        void addRef() {
+            _Policy::increment(m_refCount);
+        }
+
+        /// <summary>
+        /// remove reference, the object is deleted with the last reference
+        /// </summary>
+        void release() {
+            if (_Policy::decrement(m_refCount))
+                delete this;
+        }
+
+        /// <summary>
+        /// current number of references
+        /// </summary>
+        int use_count() const {
+            return _Policy::load(m_refCount);
+        }
+
+    private:
+        typename _Policy::counter_type m_refCount{1};
+    };
+
+    /// <summary>
+    /// no reference counter: refcounted<_Base, refcount::none> behaves like _Base
+    /// </summary>
+    template <class _Base>
+    class refcounted<_Base, refcount::none> : public _Base {
+    public:
+        using base_type = _Base;
+        using policy_type = refcount::none;
+        using _Base::_Base;
+        using _Base::operator=;
+
+        refcounted()
+            : _Base() {}
+
+        refcounted(const _Base& other)
+            : _Base(other) {}
+
+        refcounted(_Base&& other) noexcept
+            : _Base(std::move(other)) {}
+    };
+
+    /// <summary>
+    /// smart pointer for objects with addRef()/release(), e.g. math::refcounted<math::matrix<double>>
+    /// Unlike std::shared_ptr the counter lives in the object, a handoff costs one increment and no allocation.
+    /// </summary>
+    template <class _T>
+    class intrusive_ptr {
+    public:
+        using element_type = _T;
+
+        intrusive_ptr() noexcept
+            : m_ptr(nullptr) {}
+
+        /// <summary>
+        /// take a reference to 'ptr'
+        /// addRef = false: adopt the reference the object was created with (refcounted objects start with a count of 1)
+        /// </summary>
+        intrusive_ptr(_T* ptr, bool addRef = true)
+            : m_ptr(ptr) {
+                if (m_ptr && addRef)
+                    m_ptr->addRef();
+            }
+
+        intrusive_ptr(const intrusive_ptr& other)
+            : m_ptr(other.m_ptr) {
+                if (m_ptr)
+                    m_ptr->addRef();
+            }
+
+        intrusive_ptr(intrusive_ptr&& other) noexcept
+            : m_ptr(other.m_ptr) {
+                other.m_ptr = nullptr;
+            }
+
+        ~intrusive_ptr() {
+            if (m_ptr)
+                m_ptr->release();
+        }
+
+        intrusive_ptr& operator=(const intrusive_ptr& rhs) {
+            intrusive_ptr(rhs).swap(*this);
+            return *this;
+        }
+
+        intrusive_ptr& operator=(intrusive_ptr&& rhs) noexcept {
+            intrusive_ptr(std::move(rhs)).swap(*this);
+            return *this;
+        }
+
+        /// <summary>
+        /// drop the reference
+        /// </summary>
+        void reset() {
+            intrusive_ptr().swap(*this);
+        }
+
+        /// <summary>
+        /// drop the reference and take a reference to 'ptr'
+        /// </summary>
+        void reset(_T* ptr, bool addRef = true) {
+            intrusive_ptr(ptr, addRef).swap(*this);
+        }
+
+        /// <summary>
+        /// give up the reference without releasing it
+        /// </summary>
+        _T* detach() noexcept {
+            _T* ptr = m_ptr;
+            m_ptr = nullptr;
+            return ptr;
+        }
+
+        void swap(intrusive_ptr& other) noexcept {
+            std::swap(m_ptr, other.m_ptr);
+        }
+
+        _T* get() const noexcept {
+            return m_ptr;
+        }
+
+        _T& operator*() const noexcept {
+            return *m_ptr;
+        }
+
+        _T* operator->() const noexcept {
+            return m_ptr;
+        }
+
+        explicit operator bool() const noexcept {
+            return m_ptr != nullptr;
+        }
+
+        friend bool operator==(const intrusive_ptr& lhs, const intrusive_ptr& rhs) noexcept {
+            return lhs.m_ptr == rhs.m_ptr;
+        }
+
+        friend bool operator!=(const intrusive_ptr& lhs, const intrusive_ptr& rhs) noexcept {
+            return lhs.m_ptr != rhs.m_ptr;
+        }
+
+    private:
+        _T* m_ptr;
+    };
+
+    /// <summary>
+    /// create a reference counted object, e.g. make_intrusive<math::refcounted<math::vector<double>>>(100)
+    /// </summary>
+    template <class _T, class... _Args>
+    inline intrusive_ptr<_T> make_intrusive(_Args&&... args) {
+        return intrusive_ptr<_T>(new _T(std::forward<_Args>(args)...), false);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,280 @@
+/*
+ *  ring_matrix.h
+ *  Created by Matthias Kesenheimer on 19.06.22.
+ *  Copyright 2022. All rights reserved.
+ *  More information about the Eigen library at http://eigen.tuxfamily.org/dox/index.html
+ */
+
+#pragma once
+#include "matrix.h"
+#include <Eigen/Dense>
+#include <algorithm>
+#include <initializer_list>
+#include <utility>
+
+//#define _DEBUG
+#ifdef _DEBUG
+#include <iostream>
+#endif
+
+// Sliding window over the newest rows:
+//     math::ring_matrix<double> window(1000, 8);        // at most 1000 rows with 8 columns
+//     window.push_back(observation);                     // O(1), overwrites the oldest row if full
+//     auto [a, b] = window.segments();                   // oldest rows first, b is empty unless wrapped
+//     math::matrix<double> gram = a.transpose() * a + b.transpose() * b;
+//     math::matrix<double>::map_type x = window.linearize(); // one block (rotates the storage if wrapped)
+// Row 0 is always the oldest row of the window.
+
+namespace math {
+    /// <summary>
+    /// row-major matrix with a fixed row capacity, used as a ring buffer of rows
+    /// </summary>
+    template <class _T>
+    class ring_matrix {
+    public:
+        /// <summary>
+        /// typedefs
+        /// </summary>
+        using storage_type = matrix<_T>;
+        using map_type = typename storage_type::map_type;
+        using const_map_type = typename storage_type::const_map_type;
+        using vector_map_type = typename storage_type::vector_map_type;
+        using const_vector_map_type = typename storage_type::const_vector_map_type;
+        using value_type = _T;
+        using size_type = size_t;
+        using reference = value_type&;
+        using const_reference = const value_type&;
+
+        /// <summary>
+        /// empty window without capacity
+        /// </summary>
+        ring_matrix()
+            : m_head(0), m_size(0) {}
+
+        /// <summary>
+        /// empty window for at most 'capacityRows' rows with 'cols' columns, the memory is allocated once
+        /// </summary>
+        ring_matrix(size_type capacityRows, size_type cols)
+            : m_data(capacityRows, cols), m_head(0), m_size(0) {}
+
+        /// <summary>
+        /// number of rows in the window
+        /// </summary>
+        size_type rows() const {
+            return m_size;
+        }
+
+        /// <summary>
+        /// number of columns
+        /// </summary>
+        size_type cols() const {
+            return m_data.cols();
+        }
+
+        /// <summary>
+        /// number of elements in the window
+        /// </summary>
+        size_type size() const {
+            return m_size * cols();
+        }
+
+        /// <summary>
+        /// maximum number of rows
+        /// </summary>
+        size_type capacity_rows() const {
+            return m_data.rows();
+        }
+
+        /// <summary>
+        /// is the window empty?
+        /// </summary>
+        bool empty() const {
+            return m_size == 0;
+        }
+
+        /// <summary>
+        /// does the next push_back() overwrite the oldest row?
+        /// </summary>
+        bool full() const {
+            return m_size == capacity_rows();
+        }
+
+        /// <summary>
+        /// remove all rows, the memory is kept
+        /// </summary>
+        void clear() {
+            m_head = 0;
+            m_size = 0;
+        }
+
+        /// <summary>
+        /// append a row with cols() elements, the oldest row is overwritten if the window is full
+        /// </summary>
+        template <class _Vec>
+        void push_back(const _Vec& vec) {
+#if defined(_DEBUG) || defined(DEBUG)
+            if (static_cast<size_type>(vec.size()) != cols())
+                std::cout << "Warning: ring_matrix::push_back: size of vector does not match the number of columns." << std::endl;
+#endif
+            value_type* dst = next_row();
+            for (size_type i = 0; i < cols(); ++i)
+                dst[i] = vec[i];
+        }
+
+        /// <summary>
+        /// append a row by initializer list
+        /// </summary>
+        void push_back(std::initializer_list<_T> vec) {
+            eigen_assert(vec.size() == cols());
+            std::copy(vec.begin(), vec.end(), next_row());
+        }
+
+        /// <summary>
+        /// append a row from a plain array with cols() elements
+        /// </summary>
+        void push_back(const value_type* data) {
+            std::copy(data, data + cols(), next_row());
+        }
+
+        /// <summary>
+        /// append a row and return it for writing, the values are those of the overwritten row (or undefined)
+        /// </summary>
+        vector_map_type emplace_back() {
+            return vector_map_type(next_row(), cols(), 1);
+        }
+
+        /// <summary>
+        /// remove the oldest row
+        /// </summary>
+        void pop_front() {
+            eigen_assert(!empty());
+            m_head = wrap(m_head + 1);
+            m_size--;
+        }
+
+        /// <summary>
+        /// accessing elements, row 0 is the oldest row
+        /// </summary>
+        reference operator()(const size_type r, const size_type c) {
+            eigen_assert(r < rows() && c < cols());
+            return m_data.data()[slot(r) * cols() + c];
+        }
+
+        /// <summary>
+        /// accessing elements, row 0 is the oldest row
+        /// </summary>
+        const_reference operator()(const size_type r, const size_type c) const {
+            eigen_assert(r < rows() && c < cols());
+            return m_data.data()[slot(r) * cols() + c];
+        }
+
+        /// <summary>
+        /// row 'r' (0 is the oldest row)
+        /// </summary>
+        vector_map_type row(const size_type r) {
+            eigen_assert(r < rows());
+            return vector_map_type(m_data.data() + slot(r) * cols(), cols(), 1);
+        }
+
+        /// <summary>
+        /// row 'r' (0 is the oldest row)
+        /// </summary>
+        const_vector_map_type row(const size_type r) const {
+            eigen_assert(r < rows());
+            return const_vector_map_type(m_data.data() + slot(r) * cols(), cols(), 1);
+        }
+
+        /// <summary>
+        /// oldest row
+        /// </summary>
+        const_vector_map_type front() const {
+            return row(0);
+        }
+
+        /// <summary>
+        /// newest row
+        /// </summary>
+        const_vector_map_type back() const {
+            return row(rows() - 1);
+        }
+
+        /// <summary>
+        /// is the window one contiguous block in memory?
+        /// </summary>
+        bool contiguous() const {
+            return m_head + m_size <= capacity_rows();
+        }
+
+        /// <summary>
+        /// the window as two contiguous blocks of rows, the older rows first
+        /// The second block has no rows unless the window wraps around the end of the storage.
+        /// The blocks are valid until the next push_back(), pop_front() or linearize().
+        /// </summary>
+        std::pair<const_map_type, const_map_type> segments() const {
+            const value_type* d = m_data.data();
+            size_type first = std::min(m_size, capacity_rows() - m_head);
+            return std::pair<const_map_type, const_map_type>(const_map_type(d + m_head * cols(), first, cols()),
+                                                             const_map_type(d, m_size - first, cols()));
+        }
+
+        /// <summary>
+        /// the window as one contiguous block
+        /// If the window wraps, the storage is rotated in place first (O(capacity), no allocation).
+        /// </summary>
+        map_type linearize() {
+            value_type* d = m_data.data();
+            if (!contiguous()) {
+                std::rotate(d, d + m_head * cols(), d + capacity_rows() * cols());
+                m_head = 0;
+            }
+            return map_type(d + m_head * cols(), m_size, cols());
+        }
+
+        /// <summary>
+        /// copy of the window as a math::matrix, the storage is not changed
+        /// </summary>
+        storage_type to_matrix() const {
+            std::pair<const_map_type, const_map_type> s = segments();
+            storage_type result(m_size, cols());
+            result.eigen().topRows(s.first.rows()) = s.first;
+            result.eigen().bottomRows(s.second.rows()) = s.second;
+            return result;
+        }
+
+    private:
+        /// <summary>
+        /// position of the storage row for logical row 'r'
+        /// </summary>
+        size_type slot(size_type r) const {
+            return wrap(m_head + r);
+        }
+
+        /// <summary>
+        /// index 'i' < 2 * capacity_rows() mapped into the storage
+        /// </summary>
+        size_type wrap(size_type i) const {
+            return i >= capacity_rows() ? i - capacity_rows() : i;
+        }
+
+        /// <summary>
+        /// storage of the next row, the oldest row is dropped if the window is full
+        /// </summary>
+        value_type* next_row() {
+            eigen_assert(capacity_rows() > 0);
+            size_type s;
+            if (full()) {
+                s = m_head;
+                m_head = wrap(m_head + 1);
+            }
+            else {
+                s = slot(m_size);
+                m_size++;
+            }
+            return m_data.data() + s * cols();
+        }
+
+        storage_type m_data;
+        size_type m_head;
+        size_type m_size;
+    };
+}
\ No newline at end of file
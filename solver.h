@@ -0,0 +1,200 @@
+/*
+ *  solver.h
+ *  Created by Matthias Kesenheimer on 19.06.22.
+ *  Copyright 2022. All rights reserved.
+ *  More information about the Eigen library at http://eigen.tuxfamily.org/dox/index.html
+ */
+
+#pragma once
+#include "operators.h"
+#include <Eigen/Dense>
+#include <type_traits>
+
+// Linear solves with a cached factorization. Solving with the decomposition is faster and more accurate
+// than multiplying with math::eigen::inverse(A):
+//     math::solver<double, math::decomposition::llt> s(A); // factor once
+//     math::vector<double> x = s.solve(b);                 // reuse for many right-hand sides
+//     s.solve_into(x, b2);                                 // without allocation
+//     s.rank_update(v);                                    // A + v * v^T, without refactoring
+
+namespace math {
+    /// <summary>
+    /// decompositions for math::solver
+    /// </summary>
+    namespace decomposition {
+        /// <summary>
+        /// LU decomposition with partial pivoting, for invertible square matrices
+        /// </summary>
+        struct lu {
+            template <class _Matrix>
+            using type = Eigen::PartialPivLU<_Matrix>;
+        };
+
+        /// <summary>
+        /// Cholesky decomposition, for symmetric positive definite matrices (fastest)
+        /// </summary>
+        struct llt {
+            template <class _Matrix>
+            using type = Eigen::LLT<_Matrix>;
+        };
+
+        /// <summary>
+        /// robust Cholesky decomposition with pivoting, for symmetric positive or negative semidefinite matrices
+        /// </summary>
+        struct ldlt {
+            template <class _Matrix>
+            using type = Eigen::LDLT<_Matrix>;
+        };
+
+        /// <summary>
+        /// QR decomposition with column pivoting, for any (also non-square or rank-deficient) matrix,
+        /// the solution is the least-squares solution
+        /// </summary>
+        struct qr {
+            template <class _Matrix>
+            using type = Eigen::ColPivHouseholderQR<_Matrix>;
+        };
+    }
+
+    /// <summary>
+    /// solver for A * x = b with a cached decomposition of the _R x _C matrix A
+    /// _Decomposition = decomposition::lu, llt, ldlt or qr
+    /// </summary>
+    template <class _T, class _Decomposition = decomposition::lu, int _R = Eigen::Dynamic, int _C = _R>
+    class solver {
+    public:
+        /// <summary>
+        /// typedefs
+        /// </summary>
+        using eigen_type = Eigen::Matrix<_T, _R, _C>;
+        using decomposition_type = typename _Decomposition::template type<eigen_type>;
+        using matrix_type = matrix<_T, _R, _C>;
+        using value_type = _T;
+        using size_type = size_t;
+
+        /// <summary>
+        /// construct a solver without decomposition, call compute() before solving
+        /// </summary>
+        solver()
+            : m_decomposition() {}
+
+        /// <summary>
+        /// construct a solver and factor 'mat' (row-major or column-major)
+        /// </summary>
+        template <int _L>
+        explicit solver(const matrix<_T, _R, _C, _L>& mat)
+            : m_decomposition(mat.eigen()) {}
+
+        /// <summary>
+        /// construct a solver and factor an Eigen matrix or expression
+        /// </summary>
+        template <class _Derived>
+        explicit solver(const Eigen::MatrixBase<_Derived>& mat)
+            : m_decomposition(mat) {}
+
+        /// <summary>
+        /// factor 'mat', the memory of the previous decomposition is reused if the size does not change
+        /// </summary>
+        template <int _L>
+        solver& compute(const matrix<_T, _R, _C, _L>& mat) {
+            m_decomposition.compute(mat.eigen());
+            return *this;
+        }
+
+        template <class _Derived>
+        solver& compute(const Eigen::MatrixBase<_Derived>& mat) {
+            m_decomposition.compute(mat);
+            return *this;
+        }
+
+        /// <summary>
+        /// true if the decomposition succeeded
+        /// (the LU decomposition does not detect singular matrices, check the result if in doubt)
+        /// </summary>
+        bool ok() const {
+            if constexpr (std::is_same<_Decomposition, decomposition::lu>::value)
+                return m_decomposition.rows() > 0;
+            else
+                return m_decomposition.rows() > 0 && m_decomposition.info() == Eigen::Success;
+        }
+
+        /// <summary>
+        /// number of rows and columns of the factored matrix
+        /// </summary>
+        size_type rows() const {
+            return m_decomposition.rows();
+        }
+
+        size_type cols() const {
+            return m_decomposition.cols();
+        }
+
+        /// <summary>
+        /// solve A * x = b
+        /// </summary>
+        vector<_T, _C> solve(const vector<_T, _R>& b) const {
+            vector<_T, _C> x;
+            solve_into(x, b);
+            return x;
+        }
+
+        /// <summary>
+        /// solve A * X = B for the right-hand sides in the columns of B
+        /// </summary>
+        template <int _K, int _L>
+        matrix<_T, _C, _K, _L> solve(const matrix<_T, _R, _K, _L>& B) const {
+            matrix<_T, _C, _K, _L> X;
+            solve_into(X, B);
+            return X;
+        }
+
+        /// <summary>
+        /// solve A * x = b into 'x', without allocating if 'x' has the right size (or enough capacity)
+        /// ('x' and 'b' may be the same vector)
+        /// </summary>
+        void solve_into(vector<_T, _C>& x, const vector<_T, _R>& b) const {
+            eigen_assert(b.size() == rows() && "solver::solve_into: size of the right-hand side does not match");
+            if (detail::aliases(x, b)) {
+                x = m_decomposition.solve(b.eigen()).eval();
+                return;
+            }
+            detail::fit(x, cols());
+            x.eigen() = m_decomposition.solve(b.eigen());
+        }
+
+        /// <summary>
+        /// solve A * X = B into 'X', without allocating if 'X' has the right size (or enough capacity)
+        /// </summary>
+        template <int _K, int _L1, int _L2>
+        void solve_into(matrix<_T, _C, _K, _L1>& X, const matrix<_T, _R, _K, _L2>& B) const {
+            eigen_assert(B.rows() == rows() && "solver::solve_into: rows of the right-hand sides do not match");
+            if (detail::aliases(X, B)) {
+                X = m_decomposition.solve(B.eigen()).eval();
+                return;
+            }
+            detail::fit(X, cols(), B.cols());
+            X.eigen() = m_decomposition.solve(B.eigen());
+        }
+
+        /// <summary>
+        /// rank-1 update of the decomposition: A + sigma * v * v^T, in O(n^2) instead of refactoring in O(n^3)
+        /// (only for decomposition::llt and decomposition::ldlt, check ok() after a downdate with sigma < 0)
+        /// </summary>
+        solver& rank_update(const vector<_T, _R>& v, const _T& sigma = _T(1)) {
+            static_assert(std::is_same<_Decomposition, decomposition::llt>::value || std::is_same<_Decomposition, decomposition::ldlt>::value,
+                "solver::rank_update: only the llt and ldlt decompositions support rank updates");
+            m_decomposition.rankUpdate(v.eigen(), sigma);
+            return *this;
+        }
+
+        /// <summary>
+        /// the underlying Eigen decomposition
+        /// </summary>
+        const decomposition_type& decomposition() const {
+            return m_decomposition;
+        }
+
+    private:
+        decomposition_type m_decomposition;
+    };
+}
\ No newline at end of file
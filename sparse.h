@@ -0,0 +1,368 @@
+/*
+ *  sparse.h
+ *  Created by Matthias Kesenheimer on 19.06.22.
+ *  Copyright 2022. All rights reserved.
+ *  More information about the Eigen library at http://eigen.tuxfamily.org/dox/index.html
+ */
+
+#pragma once
+#include "vector.h"
+#include "matrix.h"
+#include <Eigen/Sparse>
+#include <type_traits>
+#include <iterator>
+#include <algorithm>
+#include <vector>
+#include <cstddef>
+#include <cmath>
+
+namespace math {
+    /// <summary>
+    /// non-owning view of the non-zero entries of one row of a math::sparse_matrix
+    /// _T = const value_type: read-only row
+    /// The entries are sorted by their column index. Only the values of existing entries can be changed,
+    /// use sparse_matrix::insert() or coeffRef() to create new entries.
+    /// </summary>
+    template <class _T, class _Index = int>
+    class sparse_row {
+    public:
+        /// <summary>
+        /// typedefs
+        /// </summary>
+        using value_type = typename std::remove_const<_T>::type;
+        using index_type = _Index;
+        using size_type = size_t;
+
+        /// <summary>
+        /// forward iterator over the non-zero entries, *it is the value, it.index() the column
+        /// </summary>
+        class iterator {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = typename std::remove_const<_T>::type;
+            using difference_type = std::ptrdiff_t;
+            using pointer = _T*;
+            using reference = _T&;
+
+            iterator()
+                : m_value(nullptr), m_index(nullptr) {}
+
+            iterator(pointer value, const index_type* index)
+                : m_value(value), m_index(index) {}
+
+            reference operator*() const {
+                return *m_value;
+            }
+
+            pointer operator->() const {
+                return m_value;
+            }
+
+            /// <summary>
+            /// column of the current entry
+            /// </summary>
+            index_type index() const {
+                return *m_index;
+            }
+
+            iterator& operator++() {
+                ++m_value;
+                ++m_index;
+                return *this;
+            }
+
+            iterator operator++(int) {
+                iterator tmp = *this;
+                ++*this;
+                return tmp;
+            }
+
+            friend bool operator==(const iterator& lhs, const iterator& rhs) {
+                return lhs.m_value == rhs.m_value;
+            }
+
+            friend bool operator!=(const iterator& lhs, const iterator& rhs) {
+                return lhs.m_value != rhs.m_value;
+            }
+
+        private:
+            pointer m_value;
+            const index_type* m_index;
+        };
+
+        sparse_row(_T* values, const index_type* indices, size_type nonzeros)
+            : m_values(values), m_indices(indices), m_nonzeros(nonzeros) {}
+
+        /// <summary>
+        /// number of non-zero entries in the row
+        /// </summary>
+        size_type nonzeros() const {
+            return m_nonzeros;
+        }
+
+        bool empty() const {
+            return m_nonzeros == 0;
+        }
+
+        /// <summary>
+        /// column and value of the k-th non-zero entry
+        /// </summary>
+        index_type index(size_type k) const {
+            eigen_assert(k < m_nonzeros);
+            return m_indices[k];
+        }
+
+        _T& value(size_type k) const {
+            eigen_assert(k < m_nonzeros);
+            return m_values[k];
+        }
+
+        /// <summary>
+        /// value in column 'c', zero if there is no entry (binary search)
+        /// </summary>
+        value_type operator[](index_type c) const {
+            const index_type* it = std::lower_bound(m_indices, m_indices + m_nonzeros, c);
+            if (it != m_indices + m_nonzeros && *it == c)
+                return m_values[it - m_indices];
+            return value_type(0);
+        }
+
+        iterator begin() const {
+            return iterator(m_values, m_indices);
+        }
+
+        iterator end() const {
+            return iterator(m_values + m_nonzeros, m_indices + m_nonzeros);
+        }
+
+    private:
+        _T* m_values;
+        const index_type* m_indices;
+        size_type m_nonzeros;
+    };
+
+    /// <summary>
+    /// sparse matrix class
+    /// Wraps a row-major Eigen::SparseMatrix (compressed row storage), such that m[r] gives the
+    /// non-zero entries of row r like math::matrix gives its rows.
+    /// Build large matrices in one step from triplets (row, column, value):
+    ///     std::vector<math::sparse_matrix<double>::triplet> t = {{0, 0, 1.0}, {2, 1, 3.0}};
+    ///     math::sparse_matrix<double> m(3, 3, t);
+    /// Note: the memory is managed by Eigen, not by the memory resources of memory.h.
+    /// </summary>
+    template <class _T>
+    class sparse_matrix {
+    public:
+        /// <summary>
+        /// typedefs
+        /// </summary>
+        using eigen_type = Eigen::SparseMatrix<_T, Eigen::RowMajor>;
+        using value_type = _T;
+        using size_type = size_t;
+        using index_type = typename eigen_type::StorageIndex;
+        using triplet = Eigen::Triplet<_T, index_type>;
+        using row_type = sparse_row<_T, index_type>;
+        using const_row_type = sparse_row<const _T, index_type>;
+
+        /// <summary>
+        /// construct an empty sparse matrix
+        /// </summary>
+        sparse_matrix()
+            : m_eigen() {}
+
+        /// <summary>
+        /// construct a r x c sparse matrix without non-zero entries
+        /// </summary>
+        sparse_matrix(size_type r, size_type c)
+            : m_eigen(r, c) {}
+
+        /// <summary>
+        /// construct a r x c sparse matrix from triplets, the values of duplicate entries are summed up
+        /// </summary>
+        sparse_matrix(size_type r, size_type c, const std::vector<triplet>& triplets)
+            : m_eigen(r, c) {
+                set_from_triplets(triplets.begin(), triplets.end());
+            }
+
+        /// <summary>
+        /// construct a r x c sparse matrix from a range of triplets (any type with row(), col() and value())
+        /// </summary>
+        template <class _InputIt>
+        sparse_matrix(size_type r, size_type c, _InputIt first, _InputIt last)
+            : m_eigen(r, c) {
+                set_from_triplets(first, last);
+            }
+
+        /// <summary>
+        /// construct a sparse matrix from the entries of a dense matrix with an absolute value larger than 'tolerance'
+        /// </summary>
+        template <int _R, int _C, int _L>
+        explicit sparse_matrix(const matrix<_T, _R, _C, _L>& dense, const _T& tolerance = _T(0))
+            : m_eigen(dense.eigen().sparseView(_T(1), tolerance)) {}
+
+        /// <summary>
+        /// construct a sparse matrix from an Eigen sparse matrix or expression
+        /// </summary>
+        template <class _Derived>
+        sparse_matrix(const Eigen::SparseMatrixBase<_Derived>& expr)
+            : m_eigen(expr) {}
+
+        /// <summary>
+        /// assign an Eigen sparse matrix or expression
+        /// </summary>
+        template <class _Derived>
+        sparse_matrix& operator=(const Eigen::SparseMatrixBase<_Derived>& expr) {
+            m_eigen = expr;
+            return *this;
+        }
+
+        /// <summary>
+        /// replace all entries by the triplets in [first, last), the values of duplicate entries are summed up
+        /// </summary>
+        template <class _InputIt>
+        void set_from_triplets(_InputIt first, _InputIt last) {
+            m_eigen.setFromTriplets(first, last);
+        }
+
+        void set_from_triplets(const std::vector<triplet>& triplets) {
+            set_from_triplets(triplets.begin(), triplets.end());
+        }
+
+        /// <summary>
+        /// reserve memory for 'nonzerosPerRow' entries in every row (makes subsequent insert()'s efficient)
+        /// </summary>
+        void reserve(size_type nonzerosPerRow) {
+            m_eigen.reserve(Eigen::Matrix<index_type, Eigen::Dynamic, 1>::Constant(m_eigen.rows(), static_cast<index_type>(nonzerosPerRow)));
+        }
+
+        /// <summary>
+        /// insert a new entry, the entry (r, c) must not exist yet
+        /// The matrix is uncompressed afterwards, call compress() after the last insert.
+        /// </summary>
+        value_type& insert(size_type r, size_type c, const value_type& value) {
+            value_type& entry = m_eigen.insert(r, c);
+            entry = value;
+            return entry;
+        }
+
+        /// <summary>
+        /// reference to the entry (r, c), the entry is inserted if it does not exist
+        /// </summary>
+        value_type& coeffRef(size_type r, size_type c) {
+            return m_eigen.coeffRef(r, c);
+        }
+
+        /// <summary>
+        /// free the unused memory left by insert()
+        /// </summary>
+        void compress() {
+            m_eigen.makeCompressed();
+        }
+
+        /// <summary>
+        /// remove the entries with an absolute value not larger than 'tolerance'
+        /// </summary>
+        void prune(const value_type& tolerance = value_type(0)) {
+            m_eigen.prune([tolerance](const index_type&, const index_type&, const value_type& value) {
+                return std::abs(value) > tolerance;
+            });
+        }
+
+        /// <summary>
+        /// remove all entries, the size is kept
+        /// </summary>
+        void clear() {
+            m_eigen.setZero();
+        }
+
+        /// <summary>
+        /// resize, all entries are removed
+        /// </summary>
+        void resize(size_type r, size_type c) {
+            m_eigen.resize(r, c);
+        }
+
+        /// <summary>
+        /// accessing elements, zero if there is no entry
+        /// </summary>
+        value_type at(const size_type r, const size_type c) const {
+            eigen_assert(r < rows() && c < cols());
+            return m_eigen.coeff(r, c);
+        }
+
+        value_type operator()(const size_type r, const size_type c) const {
+            return at(r, c);
+        }
+
+        /// <summary>
+        /// the non-zero entries of row r
+        /// </summary>
+        row_type operator[](const size_type r) {
+            eigen_assert(r < rows());
+            const index_type first = m_eigen.outerIndexPtr()[r];
+            return row_type(m_eigen.valuePtr() + first, m_eigen.innerIndexPtr() + first, row_nonzeros(r));
+        }
+
+        const_row_type operator[](const size_type r) const {
+            eigen_assert(r < rows());
+            const index_type first = m_eigen.outerIndexPtr()[r];
+            return const_row_type(m_eigen.valuePtr() + first, m_eigen.innerIndexPtr() + first, row_nonzeros(r));
+        }
+
+        /// <summary>
+        /// dimensions
+        /// </summary>
+        size_type rows() const {
+            return m_eigen.rows();
+        }
+
+        size_type cols() const {
+            return m_eigen.cols();
+        }
+
+        size_type size() const {
+            return rows() * cols();
+        }
+
+        /// <summary>
+        /// number of non-zero entries
+        /// </summary>
+        size_type nonzeros() const {
+            return m_eigen.nonZeros();
+        }
+
+        bool empty() const {
+            return size() == 0;
+        }
+
+        /// <summary>
+        /// dense copy of the matrix
+        /// </summary>
+        matrix<_T> to_dense() const {
+            return matrix<_T>(m_eigen.toDense());
+        }
+
+        /// <summary>
+        /// return the eigen sparse matrix
+        /// </summary>
+        eigen_type& eigen() {
+            return m_eigen;
+        }
+
+        const eigen_type& eigen() const {
+            return m_eigen;
+        }
+
+    private:
+        /// <summary>
+        /// number of entries of row r (an uncompressed matrix has unused memory between the rows)
+        /// </summary>
+        size_type row_nonzeros(size_type r) const {
+            if (m_eigen.isCompressed())
+                return m_eigen.outerIndexPtr()[r + 1] - m_eigen.outerIndexPtr()[r];
+            return m_eigen.innerNonZeroPtr()[r];
+        }
+
+        eigen_type m_eigen;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,394 @@
+/*
+ *  stats.h
+ *  Created by Matthias Kesenheimer on 19.06.22.
+ *  Copyright 2022. All rights reserved.
+ *  More information about the Eigen library at http://eigen.tuxfamily.org/dox/index.html
+ */
+
+#pragma once
+#include "vector.h"
+#include "matrix.h"
+#include <Eigen/Dense>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+// Incremental statistics (Welford's algorithm), without a second pass over the data:
+//     math::running_stats<double> s;
+//     s.push_back(x);                                      // one value, O(1)
+//     std::copy(v.begin(), v.end(), std::back_inserter(s)); // any range of values
+//     s.push_back(vec);                                    // all values of a math::vector at once
+//     math::column_stats<double> c(8, true);               // 8 columns, with covariance matrix
+//     c.push_back(row);                                    // one row, O(cols) or O(cols^2) with covariance
+//     c.push_rows(mat);                                    // a block of rows, evaluated with Eigen
+//     a.merge(b);                                          // combine partial states, e.g. one per thread
+// Partial states are combined with the update of Chan et al., therefore the result of merging the states of the parts
+// agrees with a single pass over all data up to rounding.
+
+namespace math {
+    /// <summary>
+    /// running count, mean, variance, minimum and maximum of a stream of values
+    /// </summary>
+    template <class _T>
+    class running_stats {
+        static_assert(std::is_floating_point<_T>::value, "math::running_stats: the value type must be a floating point type");
+    public:
+        using value_type = _T;
+        using size_type = size_t;
+
+        running_stats() {
+            clear();
+        }
+
+        /// <summary>
+        /// add one value
+        /// </summary>
+        void push_back(const value_type& x) {
+            m_count++;
+            const value_type delta = x - m_mean;
+            m_mean += delta / static_cast<value_type>(m_count);
+            m_m2 += delta * (x - m_mean);
+            m_min = std::min(m_min, x);
+            m_max = std::max(m_max, x);
+        }
+
+        /// <summary>
+        /// add all values of a vector, the block is evaluated with Eigen and merged
+        /// </summary>
+        template <int _N>
+        void push_back(const vector<_T, _N>& vec) {
+            push_back(vec.eigen());
+        }
+
+        /// <summary>
+        /// add all coefficients of an Eigen expression
+        /// </summary>
+        template <class _Derived>
+        void push_back(const Eigen::MatrixBase<_Derived>& values) {
+            if (values.size() == 0)
+                return;
+            running_stats block;
+            block.m_count = static_cast<size_type>(values.size());
+            block.m_mean = values.mean();
+            block.m_m2 = (values.array() - block.m_mean).square().sum();
+            block.m_min = values.minCoeff();
+            block.m_max = values.maxCoeff();
+            merge(block);
+        }
+
+        /// <summary>
+        /// combine with the state of another part of the data
+        /// </summary>
+        void merge(const running_stats& other) {
+            if (other.m_count == 0)
+                return;
+            if (m_count == 0) {
+                *this = other;
+                return;
+            }
+            const size_type n = m_count + other.m_count;
+            const value_type delta = other.m_mean - m_mean;
+            const value_type wb = static_cast<value_type>(other.m_count) / static_cast<value_type>(n);
+            m_mean += delta * wb;
+            m_m2 += other.m_m2 + delta * delta * static_cast<value_type>(m_count) * wb;
+            m_count = n;
+            m_min = std::min(m_min, other.m_min);
+            m_max = std::max(m_max, other.m_max);
+        }
+
+        /// <summary>
+        /// forget all values
+        /// </summary>
+        void clear() {
+            m_count = 0;
+            m_mean = 0;
+            m_m2 = 0;
+            m_min = std::numeric_limits<value_type>::infinity();
+            m_max = -std::numeric_limits<value_type>::infinity();
+        }
+
+        /// <summary>
+        /// number of values
+        /// </summary>
+        size_type count() const {
+            return m_count;
+        }
+
+        /// <summary>
+        /// mean (0 without values)
+        /// </summary>
+        value_type mean() const {
+            return m_mean;
+        }
+
+        /// <summary>
+        /// variance with 'ddof' delta degrees of freedom: sum of squared deviations / (count() - ddof)
+        /// ddof = 1 (default): sample variance, ddof = 0: population variance. NaN if count() <= ddof.
+        /// </summary>
+        value_type variance(size_type ddof = 1) const {
+            if (m_count <= ddof)
+                return std::numeric_limits<value_type>::quiet_NaN();
+            return m_m2 / static_cast<value_type>(m_count - ddof);
+        }
+
+        /// <summary>
+        /// standard deviation, see variance()
+        /// </summary>
+        value_type stddev(size_type ddof = 1) const {
+            return std::sqrt(variance(ddof));
+        }
+
+        /// <summary>
+        /// smallest value (+infinity without values)
+        /// </summary>
+        value_type min() const {
+            return m_min;
+        }
+
+        /// <summary>
+        /// largest value (-infinity without values)
+        /// </summary>
+        value_type max() const {
+            return m_max;
+        }
+
+    private:
+        size_type m_count;
+        value_type m_mean;
+        value_type m_m2;
+        value_type m_min;
+        value_type m_max;
+    };
+
+    /// <summary>
+    /// running statistics of the columns of a stream of rows: count, mean, variance, minimum, maximum and optionally
+    /// the covariance matrix of the columns
+    /// The number of columns is taken from the first row if it is not given to the constructor.
+    /// </summary>
+    template <class _T>
+    class column_stats {
+        static_assert(std::is_floating_point<_T>::value, "math::column_stats: the value type must be a floating point type");
+    public:
+        using value_type = _T;
+        using size_type = size_t;
+        using eigen_vector_type = Eigen::Matrix<_T, Eigen::Dynamic, 1>;
+        using eigen_matrix_type = Eigen::Matrix<_T, Eigen::Dynamic, Eigen::Dynamic>;
+
+        /// <summary>
+        /// 'cols' columns (0: taken from the first row), trackCovariance: also accumulate the covariance matrix (O(cols^2))
+        /// </summary>
+        explicit column_stats(size_type cols = 0, bool trackCovariance = false)
+            : m_covariance_enabled(trackCovariance) {
+                init(cols);
+            }
+
+        /// <summary>
+        /// add one row (a math::vector, a row of a math::matrix or an Eigen vector), e.g. alongside matrix::push_back(row)
+        /// Throws std::invalid_argument if the number of elements does not match cols().
+        /// </summary>
+        template <class _Vec>
+        void push_back(const _Vec& row) {
+            const size_type n = static_cast<size_type>(row.size());
+            prepare(n);
+            m_row.resize(n);
+            for (size_type i = 0; i < n; ++i)
+                m_row[i] = row[i];
+            push(m_row);
+        }
+
+        /// <summary>
+        /// add all rows of a matrix, the block is evaluated with Eigen and merged
+        /// </summary>
+        template <int _R, int _C, int _L>
+        void push_rows(const matrix<_T, _R, _C, _L>& mat) {
+            push_rows(mat.eigen());
+        }
+
+        /// <summary>
+        /// add all rows of an Eigen matrix, block or map
+        /// </summary>
+        template <class _Derived>
+        void push_rows(const Eigen::MatrixBase<_Derived>& rows) {
+            if (rows.rows() == 0)
+                return;
+            prepare(static_cast<size_type>(rows.cols()));
+            column_stats block(m_cols, m_covariance_enabled);
+            block.m_count = static_cast<size_type>(rows.rows());
+            block.m_mean = rows.colwise().mean().transpose();
+            const eigen_matrix_type centered = rows.rowwise() - block.m_mean.transpose();
+            block.m_m2 = centered.colwise().squaredNorm().transpose();
+            block.m_min = rows.colwise().minCoeff().transpose();
+            block.m_max = rows.colwise().maxCoeff().transpose();
+            if (m_covariance_enabled)
+                block.m_c.noalias() = centered.transpose() * centered;
+            merge(block);
+        }
+
+        /// <summary>
+        /// combine with the state of another part of the data
+        /// Throws std::invalid_argument if the number of columns or the covariance mode differ.
+        /// </summary>
+        void merge(const column_stats& other) {
+            if (other.m_count == 0)
+                return;
+            if (m_covariance_enabled && !other.m_covariance_enabled)
+                throw std::invalid_argument("math::column_stats::merge: the other state has no covariance matrix");
+            if (m_count == 0) {
+                const bool covariance = m_covariance_enabled;
+                *this = other;
+                if (!covariance) {
+                    m_covariance_enabled = false;
+                    m_c.resize(0, 0);
+                }
+                return;
+            }
+            if (other.m_cols != m_cols)
+                throw std::invalid_argument("math::column_stats::merge: the number of columns does not match");
+            const size_type n = m_count + other.m_count;
+            const eigen_vector_type delta = other.m_mean - m_mean;
+            const value_type wb = static_cast<value_type>(other.m_count) / static_cast<value_type>(n);
+            const value_type w = static_cast<value_type>(m_count) * wb;
+            m_mean += delta * wb;
+            m_m2 += other.m_m2 + delta.cwiseAbs2() * w;
+            if (m_covariance_enabled) {
+                m_c += other.m_c;
+                m_c.noalias() += w * delta * delta.transpose();
+            }
+            m_count = n;
+            m_min = m_min.cwiseMin(other.m_min);
+            m_max = m_max.cwiseMax(other.m_max);
+        }
+
+        /// <summary>
+        /// forget all rows, the number of columns is kept
+        /// </summary>
+        void clear() {
+            init(m_cols);
+        }
+
+        /// <summary>
+        /// number of rows
+        /// </summary>
+        size_type count() const {
+            return m_count;
+        }
+
+        /// <summary>
+        /// number of columns
+        /// </summary>
+        size_type cols() const {
+            return m_cols;
+        }
+
+        /// <summary>
+        /// is the covariance matrix accumulated?
+        /// </summary>
+        bool tracks_covariance() const {
+            return m_covariance_enabled;
+        }
+
+        /// <summary>
+        /// mean of each column
+        /// </summary>
+        vector<_T> mean() const {
+            return vector<_T>(m_mean);
+        }
+
+        /// <summary>
+        /// variance of each column with 'ddof' delta degrees of freedom (see running_stats::variance())
+        /// </summary>
+        vector<_T> variance(size_type ddof = 1) const {
+            if (m_count <= ddof)
+                return vector<_T>(eigen_vector_type::Constant(m_cols, std::numeric_limits<value_type>::quiet_NaN()));
+            return vector<_T>(m_m2 / static_cast<value_type>(m_count - ddof));
+        }
+
+        /// <summary>
+        /// standard deviation of each column
+        /// </summary>
+        vector<_T> stddev(size_type ddof = 1) const {
+            return vector<_T>(variance(ddof).eigen().cwiseSqrt());
+        }
+
+        /// <summary>
+        /// smallest value of each column
+        /// </summary>
+        vector<_T> min() const {
+            return vector<_T>(m_min);
+        }
+
+        /// <summary>
+        /// largest value of each column
+        /// </summary>
+        vector<_T> max() const {
+            return vector<_T>(m_max);
+        }
+
+        /// <summary>
+        /// covariance matrix of the columns with 'ddof' delta degrees of freedom
+        /// Throws std::logic_error if the covariance matrix is not tracked.
+        /// </summary>
+        matrix<_T> covariance(size_type ddof = 1) const {
+            if (!m_covariance_enabled)
+                throw std::logic_error("math::column_stats::covariance: construct with trackCovariance = true");
+            if (m_count <= ddof)
+                return matrix<_T>(eigen_matrix_type::Constant(m_cols, m_cols, std::numeric_limits<value_type>::quiet_NaN()));
+            eigen_matrix_type c = m_c.template selfadjointView<Eigen::Lower>();
+            return matrix<_T>(c / static_cast<value_type>(m_count - ddof));
+        }
+
+    private:
+        void init(size_type cols) {
+            m_count = 0;
+            m_cols = cols;
+            m_mean.setZero(cols);
+            m_m2.setZero(cols);
+            m_min.setConstant(cols, std::numeric_limits<value_type>::infinity());
+            m_max.setConstant(cols, -std::numeric_limits<value_type>::infinity());
+            if (m_covariance_enabled)
+                m_c.setZero(cols, cols);
+        }
+
+        /// <summary>
+        /// the first row defines the number of columns
+        /// </summary>
+        void prepare(size_type n) {
+            if (m_cols == 0 && m_count == 0)
+                init(n);
+            if (n != m_cols)
+                throw std::invalid_argument("math::column_stats: the number of elements does not match the number of columns");
+        }
+
+        /// <summary>
+        /// Welford update with one row
+        /// </summary>
+        template <class _Derived>
+        void push(const Eigen::MatrixBase<_Derived>& x) {
+            m_count++;
+            m_delta = x - m_mean;
+            m_mean += m_delta / static_cast<value_type>(m_count);
+            m_m2 += m_delta.cwiseProduct(x - m_mean);
+            if (m_covariance_enabled) {
+                // (x - mean_old) (x - mean_new)^T = (n - 1) / n * delta delta^T, only the lower triangle is updated
+                m_c.template selfadjointView<Eigen::Lower>().rankUpdate(m_delta, static_cast<value_type>(m_count - 1) / static_cast<value_type>(m_count));
+            }
+            m_min = m_min.cwiseMin(x);
+            m_max = m_max.cwiseMax(x);
+        }
+
+        size_type m_count;
+        size_type m_cols;
+        bool m_covariance_enabled;
+        eigen_vector_type m_mean;
+        eigen_vector_type m_m2;
+        eigen_vector_type m_min;
+        eigen_vector_type m_max;
+        // sum of the outer products of the deviations, only the lower triangle is used by push_back()
+        eigen_matrix_type m_c;
+        // scratch for push_back()
+        eigen_vector_type m_row;
+        eigen_vector_type m_delta;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,407 @@
+/*
+ *  stream.h
+ *  Created by Matthias Kesenheimer on 19.06.22.
+ *  Copyright 2022. All rights reserved.
+ *  More information about the Eigen library at http://eigen.tuxfamily.org/dox/index.html
+ */
+
+#pragma once
+#include "matrix.h"
+#include "io.h"
+#include <Eigen/Dense>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <fstream>
+#include <utility>
+
+// Streaming of row blocks for matrices which do not fit into memory:
+//     math::chunk_reader<double> reader("big.bin", 65536);   // file written by math::save or math::chunk_writer
+//     math::chunk_writer<double> writer("out.bin", reader.cols());
+//     math::matrix<double> chunk;
+//     while (reader.read(chunk)) {                            // chunk k+1 is read while chunk k is processed
+//         process(chunk);
+//         writer.submit(chunk);                               // written in the background, chunk comes back empty
+//     }
+//     writer.close();                                         // patches the number of rows into the header
+// Each reader and writer owns one background thread, which does the blocking I/O. Exactly one chunk is in flight
+// (double buffering): the caller works on chunk k while the thread reads chunk k+1 (or writes chunk k-1).
+// The buffers are swapped, not copied. If the caller hands the same matrix back on every call, the steady state
+// does not allocate.
+// Sockets and pipes can be used via any std::istream/std::ostream; such streams carry raw rows without a header.
+
+namespace math {
+    namespace detail {
+        /// <summary>
+        /// background thread which runs one job at a time
+        /// </summary>
+        class io_worker {
+        public:
+            io_worker()
+                : m_busy(false), m_stop(false), m_thread([this] { work(); }) {}
+
+            io_worker(const io_worker&) = delete;
+            io_worker& operator=(const io_worker&) = delete;
+
+            ~io_worker() {
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_stop = true;
+                }
+                m_cv.notify_all();
+                m_thread.join();
+            }
+
+            /// <summary>
+            /// wait for the previous job and start 'job' in the background
+            /// </summary>
+            void submit(std::function<void()> job) {
+                wait();
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_job = std::move(job);
+                    m_busy = true;
+                }
+                m_cv.notify_all();
+            }
+
+            /// <summary>
+            /// wait until the current job has finished
+            /// An exception thrown by the job is rethrown here (once).
+            /// </summary>
+            void wait() {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_cv.wait(lock, [this] { return !m_busy; });
+                if (m_error) {
+                    std::exception_ptr error = m_error;
+                    m_error = nullptr;
+                    std::rethrow_exception(error);
+                }
+            }
+
+        private:
+            void work() {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                for (;;) {
+                    m_cv.wait(lock, [this] { return m_busy || m_stop; });
+                    if (!m_busy)
+                        return;
+                    std::function<void()> job = std::move(m_job);
+                    lock.unlock();
+                    std::exception_ptr error;
+                    try {
+                        job();
+                    }
+                    catch (...) {
+                        error = std::current_exception();
+                    }
+                    lock.lock();
+                    m_error = error;
+                    m_busy = false;
+                    m_cv.notify_all();
+                }
+            }
+
+            std::mutex m_mutex;
+            std::condition_variable m_cv;
+            std::function<void()> m_job;
+            std::exception_ptr m_error;
+            bool m_busy;
+            bool m_stop;
+            // the thread is started last, after all other members are initialized
+            std::thread m_thread;
+        };
+    }
+
+    /// <summary>
+    /// reads a row-major matrix in blocks of 'chunkRows' rows, the next block is prefetched in the background
+    /// Sources:
+    /// - a file written by math::save (row-major matrix or vector) or by math::chunk_writer
+    /// - a std::istream positioned at such a header
+    /// - a std::istream with raw rows of 'cols' elements (a socket, a pipe), which is read until the end
+    /// Read errors are reported by read() as std::runtime_error.
+    /// </summary>
+    template <class _T>
+    class chunk_reader {
+    public:
+        typedef _T value_type;
+        typedef size_t size_type;
+        typedef matrix<_T, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> matrix_type;
+
+        /// <summary>
+        /// read the file 'path' in the binary format
+        /// </summary>
+        chunk_reader(const std::string& path, size_type chunkRows)
+            : m_file(new std::ifstream(detail::open_input(path))), m_stream(m_file.get()), m_chunk_rows(chunkRows) {
+                open_header();
+            }
+
+        /// <summary>
+        /// read a stream in the binary format, starting with the header
+        /// </summary>
+        chunk_reader(std::istream& stream, size_type chunkRows)
+            : m_stream(&stream), m_chunk_rows(chunkRows) {
+                open_header();
+            }
+
+        /// <summary>
+        /// read raw rows of 'cols' elements until the end of the stream (no header)
+        /// </summary>
+        chunk_reader(std::istream& stream, size_type cols, size_type chunkRows)
+            : m_stream(&stream), m_chunk_rows(chunkRows), m_cols(cols), m_rows_left(0), m_sized(false) {
+                start();
+            }
+
+        chunk_reader(const chunk_reader&) = delete;
+        chunk_reader& operator=(const chunk_reader&) = delete;
+
+        /// <summary>
+        /// get the next block of (at most) chunk_rows() rows, returns false (and an empty 'chunk') at the end
+        /// The block is swapped into 'chunk'. The previous contents of 'chunk' become the buffer of the next
+        /// prefetch, therefore passing the same matrix on every call avoids all allocations after the first two.
+        /// </summary>
+        bool read(matrix_type& chunk) {
+            m_worker.wait();
+            if (m_next.rows() == 0) {
+                chunk.clear();
+                return false;
+            }
+            std::swap(chunk, m_next);
+            m_rows_read += chunk.rows();
+            if (m_end)
+                m_next.clear();
+            else
+                prefetch();
+            return true;
+        }
+
+        /// <summary>
+        /// number of columns
+        /// </summary>
+        size_type cols() const {
+            return m_cols;
+        }
+
+        /// <summary>
+        /// total number of rows, only known for sources with a header (0 otherwise)
+        /// </summary>
+        size_type rows() const {
+            return m_rows;
+        }
+
+        /// <summary>
+        /// number of rows handed out by read() so far
+        /// </summary>
+        size_type rows_read() const {
+            return m_rows_read;
+        }
+
+        /// <summary>
+        /// maximum number of rows per block
+        /// </summary>
+        size_type chunk_rows() const {
+            return m_chunk_rows;
+        }
+
+    private:
+        void open_header() {
+            const file_header header = detail::read_header<_T>(*m_stream);
+            if (header.layout != static_cast<std::uint32_t>(Eigen::RowMajor) && header.rows != 1 && header.cols != 1)
+                throw std::runtime_error("math::chunk_reader: only row-major matrices can be read in row blocks");
+            m_cols = header.cols;
+            m_rows_left = header.rows;
+            m_rows = header.rows;
+            m_sized = true;
+            start();
+        }
+
+        void start() {
+            if (m_chunk_rows == 0 || m_cols == 0)
+                throw std::invalid_argument("math::chunk_reader: chunk size and number of columns must be positive");
+            m_next.reserve_rows(m_chunk_rows, m_cols);
+            prefetch();
+        }
+
+        void prefetch() {
+            m_worker.submit([this] { fill(m_next); });
+        }
+
+        /// <summary>
+        /// runs in the background thread
+        /// </summary>
+        void fill(matrix_type& chunk) {
+            const size_type rowBytes = m_cols * sizeof(_T);
+            chunk.clear();
+            if (m_sized) {
+                const size_type r = std::min<size_type>(m_chunk_rows, m_rows_left);
+                chunk.resize(r, m_cols);
+                detail::read_data(*m_stream, chunk.data(), r * m_cols);
+                m_rows_left -= r;
+                m_end = m_rows_left == 0;
+            }
+            else {
+                chunk.resize(m_chunk_rows, m_cols);
+                m_stream->read(reinterpret_cast<char*>(chunk.data()), static_cast<std::streamsize>(m_chunk_rows * rowBytes));
+                if (m_stream->bad())
+                    throw std::runtime_error("math::chunk_reader: read failed");
+                const size_type bytes = static_cast<size_type>(m_stream->gcount());
+                if (bytes % rowBytes != 0)
+                    throw std::runtime_error("math::chunk_reader: the stream ends within a row");
+                chunk.resize(bytes / rowBytes, m_cols);
+                m_end = chunk.rows() < m_chunk_rows;
+            }
+        }
+
+        std::unique_ptr<std::ifstream> m_file;
+        std::istream* m_stream;
+        size_type m_chunk_rows;
+        size_type m_cols = 0;
+        size_type m_rows_left = 0;
+        size_type m_rows = 0;
+        size_type m_rows_read = 0;
+        bool m_sized = false;
+        bool m_end = false;
+        matrix_type m_next;
+        // declared last: the background thread is stopped before the buffers and the stream are destroyed
+        detail::io_worker m_worker;
+    };
+
+    /// <summary>
+    /// writes a row-major matrix in blocks of rows, each block is written in the background
+    /// Targets:
+    /// - a file in the binary format (the number of rows in the header is written by close())
+    /// - a std::ostream which receives raw rows without a header (a socket, a pipe)
+    /// Write errors are reported by the next write(), submit() or close() as std::runtime_error.
+    /// </summary>
+    template <class _T>
+    class chunk_writer {
+    public:
+        typedef _T value_type;
+        typedef size_t size_type;
+        typedef matrix<_T, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> matrix_type;
+
+        /// <summary>
+        /// write the file 'path' in the binary format, rows of 'cols' elements
+        /// </summary>
+        chunk_writer(const std::string& path, size_type cols)
+            : m_file(new std::ofstream(detail::open_output(path))), m_stream(m_file.get()), m_cols(cols), m_header(true) {
+                detail::write_binary<_T>(*m_stream, detail::make_header<_T>(detail::file_matrix, Eigen::RowMajor, 0, m_cols), nullptr);
+            }
+
+        /// <summary>
+        /// write raw rows of 'cols' elements to 'stream' (no header)
+        /// </summary>
+        chunk_writer(std::ostream& stream, size_type cols)
+            : m_stream(&stream), m_cols(cols), m_header(false) {}
+
+        chunk_writer(const chunk_writer&) = delete;
+        chunk_writer& operator=(const chunk_writer&) = delete;
+
+        /// <summary>
+        /// closes the writer, errors are ignored (call close() to see them)
+        /// </summary>
+        ~chunk_writer() {
+            try {
+                close();
+            }
+            catch (...) {}
+        }
+
+        /// <summary>
+        /// write the rows of 'chunk' in the background, without a copy
+        /// 'chunk' is swapped with the buffer of the previous block and returned empty (with the capacity of that
+        /// buffer), ready to be filled by push_back() or resize().
+        /// </summary>
+        void submit(matrix_type& chunk) {
+            check(chunk);
+            m_worker.wait();
+            std::swap(chunk, m_pending);
+            chunk.clear();
+            flush_pending();
+        }
+
+        /// <summary>
+        /// write the rows of 'chunk' in the background, 'chunk' is copied
+        /// </summary>
+        template <int _L>
+        void write(const matrix<_T, Eigen::Dynamic, Eigen::Dynamic, _L>& chunk) {
+            check(chunk);
+            m_worker.wait();
+            m_pending.clear();
+            m_pending.resize(chunk.rows(), chunk.cols());
+            m_pending.eigen() = chunk.eigen();
+            flush_pending();
+        }
+
+        /// <summary>
+        /// wait for the background write and write the header, throws std::runtime_error if a write failed
+        /// Further writes are not possible.
+        /// </summary>
+        void close() {
+            if (m_closed)
+                return;
+            m_closed = true;
+            m_worker.wait();
+            if (m_header) {
+                m_stream->seekp(0);
+                const file_header header = detail::make_header<_T>(detail::file_matrix, Eigen::RowMajor, m_rows_written, m_cols);
+                m_stream->write(reinterpret_cast<const char*>(&header), sizeof(file_header));
+            }
+            m_stream->flush();
+            if (!*m_stream)
+                throw std::runtime_error("math::chunk_writer: write failed");
+            if (m_file)
+                m_file->close();
+        }
+
+        /// <summary>
+        /// number of columns
+        /// </summary>
+        size_type cols() const {
+            return m_cols;
+        }
+
+        /// <summary>
+        /// number of rows passed to write() or submit() so far
+        /// </summary>
+        size_type rows_written() const {
+            return m_rows_written;
+        }
+
+    private:
+        template <int _L>
+        void check(const matrix<_T, Eigen::Dynamic, Eigen::Dynamic, _L>& chunk) const {
+            if (m_closed)
+                throw std::runtime_error("math::chunk_writer: the writer is closed");
+            if (chunk.rows() > 0 && chunk.cols() != m_cols)
+                throw std::runtime_error("math::chunk_writer: the number of columns does not match");
+        }
+
+        void flush_pending() {
+            if (m_pending.rows() == 0)
+                return;
+            m_rows_written += m_pending.rows();
+            m_worker.submit([this] {
+                const size_type n = m_pending.rows() * m_cols;
+                m_stream->write(reinterpret_cast<const char*>(m_pending.data()), static_cast<std::streamsize>(n * sizeof(_T)));
+                if (!*m_stream)
+                    throw std::runtime_error("math::chunk_writer: write failed");
+            });
+        }
+
+        std::unique_ptr<std::ofstream> m_file;
+        std::ostream* m_stream;
+        size_type m_cols;
+        size_type m_rows_written = 0;
+        bool m_header;
+        bool m_closed = false;
+        matrix_type m_pending;
+        // declared last: the background thread is stopped before the buffer and the stream are destroyed
+        detail::io_worker m_worker;
+    };
+}
\ No newline at end of file
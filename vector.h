@@ -6,10 +6,18 @@
  */
 
 #pragma once
+#include "memory.h"
 #include <Eigen/Dense>
 #include <Eigen/StdVector>
 #include <initializer_list>
-#include <atomic>
+#include <algorithm>
+#include <iterator>
+#include <functional>
+
+// growth factor of the capacity if a push_back() runs out of reserved memory
+#ifndef MATH_VECTOR_GROWTH_FACTOR
+#define MATH_VECTOR_GROWTH_FACTOR 2
+#endif
 
 //#define _DEBUG
 #ifdef _DEBUG
@@ -17,145 +25,227 @@
 #endif
 
 namespace math {
+    /// <summary>
+    /// vector class
+    /// _Size = Eigen::Dynamic (default): dynamic-size vector, otherwise fixed-size vector (see below)
+    /// </summary>
+    template <class _T, int _Size = Eigen::Dynamic>
+    class vector;
+
     /// <summary>
     /// vector class
     /// Verknuepft die Daten gespeichert in m_data mit Eigen::matrix. Dadurch koennen Rechenoperationen einfacher und schneller durchgefuehrt werden.
     /// </summary>
     template <class _T>
-    class vector {
+    class vector<_T, Eigen::Dynamic> {
     public:
         /// <summary>
         /// typedefs
         /// </summary>
         using eigen_type = Eigen::Matrix<_T, Eigen::Dynamic, 1>;
         using map_type = Eigen::Map<eigen_type>;
+        using const_map_type = Eigen::Map<const eigen_type>;
         using value_type = typename eigen_type::value_type;
         using size_type = size_t;
         using reference = value_type&;
         using const_reference = const value_type&;
-        using iterator = typename eigen_type::iterator;
-        using const_iterator = typename eigen_type::const_iterator;
+        using iterator = typename map_type::iterator;
+        using const_iterator = typename const_map_type::const_iterator;
         using reverse_iterator = typename std::reverse_iterator<iterator>;
         using const_reverse_iterator = typename std::reverse_iterator<const_iterator>;
 
-        // Notiz zum Zaehlen der Referenzen:
-        // - Beim Anlegen eines Objekts muss der Referenzzaehler immer 1 sein, d.h. auch wenn der move-constructor 
-        //   vector(vector&& other) verwendet wird. Es wird ein neues Objekt erzeugt, auf die bisher nur eine Referenz zeigt.
-        //   Es spielt keine Rolle, ob das Objekt durch eine Move-Operation oder durch den Standardkonstruktor erzeugt wird.
-        //   Beim Move-Konstruktor sollen ja nur die Daten verschoben werden. Die Referenzen zum alten Objekt sollen trotzdem bestehen
-        //   bleiben.
-        // - Bei den Kopier- bzw. Move-Operatoren const vector<_T>& operator=(const vector<_T>& rhs) und vector<_T>& operator=(const vector<_T>&& rhs)
-        //   werden ausserdem auch nur die Daten kopiert bzw. verschoben. Die urspruenglichen Referenzen duerfen von dieser Aktion nicht beeinflusst werden.
-        //   Deshalb werden in diesen Faellen die Referenzzaehler nicht veraendert.
-
         /// <summary>
         /// construct a dynamic-size empty vector
         /// </summary>
         vector()
-            : m_eigen(0), m_refCount(1), m_reserved_memory_left(0) {}
+            : m_buffer(), m_reserved_memory_left(0) {}
+
+        /// <summary>
+        /// construct a dynamic-size empty vector, the memory is allocated from 'resource'
+        /// </summary>
+        explicit vector(memory_resource* resource)
+            : m_buffer(resource), m_reserved_memory_left(0) {}
 
         /// <summary>
         /// construct a dynamic-size vector with^ size 'size'
         /// </summary>
         vector(size_type s)
-            : m_eigen(eigen_type::Zero(s, 1)), m_refCount(1), m_reserved_memory_left(0) {}
+            : m_buffer(s), m_reserved_memory_left(0) {
+                eigen().setZero();
+            }
+
+        /// <summary>
+        /// construct a dynamic-size vector with size 'size', the memory is allocated from 'resource'
+        /// </summary>
+        vector(size_type s, memory_resource* resource)
+            : m_buffer(s, resource), m_reserved_memory_left(0) {
+                eigen().setZero();
+            }
+
+        /// <summary>
+        /// construct a dynamic-size vector with size 'size', the elements are not initialized (no zero pass)
+        /// For outputs which are overwritten anyway. eigen::fill(execution::par, ...) in parallel.h touches the
+        /// memory first from the threads of the pool.
+        /// </summary>
+        vector(size_type s, uninitialized_t, memory_resource* resource = default_resource())
+            : m_buffer(s, resource), m_reserved_memory_left(0) {}
 
         /// <summary>
         /// construct an object from an std::vector
         /// </summary>
         vector(const std::vector<_T>& v)
-            : m_eigen(v.size()), m_refCount(1), m_reserved_memory_left(0) {
-                for (size_type i = 0; i < v.size(); ++i)
-                    m_eigen[i] = v[i];
+            : m_buffer(v.size()), m_reserved_memory_left(0) {
+                eigen() = const_map_type(v.data(), v.size());
             }
 
         /// <summary>
         /// construct from plain array
         /// </summary>
         vector(const value_type* v, size_type s)
-            : m_eigen(s), m_refCount(1), m_reserved_memory_left(0) {
-                for (size_type i = 0; i < s; ++i)
-                    m_eigen[i] = v[i];
+            : m_buffer(s), m_reserved_memory_left(0) {
+                eigen() = const_map_type(v, s);
             }
 
         /// <summary>
         /// construct a dynamic-size vector with size 'size' and default value 'defaultValue'
         /// </summary>
         vector(size_type s, const value_type& defaultValue)
-            : m_eigen(eigen_type::Constant(s, 1, defaultValue)), m_refCount(1), m_reserved_memory_left(0) {}
+            : m_buffer(s), m_reserved_memory_left(0) {
+                eigen().setConstant(defaultValue);
+            }
 
         /// <summary>
         /// initializing by initializer list
         /// </summary>
         vector(std::initializer_list<value_type> l)
-            : m_eigen(l.size()), m_refCount(1), m_reserved_memory_left(0) {
-                for (size_type i = 0; i < l.size(); ++i)
-                    m_eigen[i] = *(l.begin() + i);
+            : m_buffer(l.size()), m_reserved_memory_left(0) {
+                eigen() = const_map_type(l.begin(), l.size());
             }
 
         /// <summary>
         /// construct from Eigen::matrix
         /// </summary>
         vector(const eigen_type& eigvec)
-            :  m_eigen(eigvec), m_refCount(1), m_reserved_memory_left(0) {}
-
-        /// <summary>
-        /// construct from Eigen::matrix
-        /// </summary>
-        vector(eigen_type&& eigvec) noexcept
-            :  m_eigen(std::move(eigvec)), m_refCount(1), m_reserved_memory_left(0) {}
+            :  m_buffer(eigvec.size()), m_reserved_memory_left(0) {
+                eigen() = eigvec;
+            }
 
         /// <summary>
         /// copy constructor
+        /// If copy-on-write is enabled for 'other', the copy shares its memory until one of them is modified.
         /// </summary>
         vector(const vector& other)
-            : m_eigen(other.m_eigen), m_refCount(1), m_reserved_memory_left(0) {}
+            : m_buffer(other.copy_on_write() ? other.m_buffer.share() : buffer<_T>(other.size())),
+              m_reserved_memory_left(other.copy_on_write() ? other.m_reserved_memory_left : 0) {
+                if (!other.copy_on_write()) {
+                    MATH_INSTRUMENT_EVENT(_T, copy, other.size() * sizeof(_T));
+                    eigen() = other.eigen();
+                }
+            }
 
         /// <summary>
         /// move constructor
         /// </summary>
         vector(vector&& other) noexcept
-            : m_eigen(std::move(other.m_eigen)), m_refCount(1), m_reserved_memory_left(0) {}
+            : m_buffer(std::move(other.m_buffer)), m_reserved_memory_left(other.m_reserved_memory_left) {
+                other.m_reserved_memory_left = 0;
+            }
 
         /// <summary>
         /// construct from map
         /// </summary>
         vector(const map_type& map)
-            : m_eigen(map), m_refCount(1), m_reserved_memory_left(0) {}
+            : m_buffer(map.size()), m_reserved_memory_left(0) {
+                eigen() = map;
+            }
+
+        /// <summary>
+        /// construct from an Eigen expression, the expression is evaluated in a single pass
+        /// </summary>
+        template <class _Derived>
+        vector(const Eigen::MatrixBase<_Derived>& expr)
+            : m_buffer(expr.size()), m_reserved_memory_left(0) {
+                eigen() = expr;
+            }
 
         /// <summary>
         /// size of the data container
         /// </summary>
         const size_type size() const {
-            return m_eigen.rows() - m_reserved_memory_left;
+            return capacity() - m_reserved_memory_left;
         }
-        
+
+        /// <summary>
+        /// number of elements that fit into the allocated memory
+        /// </summary>
+        size_type capacity() const {
+            return m_buffer.capacity();
+        }
+
+        /// <summary>
+        /// memory resource the vector allocates from
+        /// </summary>
+        memory_resource* resource() const {
+            return m_buffer.resource();
+        }
+
+        /// <summary>
+        /// is copy-on-write enabled?
+        /// </summary>
+        bool copy_on_write() const {
+            return m_buffer.copy_on_write();
+        }
+
+        /// <summary>
+        /// enable or disable copy-on-write
+        /// With copy-on-write enabled, copies of the vector share the memory with the vector (and inherit
+        /// the mode). The memory is copied only when one of them is modified, i.e. by any non-const access
+        /// (operator[], at(), data(), eigen(), iterators, ...).
+        /// Note: pointers, maps and views obtained from a const vector may refer to shared memory.
+        /// </summary>
+        void set_copy_on_write(bool enable) {
+            if (!enable)
+                m_buffer.detach(size());
+            m_buffer.set_copy_on_write(enable);
+        }
+
+        /// <summary>
+        /// does the vector share its memory with a copy?
+        /// </summary>
+        bool shared() const {
+            return m_buffer.shared();
+        }
+
         /// <summary>
         /// returns the underlying data structure
+        /// Note: memory shared with a copy (copy-on-write) is copied first.
         /// </summary>
         value_type* data() {
-            return m_eigen.data();
+            m_buffer.detach(size());
+            return m_buffer.data();
         }
 
         /// <summary>
         /// returns the underlying data structure
         /// </summary>
         const value_type* data() const {
-            return m_eigen.data();
+            return m_buffer.data();
         }
 
         /// <summary>
         /// returns the underlying data structure
+        /// Note: the returned map covers only the size() elements, not the reserved memory.
         /// </summary>
-        eigen_type& eigen() {
-            return m_eigen;
+        map_type eigen() {
+            return map_type(data(), size());
         }
 
         /// <summary>
         /// returns the underlying data structure
+        /// Note: the returned map covers only the size() elements, not the reserved memory.
         /// </summary>
-        const eigen_type& eigen() const {
-            return m_eigen;
+        const_map_type eigen() const {
+            return const_map_type(data(), size());
         }
 
         /// <summary>
@@ -163,7 +253,7 @@ namespace math {
         /// returns a const iterator
         /// </summary>
         const_iterator begin() const {
-            return m_eigen.begin();
+            return eigen().cbegin();
         }
 
         /// <summary>
@@ -171,7 +261,7 @@ namespace math {
         /// returns an iterator
         /// </summary>
         iterator begin() {
-            return m_eigen.begin();
+            return eigen().begin();
         }
 
         /// <summary>
@@ -179,7 +269,7 @@ namespace math {
         /// returns a const iterator
         /// </summary>
         const_iterator end() const {
-            return m_eigen.end();
+            return eigen().cend();
         }
 
         /// <summary>
@@ -187,7 +277,7 @@ namespace math {
         /// returns an iterator
         /// </summary>
         iterator end() {
-            return m_eigen.end();
+            return eigen().end();
         }
 
         /// <summary>
@@ -195,7 +285,7 @@ namespace math {
         /// returns a const iterator
         /// </summary>
         const_reverse_iterator rbegin() const {
-            return std::reverse_iterator(m_eigen.end());
+            return std::reverse_iterator(end());
         }
 
         /// <summary>
@@ -203,7 +293,7 @@ namespace math {
         /// returns an iterator
         /// </summary>
         reverse_iterator rbegin() {
-            return std::reverse_iterator(m_eigen.end());
+            return std::reverse_iterator(end());
         }
 
         /// <summary>
@@ -211,7 +301,7 @@ namespace math {
         /// returns a const iterator
         /// </summary>
         const_reverse_iterator rend() const {
-            return std::reverse_iterator(m_eigen.begin());
+            return std::reverse_iterator(begin());
         }
 
         /// <summary>
@@ -219,7 +309,7 @@ namespace math {
         /// returns an iterator
         /// </summary>
         reverse_iterator rend() {
-            return std::reverse_iterator(m_eigen.begin());
+            return std::reverse_iterator(begin());
         }
 
         /// <summary>
@@ -233,178 +323,286 @@ namespace math {
         /// add new value
         /// </summary>
         void push_back(const value_type& value) {
-            if (m_reserved_memory_left > 0) {
-                m_eigen[size()] = value;
-                m_reserved_memory_left--;
-                return;
+            if (m_reserved_memory_left == 0) {
+                // value may refer to an element of this vector, copy it before the memory is reallocated
+                value_type copy(value);
+                grow(size() + 1);
+                data()[size()] = std::move(copy);
             }
-            m_eigen.conservativeResize(m_eigen.rows() + 1, 1);
-            m_eigen[m_eigen.rows() - 1] = value;
+            else
+                data()[size()] = value;
+            m_reserved_memory_left--;
         }
 
         /// <summary>
         /// add new value
         /// </summary>
         void push_back(value_type&& value) noexcept {
-            if (m_reserved_memory_left > 0) {
-                m_eigen[size()] = value;
-                m_reserved_memory_left--;
-                return;
+            if (m_reserved_memory_left == 0) {
+                // value may refer to an element of this vector
+                value_type moved(std::move(value));
+                grow(size() + 1);
+                data()[size()] = std::move(moved);
             }
-            m_eigen.conservativeResize(m_eigen.rows() + 1, 1);
-            m_eigen[m_eigen.rows() - 1] = std::move(value);
+            else
+                data()[size()] = std::move(value);
+            m_reserved_memory_left--;
         }
 
         /// <summary>
         /// reserve memory (does not change size, but subsequent push_back()'s are more efficient)
-        /// Attention: Using a reserved vector that was not fully filled by
-        /// push_back()'s may cause errors in subsequent operations.
-        /// Always completely fill the vectors before using them!
         /// </summary>
         void reserve(size_type sz) {
-            if (sz > m_eigen.rows()) {
+            if (sz > capacity()) {
+                size_type s = size();
+                m_buffer.reallocate(sz, s);
                 // this amount of memory is additionally reserved:
-                m_reserved_memory_left = sz - m_eigen.rows();
-                m_eigen.conservativeResize(sz);
+                m_reserved_memory_left = sz - s;
+            }
+        }
+
+        /// <summary>
+        /// release the reserved memory that is not used
+        /// </summary>
+        void shrink_to_fit() {
+            if (m_reserved_memory_left > 0) {
+                m_buffer.reallocate(size(), size());
+                m_reserved_memory_left = 0;
             }
         }
 
-        /// TODO: make use of m_reserved_memory_left
         /// <summary>
         /// append a vector
         /// </summary>
         void append(const vector<value_type>& toAppend) {
-            size_type old = m_eigen.rows();
-            m_eigen.conservativeResize(m_eigen.rows() + toAppend.size(), 1);
-            for (int i = 0; i < toAppend.size(); ++i)
-                m_eigen[old + i] = toAppend[i];
+            append(toAppend.data(), toAppend.size());
         }
 
-        /// TODO: make use of m_reserved_memory_left
         /// <summary>
         /// append a vector
         /// </summary>
         void append(vector<value_type>&& toAppend) noexcept {
-            size_type old = m_eigen.rows();
-            m_eigen.conservativeResize(m_eigen.rows() + toAppend.size(), 1);
-            for (int i = 0; i < toAppend.size(); ++i)
-                m_eigen[old + i] = std::move(toAppend[i]);
+            // nothing to keep: take over the memory of toAppend
+            if (capacity() == 0) {
+                *this = std::move(toAppend);
+                return;
+            }
+            append(toAppend.data(), toAppend.size());
+        }
+
+        /// <summary>
+        /// append 'n' values from a plain array
+        /// </summary>
+        void append(const value_type* v, size_type n) {
+            if (n == 0)
+                return;
+            size_type s = size();
+            if (n > m_reserved_memory_left) {
+                if (capacity() > 0)
+                    MATH_INSTRUMENT_EVENT(_T, reallocation, s * sizeof(_T));
+                buffer<_T> b(next_capacity(s + n), resource(), copy_on_write());
+                // copy the new values first, v may point into this vector
+                map_type(b.data() + s, n) = const_map_type(v, n);
+                m_buffer.move_to(0, s, b.data());
+                m_buffer.swap(b);
+                m_reserved_memory_left = capacity() - s - n;
+                return;
+            }
+            map_type(data() + s, n) = const_map_type(v, n);
+            m_reserved_memory_left -= n;
+        }
+
+        /// <summary>
+        /// insert the values of the range [first, last) before pos
+        /// returns an iterator to the first inserted element
+        /// Note: first and last must not be iterators into this vector.
+        /// </summary>
+        template <class _ForwardIt>
+        iterator insert(iterator pos, _ForwardIt first, _ForwardIt last) {
+            size_type index = std::distance(begin(), pos);
+            size_type n = std::distance(first, last);
+            if (n == 0)
+                return begin() + index;
+            if (n > m_reserved_memory_left)
+                grow(size() + n);
+
+            // shift the tail in one block, then copy the range into the gap
+            size_type old = size();
+            std::move_backward(data() + index, data() + old, data() + old + n);
+            std::copy(first, last, data() + index);
+            m_reserved_memory_left -= n;
+            return begin() + index;
         }
 
         /// <summary>
         /// delete entries, leaving the container with a size of 0.
+        /// The capacity is kept, use shrink_to_fit() to release the memory.
         /// </summary>
         void clear() {
-            //m_eigen.resize(0, 0);
-            m_eigen = eigen_type(0);
+            m_reserved_memory_left = capacity();
         }
 
         /// <summary>
         /// clear without changing size
         /// </summary>
         void reset() {
-            m_eigen = eigen_type::Zero(m_eigen.rows(), 1);
+            eigen().setZero();
         }
 
         /// <summary>
         /// assign a new size and new values to the vector
         /// </summary>
         void assign(size_type size, const value_type& defaultValue) {
-            m_eigen = eigen_type(size);
-            for (size_type i = 0; i < size; ++i)
-                    m_eigen[i] = defaultValue;
+            if (size > capacity() || shared())
+                m_buffer = buffer<_T>(size, resource(), copy_on_write());
+            m_reserved_memory_left = capacity() - size;
+            eigen().setConstant(defaultValue);
         }
 
         /// <summary>
         /// resize the vector
         /// </summary>
         void resize(size_type newSize) {
-            m_eigen.conservativeResize(newSize, 1);
+            if (newSize > capacity())
+                m_buffer.reallocate(newSize, size());
+            m_reserved_memory_left = capacity() - newSize;
         }
 
         /// <summary>
-        /// erase with iterator
+        /// resize without conserving the values: if the capacity is exceeded, new memory is allocated and
+        /// nothing is copied, all values are undefined afterwards
         /// </summary>
-        void erase(iterator it) {
-            size_type numRows = size() - 1;
-            size_type numCols = 1;
+        void resize_uninitialized(size_type newSize) {
+            if (newSize > capacity() || shared())
+                m_buffer = buffer<_T>(newSize, resource(), copy_on_write());
+            m_reserved_memory_left = capacity() - newSize;
+        }
 
-            size_type rowToRemove = std::distance(begin(), it);
-            if (rowToRemove < numRows)
-                m_eigen.block(rowToRemove, 0, numRows - rowToRemove, numCols) = m_eigen.block(rowToRemove + 1, 0, numRows - rowToRemove, numCols);
+        /// <summary>
+        /// remove the last element, the capacity is kept
+        /// </summary>
+        void pop_back() {
+            eigen_assert(!empty());
+            m_reserved_memory_left++;
+        }
 
-            m_eigen.conservativeResize(numRows, numCols);
+        /// <summary>
+        /// erase with iterator, the tail is shifted by one and the capacity is kept
+        /// returns an iterator to the element after the erased one
+        /// </summary>
+        iterator erase(iterator it) {
+            return erase(it, it + 1);
         }
 
         /// <summary>
-        /// erase elements in iterator range
+        /// erase elements in iterator range, the tail is shifted in one block and the capacity is kept
+        /// returns an iterator to the element after the erased ones
         /// </summary>
-        void erase(iterator it1, iterator it2) {
-            size_type numberToRemove = std::distance(it1, it2);
-            size_type numRows = size() - numberToRemove;
-            size_type numCols = 1;
+        iterator erase(iterator it1, iterator it2) {
+            size_type first = std::distance(begin(), it1);
+            size_type last = std::distance(begin(), it2);
+            size_type old = size();
+            if (first == last)
+                return begin() + first;
 
-            size_type rowToRemove = std::distance(begin(), it1);
-            if (rowToRemove < numRows)
-                m_eigen.block(rowToRemove, 0, numRows - rowToRemove, numCols) = m_eigen.block(rowToRemove + numberToRemove, 0, numRows - rowToRemove, numCols);
+            std::move(data() + last, data() + old, data() + first);
+            m_reserved_memory_left += last - first;
+            return begin() + first;
+        }
+
+        /// <summary>
+        /// erase in O(1) by moving the last element into the gap, the order of the elements is not kept
+        /// returns an iterator to the element moved into the gap (end() if the last element was erased)
+        /// </summary>
+        iterator swap_erase(iterator it) {
+            size_type index = std::distance(begin(), it);
+            size_type last = size() - 1;
+            if (index != last)
+                data()[index] = std::move(data()[last]);
+            m_reserved_memory_left++;
+            return begin() + index;
+        }
 
-            m_eigen.conservativeResize(numRows, numCols);
+        /// <summary>
+        /// erase all elements for which pred(value) is true in a single pass, the order of the other elements and
+        /// the capacity are kept
+        /// returns the number of erased elements
+        /// </summary>
+        template <class _Pred>
+        size_type erase_if(_Pred pred) {
+            value_type* first = data();
+            value_type* last = first + size();
+            value_type* kept = std::remove_if(first, last, pred);
+            size_type n = static_cast<size_type>(last - kept);
+            m_reserved_memory_left += n;
+            return n;
         }
         
         /// <summary>
         /// accessing elements
         /// </summary>
         const_reference operator[] (size_type const i) const {
-            return m_eigen[i];
+            return data()[i];
         }
 
         /// <summary>
         /// accessing elements
         /// </summary>
         reference operator[] (size_type const i) {
-            return m_eigen[i];
+            return data()[i];
         }
 
         /// <summary>
         /// accessing elements
         /// </summary>
         reference at(const size_type i) {
-            return m_eigen(i);
+            return eigen()(i);
         }
 
         /// <summary>
         /// accessing elements
         /// </summary>
         const_reference at(const size_type i) const {
-            return m_eigen(i);
+            eigen_assert(i < size());
+            return data()[i];
         }
 
         /// <summary>
         /// first element
         /// </summary>
         const_reference front() const {
-            return m_eigen(0);
+            eigen_assert(!empty());
+            return data()[0];
         }
 
         /// <summary>
         /// first element
         /// </summary>
         reference front() {
-            return m_eigen(0);
+            return eigen()(0);
         }
 
         /// <summary>
         /// last element
         /// </summary>
         const_reference back() const {
-            return m_eigen(size() - 1);
+            eigen_assert(!empty());
+            return data()[size() - 1];
         }
 
         /// <summary>
         /// last element
         /// </summary>
         reference back() {
-            return m_eigen(size() - 1);
+            return eigen()(size() - 1);
+        }
+
+        /// <summary>
+        /// copy with the elements converted to _U in a single (vectorized) pass, e.g. vec.cast<float>()
+        /// </summary>
+        template <class _U>
+        vector<_U> cast() const {
+            return vector<_U>(eigen().template cast<_U>());
         }
 
         /// <summary>
@@ -412,7 +610,13 @@ namespace math {
         /// </summary>
         const vector<_T>& operator=(const vector<_T>& rhs) {
             if (this != &rhs) {
-                m_eigen = rhs.m_eigen;
+                if (rhs.copy_on_write()) {
+                    m_buffer = rhs.m_buffer.share();
+                    m_reserved_memory_left = rhs.m_reserved_memory_left;
+                    return *this;
+                }
+                MATH_INSTRUMENT_EVENT(_T, copy, rhs.size() * sizeof(_T));
+                evaluate(rhs.eigen());
             }
             return *this;
         }
@@ -420,9 +624,12 @@ namespace math {
         /// <summary>
         /// assignment operator
         /// </summary>
-        vector<_T>& operator=(vector<_T>&& rhs) noexcept {
+        vector<_T>& operator=(vector<_T>&& rhs) {
             if (this != &rhs) {
-                m_eigen = std::move(rhs.m_eigen);
+                m_buffer = std::move(rhs.m_buffer);
+                m_reserved_memory_left = rhs.m_reserved_memory_left;
+                rhs.m_buffer = buffer<_T>(rhs.resource());
+                rhs.m_reserved_memory_left = 0;
             }
             return *this;
         }
@@ -431,44 +638,325 @@ namespace math {
         /// assignment operator
         /// </summary>
         const vector<_T>& operator=(const eigen_type& rhs) {
-            m_eigen = rhs;
+            evaluate(rhs);
             return *this;
         }
 
         /// <summary>
         /// assignment operator
         /// </summary>
-        vector<_T>& operator=(eigen_type&& rhs) noexcept {
-            m_eigen = std::move(rhs);
+        vector<_T>& operator=(const map_type& map) {
+            evaluate(map);
             return *this;
         }
 
         /// <summary>
         /// assignment operator
+        /// evaluates an Eigen expression directly into the memory of the vector
         /// </summary>
-        vector<_T>& operator=(const map_type& map) {
-            m_eigen = eigen_type(map);
+        template <class _Derived>
+        vector<_T>& operator=(const Eigen::MatrixBase<_Derived>& expr) {
+            evaluate(expr);
             return *this;
         }
 
+        private:
+            /// <summary>
+            /// increase the capacity geometrically, such that at least 'required' elements fit
+            /// </summary>
+            void grow(size_type required) {
+                reserve(next_capacity(required));
+            }
+
+            /// <summary>
+            /// evaluate an Eigen expression into the memory of the vector, reallocate if it does not fit
+            /// </summary>
+            template <class _Derived>
+            void evaluate(const Eigen::MatrixBase<_Derived>& expr) {
+                size_type n = expr.size();
+                if (n > capacity() || shared()) {
+                    // evaluate into new memory first, expr may refer to this vector
+                    buffer<_T> b(n, resource(), copy_on_write());
+                    map_type(b.data(), n) = expr;
+                    m_buffer.swap(b);
+                    m_reserved_memory_left = 0;
+                    return;
+                }
+                m_reserved_memory_left = capacity() - n;
+                eigen() = expr;
+            }
+
+            /// <summary>
+            /// capacity after growing geometrically, such that at least 'required' elements fit
+            /// </summary>
+            size_type next_capacity(size_type required) const {
+                size_type newCapacity = static_cast<size_type>(capacity() * MATH_VECTOR_GROWTH_FACTOR);
+                return std::max<size_type>(std::max<size_type>(newCapacity, required), 4);
+            }
+
+            buffer<_T> m_buffer;
+            size_type m_reserved_memory_left;
+    };
+
+    /// <summary>
+    /// fixed-size vector class
+    /// Same interface as the dynamic-size vector, but the size is known at compile time.
+    /// The data is stored in place without heap allocation and Eigen unrolls and vectorizes the operations.
+    /// </summary>
+    template <class _T, int _Size>
+    class vector {
+        static_assert(_Size > 0, "math::vector: the size must be positive or Eigen::Dynamic");
+    public:
+        /// <summary>
+        /// typedefs
+        /// </summary>
+        using eigen_type = Eigen::Matrix<_T, _Size, 1>;
+        using map_type = Eigen::Map<eigen_type>;
+        using const_map_type = Eigen::Map<const eigen_type>;
+        using value_type = typename eigen_type::value_type;
+        using size_type = size_t;
+        using reference = value_type&;
+        using const_reference = const value_type&;
+        using iterator = typename eigen_type::iterator;
+        using const_iterator = typename eigen_type::const_iterator;
+        using reverse_iterator = typename std::reverse_iterator<iterator>;
+        using const_reverse_iterator = typename std::reverse_iterator<const_iterator>;
+
+        /// <summary>
+        /// construct a fixed-size vector filled with zeros
+        /// </summary>
+        vector()
+            : m_eigen(eigen_type::Zero()) {}
+
         /// <summary>
-        /// add reference
+        /// construct without initializing the elements
         /// </summary>
-        void addRef() {
-            ++m_refCount;
+        explicit vector(uninitialized_t) {}
+
+        /// <summary>
+        /// construct from plain array with at least _Size elements
+        /// </summary>
+        explicit vector(const value_type* v)
+            : m_eigen(const_map_type(v)) {}
+
+        /// <summary>
+        /// initializing by initializer list
+        /// </summary>
+        vector(std::initializer_list<value_type> l) {
+            eigen_assert(l.size() == _Size && "math::vector: size of the initializer list does not match");
+            std::copy(l.begin(), l.end(), m_eigen.data());
         }
 
         /// <summary>
-        /// remove reference
+        /// construct from Eigen::matrix
+        /// </summary>
+        vector(const eigen_type& eigvec)
+            : m_eigen(eigvec) {}
+
+        /// <summary>
+        /// construct from an Eigen expression, the expression is evaluated in a single pass
+        /// </summary>
+        template <class _Derived>
+        vector(const Eigen::MatrixBase<_Derived>& expr)
+            : m_eigen(expr) {}
+
+        /// <summary>
+        /// size of the data container
         /// </summary>
-        void release() {
-            if (!--m_refCount)
-                delete this;
+        static constexpr size_type size() {
+            return _Size;
         }
 
+        /// <summary>
+        /// is the vector empty?
+        /// </summary>
+        static constexpr bool empty() {
+            return false;
+        }
+
+        /// <summary>
+        /// returns the underlying data structure
+        /// </summary>
+        value_type* data() {
+            return m_eigen.data();
+        }
+
+        /// <summary>
+        /// returns the underlying data structure
+        /// </summary>
+        const value_type* data() const {
+            return m_eigen.data();
+        }
+
+        /// <summary>
+        /// returns the underlying data structure
+        /// </summary>
+        eigen_type& eigen() {
+            return m_eigen;
+        }
+
+        /// <summary>
+        /// returns the underlying data structure
+        /// </summary>
+        const eigen_type& eigen() const {
+            return m_eigen;
+        }
+
+        /// <summary>
+        /// begin of data container
+        /// returns a const iterator
+        /// </summary>
+        const_iterator begin() const {
+            return m_eigen.begin();
+        }
+
+        /// <summary>
+        /// begin of data container
+        /// returns an iterator
+        /// </summary>
+        iterator begin() {
+            return m_eigen.begin();
+        }
+
+        /// <summary>
+        /// end of data container
+        /// returns a const iterator
+        /// </summary>
+        const_iterator end() const {
+            return m_eigen.end();
+        }
+
+        /// <summary>
+        /// end of data container
+        /// returns an iterator
+        /// </summary>
+        iterator end() {
+            return m_eigen.end();
+        }
+
+        /// <summary>
+        /// rbegin of data container
+        /// returns a const iterator
+        /// </summary>
+        const_reverse_iterator rbegin() const {
+            return std::reverse_iterator(end());
+        }
+
+        /// <summary>
+        /// rbegin of data container
+        /// returns an iterator
+        /// </summary>
+        reverse_iterator rbegin() {
+            return std::reverse_iterator(end());
+        }
+
+        /// <summary>
+        /// rend of data container
+        /// returns a const iterator
+        /// </summary>
+        const_reverse_iterator rend() const {
+            return std::reverse_iterator(begin());
+        }
+
+        /// <summary>
+        /// rend of data container
+        /// returns an iterator
+        /// </summary>
+        reverse_iterator rend() {
+            return std::reverse_iterator(begin());
+        }
+
+        /// <summary>
+        /// clear without changing size
+        /// </summary>
+        void reset() {
+            m_eigen.setZero();
+        }
+
+        /// <summary>
+        /// assign a new value to all elements
+        /// </summary>
+        void fill(const value_type& value) {
+            m_eigen.setConstant(value);
+        }
+
+        /// <summary>
+        /// accessing elements
+        /// </summary>
+        const_reference operator[] (size_type const i) const {
+            return m_eigen[i];
+        }
+
+        /// <summary>
+        /// accessing elements
+        /// </summary>
+        reference operator[] (size_type const i) {
+            return m_eigen[i];
+        }
+
+        /// <summary>
+        /// accessing elements
+        /// </summary>
+        reference at(const size_type i) {
+            return m_eigen(i);
+        }
+
+        /// <summary>
+        /// accessing elements
+        /// </summary>
+        const_reference at(const size_type i) const {
+            return m_eigen(i);
+        }
+
+        /// <summary>
+        /// first element
+        /// </summary>
+        const_reference front() const {
+            return m_eigen(0);
+        }
+
+        /// <summary>
+        /// first element
+        /// </summary>
+        reference front() {
+            return m_eigen(0);
+        }
+
+        /// <summary>
+        /// last element
+        /// </summary>
+        const_reference back() const {
+            return m_eigen(_Size - 1);
+        }
+
+        /// <summary>
+        /// last element
+        /// </summary>
+        reference back() {
+            return m_eigen(_Size - 1);
+        }
+
+        /// <summary>
+        /// copy with the elements converted to _U, e.g. vec.cast<float>()
+        /// </summary>
+        template <class _U>
+        vector<_U, _Size> cast() const {
+            return vector<_U, _Size>(m_eigen.template cast<_U>());
+        }
+
+        /// <summary>
+        /// assignment operator
+        /// evaluates an Eigen expression directly into the memory of the vector
+        /// </summary>
+        template <class _Derived>
+        vector<_T, _Size>& operator=(const Eigen::MatrixBase<_Derived>& expr) {
+            m_eigen = expr;
+            return *this;
+        }
+
+        EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
         private:
             eigen_type m_eigen;
-            std::atomic<int> m_refCount;
-            size_type m_reserved_memory_left;
     };
 }
\ No newline at end of file
@@ -0,0 +1,539 @@
+/*
+ *  vector_array.h
+ *  Created by Matthias Kesenheimer on 19.06.22.
+ *  Copyright 2022. All rights reserved.
+ *  More information about the Eigen library at http://eigen.tuxfamily.org/dox/index.html
+ */
+
+#pragma once
+#include "vector.h"
+#include "matrix.h"
+#include "operators.h"
+#include <Eigen/Dense>
+#include <initializer_list>
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+//#define _DEBUG
+#ifdef _DEBUG
+#include <iostream>
+#endif
+
+// Collection of small fixed-size vectors stored as a structure of arrays (one contiguous array per component):
+//     math::vector_array<double, 3> points;
+//     points.push_back(math::vector<double, 3>{1, 2, 3});
+//     points[i].x() = 4;                                   // element proxy (an Eigen::Map with a stride)
+//     math::vector<double, 3> p = points[i];               // copy of one element
+//     points.component(2).array() += 1.0;                   // all z components at once
+//     math::vector<double> lengths = math::eigen::norm(points);
+//     math::eigen::transform(points, pose);                // pose: 3x3 (linear), 3x4 or 4x4 (affine) math::matrix
+//     math::eigen::normalize(points);
+// The bulk operations of math::eigen work on all elements with vectorized loops over the components. Large arrays
+// are processed in blocks of MATH_ARRAY_BLOCK_SIZE elements, such that the intermediate results stay in the cache.
+
+// number of elements per block of the bulk operations
+#ifndef MATH_ARRAY_BLOCK_SIZE
+#define MATH_ARRAY_BLOCK_SIZE 256
+#endif
+
+namespace math {
+    /// <summary>
+    /// array of vectors with _Dim components of type _T, stored component by component
+    /// </summary>
+    template <class _T, int _Dim>
+    class vector_array {
+        static_assert(_Dim > 0, "math::vector_array: the number of components must be positive");
+    public:
+        /// <summary>
+        /// typedefs
+        /// </summary>
+        using value_type = _T;
+        using size_type = size_t;
+        using element_type = vector<_T, _Dim>;
+        using reference = Eigen::Map<Eigen::Matrix<_T, _Dim, 1>, 0, Eigen::InnerStride<>>;
+        using const_reference = Eigen::Map<const Eigen::Matrix<_T, _Dim, 1>, 0, Eigen::InnerStride<>>;
+        using component_type = Eigen::Map<Eigen::Matrix<_T, Eigen::Dynamic, 1>>;
+        using const_component_type = Eigen::Map<const Eigen::Matrix<_T, Eigen::Dynamic, 1>>;
+        using components_type = Eigen::Map<Eigen::Matrix<_T, _Dim, Eigen::Dynamic, Eigen::RowMajor>, 0, Eigen::OuterStride<>>;
+        using const_components_type = Eigen::Map<const Eigen::Matrix<_T, _Dim, Eigen::Dynamic, Eigen::RowMajor>, 0, Eigen::OuterStride<>>;
+
+        /// <summary>
+        /// number of components of an element
+        /// </summary>
+        static constexpr int dims = _Dim;
+
+        /// <summary>
+        /// construct an empty array
+        /// </summary>
+        vector_array()
+            : m_buffer(), m_size(0), m_stride(0) {}
+
+        /// <summary>
+        /// construct an empty array, the memory is allocated from 'resource'
+        /// </summary>
+        explicit vector_array(memory_resource* resource)
+            : m_buffer(resource), m_size(0), m_stride(0) {}
+
+        /// <summary>
+        /// construct an array of 'n' zero vectors
+        /// </summary>
+        explicit vector_array(size_type n, memory_resource* resource = default_resource())
+            : m_buffer(stride_for(n) * _Dim, resource), m_size(n), m_stride(stride_for(n)) {
+                std::fill_n(m_buffer.data(), m_buffer.capacity(), _T(0));
+            }
+
+        /// <summary>
+        /// construct an array of 'n' vectors without initializing the components
+        /// </summary>
+        vector_array(size_type n, uninitialized_t, memory_resource* resource = default_resource())
+            : m_buffer(stride_for(n) * _Dim, resource), m_size(n), m_stride(stride_for(n)) {}
+
+        /// <summary>
+        /// construct from nested vectors, every inner vector has _Dim elements
+        /// </summary>
+        explicit vector_array(const vector<vector<_T>>& points)
+            : m_buffer(), m_size(0), m_stride(0) {
+                assign_points(points);
+            }
+
+        /// <summary>
+        /// construct from a std::vector of fixed-size vectors
+        /// </summary>
+        explicit vector_array(const std::vector<element_type>& points)
+            : m_buffer(), m_size(0), m_stride(0) {
+                assign_points(points);
+            }
+
+        /// <summary>
+        /// initializing by initializer list
+        /// </summary>
+        vector_array(std::initializer_list<element_type> points)
+            : m_buffer(), m_size(0), m_stride(0) {
+                assign_points(points);
+            }
+
+        /// <summary>
+        /// copy constructor
+        /// </summary>
+        vector_array(const vector_array& other)
+            : m_buffer(stride_for(other.m_size) * _Dim, other.resource()), m_size(other.m_size), m_stride(stride_for(other.m_size)) {
+                MATH_INSTRUMENT_EVENT(_T, copy, m_size * _Dim * sizeof(_T));
+                copy_components(other);
+            }
+
+        /// <summary>
+        /// move constructor
+        /// </summary>
+        vector_array(vector_array&& other) noexcept
+            : m_buffer(std::move(other.m_buffer)), m_size(other.m_size), m_stride(other.m_stride) {
+                other.m_size = 0;
+                other.m_stride = 0;
+            }
+
+        /// <summary>
+        /// assignment operator
+        /// </summary>
+        vector_array& operator=(const vector_array& rhs) {
+            if (this != &rhs) {
+                MATH_INSTRUMENT_EVENT(_T, copy, rhs.m_size * _Dim * sizeof(_T));
+                if (rhs.m_size > m_stride) {
+                    m_buffer = buffer<_T>(stride_for(rhs.m_size) * _Dim, resource());
+                    m_stride = stride_for(rhs.m_size);
+                }
+                m_size = rhs.m_size;
+                copy_components(rhs);
+            }
+            return *this;
+        }
+
+        /// <summary>
+        /// assignment operator
+        /// </summary>
+        vector_array& operator=(vector_array&& rhs) {
+            if (this != &rhs) {
+                m_buffer = std::move(rhs.m_buffer);
+                m_size = rhs.m_size;
+                m_stride = rhs.m_stride;
+                rhs.m_buffer = buffer<_T>(rhs.resource());
+                rhs.m_size = 0;
+                rhs.m_stride = 0;
+            }
+            return *this;
+        }
+
+        /// <summary>
+        /// number of vectors
+        /// </summary>
+        size_type size() const {
+            return m_size;
+        }
+
+        /// <summary>
+        /// is the array empty?
+        /// </summary>
+        bool empty() const {
+            return m_size == 0;
+        }
+
+        /// <summary>
+        /// number of vectors that fit into the allocated memory
+        /// </summary>
+        size_type capacity() const {
+            return m_stride;
+        }
+
+        /// <summary>
+        /// memory resource of the array
+        /// </summary>
+        memory_resource* resource() const {
+            return m_buffer.resource();
+        }
+
+        /// <summary>
+        /// reserve memory for at least 'n' vectors
+        /// </summary>
+        void reserve(size_type n) {
+            if (n > m_stride)
+                reallocate(stride_for(n));
+        }
+
+        /// <summary>
+        /// release the unused memory
+        /// </summary>
+        void shrink_to_fit() {
+            if (stride_for(m_size) < m_stride)
+                reallocate(stride_for(m_size));
+        }
+
+        /// <summary>
+        /// change the number of vectors, new vectors are zero
+        /// </summary>
+        void resize(size_type n) {
+            size_type s = m_size;
+            resize_uninitialized(n);
+            for (int d = 0; d < _Dim; ++d)
+                std::fill(data(d) + std::min(s, n), data(d) + n, _T(0));
+        }
+
+        /// <summary>
+        /// change the number of vectors, new vectors are not initialized
+        /// </summary>
+        void resize_uninitialized(size_type n) {
+            if (n > m_stride)
+                reallocate(std::max(stride_for(n), next_capacity(n)));
+            m_size = n;
+        }
+
+        /// <summary>
+        /// remove all vectors, the memory is kept
+        /// </summary>
+        void clear() {
+            m_size = 0;
+        }
+
+        /// <summary>
+        /// append a vector (anything with _Dim elements and operator[], e.g. a math::vector or an Eigen expression)
+        /// </summary>
+        template <class _Vec>
+        void push_back(const _Vec& vec) {
+#if defined(_DEBUG) || defined(DEBUG)
+            if (static_cast<size_type>(vec.size()) != _Dim)
+                std::cout << "Warning: vector_array::push_back: size of vector does not match the number of components." << std::endl;
+#endif
+            if (m_size == m_stride) {
+                // vec may refer to this array (e.g. arr.push_back(arr[i])), copy it before the memory is reallocated
+                element_type copy;
+                for (int d = 0; d < _Dim; ++d)
+                    copy[d] = vec[d];
+                reallocate(next_capacity(m_size + 1));
+                for (int d = 0; d < _Dim; ++d)
+                    data(d)[m_size] = copy[d];
+            }
+            else {
+                for (int d = 0; d < _Dim; ++d)
+                    data(d)[m_size] = vec[d];
+            }
+            m_size++;
+        }
+
+        /// <summary>
+        /// append a vector by initializer list
+        /// </summary>
+        void push_back(std::initializer_list<_T> vec) {
+            eigen_assert(vec.size() == _Dim);
+            push_back(element_type(vec));
+        }
+
+        /// <summary>
+        /// remove the last vector
+        /// </summary>
+        void pop_back() {
+            eigen_assert(!empty());
+            m_size--;
+        }
+
+        /// <summary>
+        /// element proxy, reads and writes the components in place
+        /// </summary>
+        reference operator[](const size_type i) {
+            eigen_assert(i < m_size);
+            return reference(data(0) + i, Eigen::InnerStride<>(static_cast<Eigen::Index>(m_stride)));
+        }
+
+        /// <summary>
+        /// element proxy, reads the components in place
+        /// </summary>
+        const_reference operator[](const size_type i) const {
+            eigen_assert(i < m_size);
+            return const_reference(data(0) + i, Eigen::InnerStride<>(static_cast<Eigen::Index>(m_stride)));
+        }
+
+        /// <summary>
+        /// component 'd' of all vectors (contiguous)
+        /// </summary>
+        component_type component(const int d) {
+            return component_type(data(d), static_cast<Eigen::Index>(m_size));
+        }
+
+        /// <summary>
+        /// component 'd' of all vectors (contiguous)
+        /// </summary>
+        const_component_type component(const int d) const {
+            return const_component_type(data(d), static_cast<Eigen::Index>(m_size));
+        }
+
+        /// <summary>
+        /// all vectors as the columns of a _Dim x size() Eigen matrix (the rows are the components)
+        /// </summary>
+        components_type components() {
+            return components_type(m_buffer.data(), _Dim, static_cast<Eigen::Index>(m_size), Eigen::OuterStride<>(static_cast<Eigen::Index>(m_stride)));
+        }
+
+        /// <summary>
+        /// all vectors as the columns of a _Dim x size() Eigen matrix (the rows are the components)
+        /// </summary>
+        const_components_type components() const {
+            return const_components_type(m_buffer.data(), _Dim, static_cast<Eigen::Index>(m_size), Eigen::OuterStride<>(static_cast<Eigen::Index>(m_stride)));
+        }
+
+        /// <summary>
+        /// contiguous elements of component 'd'
+        /// </summary>
+        value_type* data(const int d) {
+            eigen_assert(d >= 0 && d < _Dim);
+            return m_buffer.data() + d * m_stride;
+        }
+
+        /// <summary>
+        /// contiguous elements of component 'd'
+        /// </summary>
+        const value_type* data(const int d) const {
+            eigen_assert(d >= 0 && d < _Dim);
+            return m_buffer.data() + d * m_stride;
+        }
+
+        /// <summary>
+        /// the vectors as a size() x _Dim matrix, one vector per row
+        /// </summary>
+        matrix<_T> to_matrix() const {
+            return matrix<_T>(components().transpose());
+        }
+
+        void swap(vector_array& other) noexcept {
+            m_buffer.swap(other.m_buffer);
+            std::swap(m_size, other.m_size);
+            std::swap(m_stride, other.m_stride);
+        }
+
+    private:
+        /// <summary>
+        /// elements per component for at least 'n' vectors, the components start at offsets that are
+        /// multiples of 64 bytes from the start of the buffer (which is aligned to EIGEN_MAX_ALIGN_BYTES)
+        /// </summary>
+        static size_type stride_for(size_type n) {
+            const size_type line = std::max<size_type>(1, 64 / sizeof(_T));
+            return (n + line - 1) / line * line;
+        }
+
+        /// <summary>
+        /// capacity after growing geometrically, such that at least 'required' vectors fit
+        /// </summary>
+        size_type next_capacity(size_type required) const {
+            size_type newCapacity = static_cast<size_type>(m_stride * MATH_VECTOR_GROWTH_FACTOR);
+            return stride_for(std::max(newCapacity, required));
+        }
+
+        /// <summary>
+        /// move the components into memory with 'stride' elements per component
+        /// </summary>
+        void reallocate(size_type stride) {
+            if (m_buffer.capacity() > 0)
+                MATH_INSTRUMENT_EVENT(_T, reallocation, m_size * _Dim * sizeof(_T));
+            buffer<_T> b(stride * _Dim, resource());
+            for (int d = 0; d < _Dim; ++d)
+                std::copy(data(d), data(d) + m_size, b.data() + d * stride);
+            m_buffer.swap(b);
+            m_stride = stride;
+        }
+
+        void copy_components(const vector_array& other) {
+            for (int d = 0; d < _Dim; ++d)
+                std::copy(other.data(d), other.data(d) + m_size, data(d));
+        }
+
+        template <class _Points>
+        void assign_points(const _Points& points) {
+            reserve(points.size());
+            for (const auto& p : points) {
+                eigen_assert(static_cast<size_type>(p.size()) == _Dim && "math::vector_array: every vector must have _Dim elements");
+                for (int d = 0; d < _Dim; ++d)
+                    data(d)[m_size] = p[d];
+                m_size++;
+            }
+        }
+
+        /// <summary>
+        /// private/underlying data structure
+        /// component d of vector i is stored at m_buffer.data()[d * m_stride + i]
+        /// </summary>
+        buffer<_T> m_buffer;
+        size_type m_size;
+        size_type m_stride;
+    };
+
+    namespace detail {
+        /// <summary>
+        /// call fn(first, length) for consecutive blocks of MATH_ARRAY_BLOCK_SIZE elements covering [0, n)
+        /// </summary>
+        template <class _Fn>
+        inline void for_each_block(size_t n, _Fn&& fn) {
+            for (size_t first = 0; first < n; first += MATH_ARRAY_BLOCK_SIZE)
+                fn(first, std::min<size_t>(MATH_ARRAY_BLOCK_SIZE, n - first));
+        }
+    }
+
+    namespace eigen {
+        /// <summary>
+        /// euclidean norms of all vectors of 'src' into 'dst' without allocating, if 'dst' has the right size (or enough capacity)
+        /// </summary>
+        template <class _T, int _Dim>
+        inline void norm_into(vector<_T>& dst, const vector_array<_T, _Dim>& src) {
+            detail::fit(dst, src.size());
+            detail::for_each_block(src.size(), [&](size_t first, size_t length) {
+                auto out = dst.eigen().segment(first, length).array();
+                out = src.component(0).segment(first, length).array().square();
+                for (int d = 1; d < _Dim; ++d)
+                    out += src.component(d).segment(first, length).array().square();
+                out = out.sqrt();
+            });
+        }
+
+        /// <summary>
+        /// euclidean norms of all vectors
+        /// </summary>
+        template <class _T, int _Dim>
+        inline vector<_T> norm(const vector_array<_T, _Dim>& src) {
+            vector<_T> result(src.size(), uninitialized);
+            norm_into(result, src);
+            return result;
+        }
+
+        /// <summary>
+        /// dot products of the vectors a[i] * b[i] into 'dst' without allocating, if 'dst' has the right size (or enough capacity)
+        /// </summary>
+        template <class _T, int _Dim>
+        inline void dot_into(vector<_T>& dst, const vector_array<_T, _Dim>& a, const vector_array<_T, _Dim>& b) {
+            eigen_assert(a.size() == b.size());
+            detail::fit(dst, a.size());
+            detail::for_each_block(a.size(), [&](size_t first, size_t length) {
+                auto out = dst.eigen().segment(first, length).array();
+                out = a.component(0).segment(first, length).array() * b.component(0).segment(first, length).array();
+                for (int d = 1; d < _Dim; ++d)
+                    out += a.component(d).segment(first, length).array() * b.component(d).segment(first, length).array();
+            });
+        }
+
+        /// <summary>
+        /// dot products of the vectors a[i] * b[i]
+        /// </summary>
+        template <class _T, int _Dim>
+        inline vector<_T> dot(const vector_array<_T, _Dim>& a, const vector_array<_T, _Dim>& b) {
+            vector<_T> result(a.size(), uninitialized);
+            dot_into(result, a, b);
+            return result;
+        }
+
+        /// <summary>
+        /// normalize all vectors, zero vectors are left unchanged
+        /// </summary>
+        template <class _T, int _Dim>
+        inline void normalize(vector_array<_T, _Dim>& arr) {
+            Eigen::Array<_T, MATH_ARRAY_BLOCK_SIZE, 1> scale;
+            detail::for_each_block(arr.size(), [&](size_t first, size_t length) {
+                auto s = scale.head(length);
+                s = arr.component(0).segment(first, length).array().square();
+                for (int d = 1; d < _Dim; ++d)
+                    s += arr.component(d).segment(first, length).array().square();
+                s = (s > _T(0)).select(s.rsqrt(), _T(1));
+                for (int d = 0; d < _Dim; ++d)
+                    arr.component(d).segment(first, length).array() *= s;
+            });
+        }
+
+        /// <summary>
+        /// affine transformation dst[i] = linear * src[i] + translation without allocating, if 'dst' has enough capacity
+        /// 'dst' may be 'src'.
+        /// </summary>
+        template <class _T, int _Dim, int _R, int _C, int _L>
+        inline void transform_into(vector_array<_T, _Dim>& dst, const vector_array<_T, _Dim>& src, const matrix<_T, _R, _C, _L>& linear, const vector<_T, _Dim>& translation) {
+            if (linear.rows() != _Dim || linear.cols() != _Dim)
+                throw std::invalid_argument("transform_into: the matrix must have _Dim rows and columns");
+            const Eigen::Matrix<_T, _Dim, _Dim> m = linear.eigen();
+            if (&dst != &src)
+                dst.resize_uninitialized(src.size());
+            // the block of all components is computed before it is written, therefore dst may alias src
+            Eigen::Matrix<_T, _Dim, MATH_ARRAY_BLOCK_SIZE, Eigen::RowMajor> block;
+            detail::for_each_block(src.size(), [&](size_t first, size_t length) {
+                for (int r = 0; r < _Dim; ++r) {
+                    auto out = block.row(r).head(length).array();
+                    out.setConstant(translation[r]);
+                    for (int c = 0; c < _Dim; ++c)
+                        out += m(r, c) * src.component(c).segment(first, length).transpose().array();
+                }
+                for (int r = 0; r < _Dim; ++r)
+                    dst.component(r).segment(first, length) = block.row(r).head(length).transpose();
+            });
+        }
+
+        /// <summary>
+        /// linear transformation dst[i] = linear * src[i] without allocating, if 'dst' has enough capacity
+        /// </summary>
+        template <class _T, int _Dim, int _R, int _C, int _L>
+        inline void transform_into(vector_array<_T, _Dim>& dst, const vector_array<_T, _Dim>& src, const matrix<_T, _R, _C, _L>& linear) {
+            transform_into(dst, src, linear, vector<_T, _Dim>());
+        }
+
+        /// <summary>
+        /// transform all vectors in place by 'pose':
+        /// _Dim x _Dim: linear transformation
+        /// _Dim x (_Dim + 1) or (_Dim + 1) x (_Dim + 1): affine transformation in homogeneous coordinates, the last
+        /// column is the translation (the last row of a square matrix is ignored)
+        /// Throws std::invalid_argument for other shapes.
+        /// </summary>
+        template <class _T, int _Dim, int _R, int _C, int _L>
+        inline void transform(vector_array<_T, _Dim>& arr, const matrix<_T, _R, _C, _L>& pose) {
+            const size_t rows = pose.rows();
+            const size_t cols = pose.cols();
+            if (rows == _Dim && cols == _Dim) {
+                transform_into(arr, arr, pose);
+                return;
+            }
+            if ((rows != _Dim && rows != _Dim + 1) || cols != _Dim + 1)
+                throw std::invalid_argument("transform: the matrix must be _Dim x _Dim, _Dim x (_Dim + 1) or (_Dim + 1) x (_Dim + 1)");
+            matrix<_T, _Dim, _Dim> linear(pose.eigen().template topLeftCorner<_Dim, _Dim>());
+            vector<_T, _Dim> translation(pose.eigen().col(_Dim).template head<_Dim>());
+            transform_into(arr, arr, linear, translation);
+        }
+    }
+}
\ No newline at end of file
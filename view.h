@@ -0,0 +1,567 @@
+/*
+ *  view.h
+ *  Created by Matthias Kesenheimer on 19.06.22.
+ *  Copyright 2022. All rights reserved.
+ *  More information about the Eigen library at http://eigen.tuxfamily.org/dox/index.html
+ */
+
+#pragma once
+#include "vector.h"
+#include "matrix.h"
+#include <Eigen/Dense>
+#include <type_traits>
+#include <iterator>
+#include <vector>
+#include <cstddef>
+
+namespace math {
+    namespace detail {
+        /// <summary>
+        /// Eigen type a view maps, const if the view is read-only (_T = const value_type)
+        /// </summary>
+        template <class _T, int _Rows, int _Cols, int _Options>
+        using view_eigen_type = typename std::conditional<std::is_const<_T>::value,
+            const Eigen::Matrix<typename std::remove_const<_T>::type, _Rows, _Cols, _Options>,
+            Eigen::Matrix<_T, _Rows, _Cols, _Options>>::type;
+
+        /// <summary>
+        /// construct an Eigen stride object from run-time outer and inner strides,
+        /// strides which are fixed at compile-time are ignored
+        /// </summary>
+        template <class _Stride>
+        struct stride_maker;
+
+        template <int _Outer, int _Inner>
+        struct stride_maker<Eigen::Stride<_Outer, _Inner>> {
+            static Eigen::Stride<_Outer, _Inner> make(Eigen::Index outer, Eigen::Index inner) {
+                return Eigen::Stride<_Outer, _Inner>(_Outer == Eigen::Dynamic ? outer : _Outer, _Inner == Eigen::Dynamic ? inner : _Inner);
+            }
+        };
+
+        template <int _Inner>
+        struct stride_maker<Eigen::InnerStride<_Inner>> {
+            static Eigen::InnerStride<_Inner> make(Eigen::Index, Eigen::Index inner) {
+                return Eigen::InnerStride<_Inner>(_Inner == Eigen::Dynamic ? inner : _Inner);
+            }
+        };
+
+        template <int _Outer>
+        struct stride_maker<Eigen::OuterStride<_Outer>> {
+            static Eigen::OuterStride<_Outer> make(Eigen::Index outer, Eigen::Index) {
+                return Eigen::OuterStride<_Outer>(_Outer == Eigen::Dynamic ? outer : _Outer);
+            }
+        };
+
+        template <class _Stride>
+        inline _Stride make_stride(Eigen::Index outer, Eigen::Index inner) {
+            return stride_maker<_Stride>::make(outer, inner);
+        }
+
+        /// <summary>
+        /// random access iterator over the elements of a (strided) row-major matrix view, row by row
+        /// </summary>
+        template <class _T>
+        class strided_iterator {
+        public:
+            using iterator_category = std::random_access_iterator_tag;
+            using value_type = typename std::remove_const<_T>::type;
+            using difference_type = std::ptrdiff_t;
+            using pointer = _T*;
+            using reference = _T&;
+
+            strided_iterator()
+                : m_data(nullptr), m_index(0), m_cols(1), m_outer(0), m_inner(0) {}
+
+            strided_iterator(pointer data, difference_type index, difference_type cols, difference_type outer, difference_type inner)
+                : m_data(data), m_index(index), m_cols(cols > 0 ? cols : 1), m_outer(outer), m_inner(inner) {}
+
+            /// <summary>
+            /// conversion to a const iterator
+            /// </summary>
+            operator strided_iterator<const value_type>() const {
+                return strided_iterator<const value_type>(m_data, m_index, m_cols, m_outer, m_inner);
+            }
+
+            reference operator*() const {
+                return m_data[(m_index / m_cols) * m_outer + (m_index % m_cols) * m_inner];
+            }
+
+            pointer operator->() const {
+                return &**this;
+            }
+
+            reference operator[](difference_type n) const {
+                return *(*this + n);
+            }
+
+            strided_iterator& operator++() {
+                ++m_index;
+                return *this;
+            }
+
+            strided_iterator operator++(int) {
+                strided_iterator tmp = *this;
+                ++m_index;
+                return tmp;
+            }
+
+            strided_iterator& operator--() {
+                --m_index;
+                return *this;
+            }
+
+            strided_iterator operator--(int) {
+                strided_iterator tmp = *this;
+                --m_index;
+                return tmp;
+            }
+
+            strided_iterator& operator+=(difference_type n) {
+                m_index += n;
+                return *this;
+            }
+
+            strided_iterator& operator-=(difference_type n) {
+                m_index -= n;
+                return *this;
+            }
+
+            friend strided_iterator operator+(strided_iterator it, difference_type n) {
+                return it += n;
+            }
+
+            friend strided_iterator operator+(difference_type n, strided_iterator it) {
+                return it += n;
+            }
+
+            friend strided_iterator operator-(strided_iterator it, difference_type n) {
+                return it -= n;
+            }
+
+            friend difference_type operator-(const strided_iterator& lhs, const strided_iterator& rhs) {
+                return lhs.m_index - rhs.m_index;
+            }
+
+            friend bool operator==(const strided_iterator& lhs, const strided_iterator& rhs) {
+                return lhs.m_index == rhs.m_index;
+            }
+
+            friend bool operator!=(const strided_iterator& lhs, const strided_iterator& rhs) {
+                return lhs.m_index != rhs.m_index;
+            }
+
+            friend bool operator<(const strided_iterator& lhs, const strided_iterator& rhs) {
+                return lhs.m_index < rhs.m_index;
+            }
+
+            friend bool operator>(const strided_iterator& lhs, const strided_iterator& rhs) {
+                return lhs.m_index > rhs.m_index;
+            }
+
+            friend bool operator<=(const strided_iterator& lhs, const strided_iterator& rhs) {
+                return lhs.m_index <= rhs.m_index;
+            }
+
+            friend bool operator>=(const strided_iterator& lhs, const strided_iterator& rhs) {
+                return lhs.m_index >= rhs.m_index;
+            }
+
+        private:
+            pointer m_data;
+            difference_type m_index;
+            difference_type m_cols;
+            difference_type m_outer;
+            difference_type m_inner;
+        };
+    }
+
+    /// <summary>
+    /// non-owning vector view
+    /// Maps memory owned by someone else (e.g. a network buffer or a shared memory segment) without copying it.
+    /// The view is an Eigen::Map and can be used in Eigen expressions and with all operators of operators.h.
+    /// _T = const value_type: read-only view
+    /// _Stride: Eigen::Stride<0, 0> (default, contiguous), Eigen::InnerStride<> (run-time stride) or Eigen::InnerStride<N>
+    /// Note: assigning to a view writes into the mapped memory, the view cannot be resized.
+    /// </summary>
+    template <class _T, class _Stride = Eigen::Stride<0, 0>>
+    class vector_view : public Eigen::Map<detail::view_eigen_type<_T, Eigen::Dynamic, 1, Eigen::ColMajor>, Eigen::Unaligned, _Stride> {
+    public:
+        /// <summary>
+        /// typedefs
+        /// </summary>
+        using base_type = Eigen::Map<detail::view_eigen_type<_T, Eigen::Dynamic, 1, Eigen::ColMajor>, Eigen::Unaligned, _Stride>;
+        using value_type = typename std::remove_const<_T>::type;
+        using eigen_type = Eigen::Matrix<value_type, Eigen::Dynamic, 1>;
+        using stride_type = _Stride;
+        using size_type = size_t;
+        using pointer = _T*;
+        using reference = _T&;
+        using const_reference = const value_type&;
+        using iterator = typename base_type::iterator;
+        using const_iterator = typename base_type::const_iterator;
+        using reverse_iterator = typename std::reverse_iterator<iterator>;
+        using const_reverse_iterator = typename std::reverse_iterator<const_iterator>;
+
+        /// <summary>
+        /// view 'size' elements starting at 'data', the elements are 'stride' apart
+        /// </summary>
+        vector_view(pointer data, size_type size, const stride_type& stride = stride_type())
+            : base_type(data, size, stride) {}
+
+        /// <summary>
+        /// view the elements of a vector
+        /// </summary>
+        template <int _N>
+        vector_view(vector<value_type, _N>& vec)
+            : base_type(vec.data(), vec.size(), detail::make_stride<stride_type>(0, 1)) {}
+
+        /// <summary>
+        /// view the elements of a vector (read-only views only)
+        /// </summary>
+        template <int _N>
+        vector_view(const vector<value_type, _N>& vec)
+            : base_type(vec.data(), vec.size(), detail::make_stride<stride_type>(0, 1)) {}
+
+        /// <summary>
+        /// view the elements of an std::vector
+        /// </summary>
+        vector_view(std::vector<value_type>& vec)
+            : base_type(vec.data(), vec.size(), detail::make_stride<stride_type>(0, 1)) {}
+
+        /// <summary>
+        /// view the elements of an std::vector (read-only views only)
+        /// </summary>
+        vector_view(const std::vector<value_type>& vec)
+            : base_type(vec.data(), vec.size(), detail::make_stride<stride_type>(0, 1)) {}
+
+        /// <summary>
+        /// copy constructor, the copy views the same memory
+        /// </summary>
+        vector_view(const vector_view& other) = default;
+
+        /// <summary>
+        /// copy the elements of 'rhs' into the viewed memory
+        /// </summary>
+        vector_view& operator=(const vector_view& rhs) {
+            base_type::operator=(rhs);
+            return *this;
+        }
+
+        /// <summary>
+        /// copy the elements of 'rhs' into the viewed memory
+        /// </summary>
+        template <int _N>
+        vector_view& operator=(const vector<value_type, _N>& rhs) {
+            base_type::operator=(rhs.eigen());
+            return *this;
+        }
+
+        /// <summary>
+        /// evaluate an Eigen expression into the viewed memory
+        /// </summary>
+        template <class _Derived>
+        vector_view& operator=(const Eigen::MatrixBase<_Derived>& expr) {
+            base_type::operator=(expr);
+            return *this;
+        }
+
+        /// <summary>
+        /// returns the underlying data structure
+        /// </summary>
+        base_type& eigen() {
+            return *this;
+        }
+
+        /// <summary>
+        /// returns the underlying data structure
+        /// </summary>
+        const base_type& eigen() const {
+            return *this;
+        }
+
+        /// <summary>
+        /// rbegin of data container
+        /// returns a const iterator
+        /// </summary>
+        const_reverse_iterator rbegin() const {
+            return std::reverse_iterator(this->cend());
+        }
+
+        /// <summary>
+        /// rbegin of data container
+        /// returns an iterator
+        /// </summary>
+        reverse_iterator rbegin() {
+            return std::reverse_iterator(this->end());
+        }
+
+        /// <summary>
+        /// rend of data container
+        /// returns a const iterator
+        /// </summary>
+        const_reverse_iterator rend() const {
+            return std::reverse_iterator(this->cbegin());
+        }
+
+        /// <summary>
+        /// rend of data container
+        /// returns an iterator
+        /// </summary>
+        reverse_iterator rend() {
+            return std::reverse_iterator(this->begin());
+        }
+
+        /// <summary>
+        /// is the view empty?
+        /// </summary>
+        bool empty() const {
+            return this->size() == 0;
+        }
+
+        /// <summary>
+        /// access element
+        /// </summary>
+        reference at(const size_type i) {
+            eigen_assert(i < static_cast<size_type>(this->size()));
+            return this->data()[i * this->innerStride()];
+        }
+
+        /// <summary>
+        /// access element
+        /// </summary>
+        const_reference at(const size_type i) const {
+            eigen_assert(i < static_cast<size_type>(this->size()));
+            return this->data()[i * this->innerStride()];
+        }
+
+        /// <summary>
+        /// access first element
+        /// </summary>
+        reference front() {
+            return at(0);
+        }
+
+        /// <summary>
+        /// access first element
+        /// </summary>
+        const_reference front() const {
+            return at(0);
+        }
+
+        /// <summary>
+        /// access last element
+        /// </summary>
+        reference back() {
+            return at(this->size() - 1);
+        }
+
+        /// <summary>
+        /// access last element
+        /// </summary>
+        const_reference back() const {
+            return at(this->size() - 1);
+        }
+    };
+
+    /// <summary>
+    /// non-owning matrix view (row-major, like math::matrix)
+    /// Maps memory owned by someone else without copying it.
+    /// The view is an Eigen::Map and can be used in Eigen expressions and with all operators of operators.h.
+    /// _T = const value_type: read-only view
+    /// _Stride: Eigen::Stride<0, 0> (default, contiguous), Eigen::OuterStride<> (padded rows) or Eigen::Stride<Eigen::Dynamic, Eigen::Dynamic>
+    /// Note: the iterators run row by row over all elements.
+    /// </summary>
+    template <class _T, class _Stride = Eigen::Stride<0, 0>>
+    class matrix_view : public Eigen::Map<detail::view_eigen_type<_T, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>, Eigen::Unaligned, _Stride> {
+    private:
+        using row_stride_type = typename std::conditional<(_Stride::InnerStrideAtCompileTime == 0 || _Stride::InnerStrideAtCompileTime == 1),
+            Eigen::Stride<0, 0>, Eigen::InnerStride<_Stride::InnerStrideAtCompileTime>>::type;
+
+    public:
+        /// <summary>
+        /// typedefs
+        /// </summary>
+        using base_type = Eigen::Map<detail::view_eigen_type<_T, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>, Eigen::Unaligned, _Stride>;
+        using value_type = typename std::remove_const<_T>::type;
+        using eigen_type = Eigen::Matrix<value_type, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+        using vector_view_type = vector_view<_T, row_stride_type>;
+        using const_vector_view_type = vector_view<const value_type, row_stride_type>;
+        using stride_type = _Stride;
+        using size_type = size_t;
+        using pointer = _T*;
+        using reference = _T&;
+        using const_reference = const value_type&;
+        using iterator = detail::strided_iterator<_T>;
+        using const_iterator = detail::strided_iterator<const value_type>;
+        using reverse_iterator = typename std::reverse_iterator<iterator>;
+        using const_reverse_iterator = typename std::reverse_iterator<const_iterator>;
+
+        /// <summary>
+        /// view a 'rows'x'cols' matrix starting at 'data', stored row by row
+        /// </summary>
+        matrix_view(pointer data, size_type r, size_type c, const stride_type& stride = stride_type())
+            : base_type(data, r, c, stride) {}
+
+        /// <summary>
+        /// view the elements of a matrix
+        /// </summary>
+        template <int _R, int _C>
+        matrix_view(matrix<value_type, _R, _C>& mat)
+            : base_type(mat.data(), mat.rows(), mat.cols(), detail::make_stride<stride_type>(mat.cols(), 1)) {}
+
+        /// <summary>
+        /// view the elements of a matrix (read-only views only)
+        /// </summary>
+        template <int _R, int _C>
+        matrix_view(const matrix<value_type, _R, _C>& mat)
+            : base_type(mat.data(), mat.rows(), mat.cols(), detail::make_stride<stride_type>(mat.cols(), 1)) {}
+
+        /// <summary>
+        /// copy constructor, the copy views the same memory
+        /// </summary>
+        matrix_view(const matrix_view& other) = default;
+
+        /// <summary>
+        /// copy the elements of 'rhs' into the viewed memory
+        /// </summary>
+        matrix_view& operator=(const matrix_view& rhs) {
+            base_type::operator=(rhs);
+            return *this;
+        }
+
+        /// <summary>
+        /// copy the elements of 'rhs' into the viewed memory
+        /// </summary>
+        template <int _R, int _C>
+        matrix_view& operator=(const matrix<value_type, _R, _C>& rhs) {
+            base_type::operator=(rhs.eigen());
+            return *this;
+        }
+
+        /// <summary>
+        /// evaluate an Eigen expression into the viewed memory
+        /// </summary>
+        template <class _Derived>
+        matrix_view& operator=(const Eigen::MatrixBase<_Derived>& expr) {
+            base_type::operator=(expr);
+            return *this;
+        }
+
+        /// <summary>
+        /// returns the underlying data structure
+        /// </summary>
+        base_type& eigen() {
+            return *this;
+        }
+
+        /// <summary>
+        /// returns the underlying data structure
+        /// </summary>
+        const base_type& eigen() const {
+            return *this;
+        }
+
+        /// <summary>
+        /// begin of data container
+        /// returns a const iterator
+        /// </summary>
+        const_iterator begin() const {
+            return const_iterator(this->data(), 0, this->cols(), this->outerStride(), this->innerStride());
+        }
+
+        /// <summary>
+        /// begin of data container
+        /// returns an iterator
+        /// </summary>
+        iterator begin() {
+            return iterator(this->data(), 0, this->cols(), this->outerStride(), this->innerStride());
+        }
+
+        /// <summary>
+        /// end of data container
+        /// returns a const iterator
+        /// </summary>
+        const_iterator end() const {
+            return const_iterator(this->data(), this->size(), this->cols(), this->outerStride(), this->innerStride());
+        }
+
+        /// <summary>
+        /// end of data container
+        /// returns an iterator
+        /// </summary>
+        iterator end() {
+            return iterator(this->data(), this->size(), this->cols(), this->outerStride(), this->innerStride());
+        }
+
+        /// <summary>
+        /// rbegin of data container
+        /// returns a const iterator
+        /// </summary>
+        const_reverse_iterator rbegin() const {
+            return std::reverse_iterator(end());
+        }
+
+        /// <summary>
+        /// rbegin of data container
+        /// returns an iterator
+        /// </summary>
+        reverse_iterator rbegin() {
+            return std::reverse_iterator(end());
+        }
+
+        /// <summary>
+        /// rend of data container
+        /// returns a const iterator
+        /// </summary>
+        const_reverse_iterator rend() const {
+            return std::reverse_iterator(begin());
+        }
+
+        /// <summary>
+        /// rend of data container
+        /// returns an iterator
+        /// </summary>
+        reverse_iterator rend() {
+            return std::reverse_iterator(begin());
+        }
+
+        /// <summary>
+        /// is the view empty?
+        /// </summary>
+        bool empty() const {
+            return this->size() == 0;
+        }
+
+        /// <summary>
+        /// access element
+        /// </summary>
+        reference at(const size_type r, const size_type c) {
+            eigen_assert(r < static_cast<size_type>(this->rows()) && c < static_cast<size_type>(this->cols()));
+            return this->data()[r * this->outerStride() + c * this->innerStride()];
+        }
+
+        /// <summary>
+        /// access element
+        /// </summary>
+        const_reference at(const size_type r, const size_type c) const {
+            eigen_assert(r < static_cast<size_type>(this->rows()) && c < static_cast<size_type>(this->cols()));
+            return this->data()[r * this->outerStride() + c * this->innerStride()];
+        }
+
+        /// <summary>
+        /// access row
+        /// </summary>
+        vector_view_type operator[](const size_type r) {
+            eigen_assert(r < static_cast<size_type>(this->rows()));
+            return vector_view_type(this->data() + r * this->outerStride(), this->cols(), detail::make_stride<row_stride_type>(0, this->innerStride()));
+        }
+
+        /// <summary>
+        /// access row
+        /// </summary>
+        const_vector_view_type operator[](const size_type r) const {
+            eigen_assert(r < static_cast<size_type>(this->rows()));
+            return const_vector_view_type(this->data() + r * this->outerStride(), this->cols(), detail::make_stride<row_stride_type>(0, this->innerStride()));
+        }
+    };
+}
\ No newline at end of file